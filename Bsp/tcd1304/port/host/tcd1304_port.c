@@ -0,0 +1,790 @@
+/**
+ *******************************************************************************
+ * @file    : tcd1304_port.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host simulation of the portable layer of the TCD1304 driver
+ *
+ * A simulation thread plays the role of the timers, the ADC+DMA and the
+ * interrupt controller. It advances a virtual clock from frame to frame. In
+ * real time mode it sleeps until the wall clock has caught up with the virtual
+ * clock; otherwise it runs up to TCD_HOST_CONFIG_t.speed times faster, or as
+ * fast as the host allows when speed is 0.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "tcd1304_port.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    uint32_t f_master;
+    uint32_t t_int_us;
+    uint32_t t_icg_us;
+    uint32_t f_adc;
+} PORT_TIMER_CONF_t;
+
+typedef struct
+{
+    /* Emulated ADC+DMA */
+    uint16_t *dmaBuffer[ 2 ];
+    uint32_t doubleBuffer;
+    uint32_t currentTarget;         /* DMA memory being written, like CT      */
+    uint32_t completedBuffer;
+
+    /* Emulated PendSV */
+    volatile uint32_t deferredPending;
+
+    /* Emulated ICG interrupt, enabled while icgRequests != icgServed */
+    uint32_t icgRequests;
+    uint32_t icgServed;
+
+    /* Virtual clock */
+    uint64_t virtualNs;
+    uint64_t framesGenerated;
+
+    /* Simulation thread */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;          /* Uses CLOCK_MONOTONIC                   */
+    uint32_t initialized;
+    volatile uint32_t running;
+} PORT_HOST_SIM_t;
+
+/* Private define ------------------------------------------------------------*/
+#define NS_PER_US                       (1000ULL)
+#define NS_PER_S                        (1000000000ULL)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static PORT_TIMER_CONF_t timer_conf;
+static uint32_t irq_cycles;
+static uint32_t irq_max_cycles;
+
+static TCD_HOST_CONFIG_t host_conf =
+{
+    .speed = 1U,
+    .spectrum = TCD_HOST_SPECTRUM_LINES,
+    .darkLevel = 3600U,
+    .amplitude = 3000U,
+    .refIntTimeUs = 3800U,
+    .noise = 8U,
+    .seed = 1U,
+};
+
+static PORT_HOST_SIM_t sim =
+{
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static float spectrum[ CFG_CCD_NUM_PIXELS ];
+static uint32_t spectrum_built;
+static uint32_t noise_state = 1U;
+
+/* Private function prototypes -----------------------------------------------*/
+static void *TCD_PORT_HOST_Thread(void *arg);
+static void TCD_PORT_HOST_BuildSpectrum(void);
+static void TCD_PORT_HOST_FillFrame(uint16_t *dataBuffer, uint32_t t_int_us);
+static uint32_t TCD_PORT_HOST_Random(void);
+static uint64_t TCD_PORT_HOST_MonotonicNs(void);
+static void TCD_PORT_HOST_Interrupt(void);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @Brief   Start the virtual timers to generate frames
+ * @param   None
+ * @retval  None
+ *
+ * The first ICG pulse is one ICG period after the start, as on the hardware.
+ ******************************************************************************/
+void TCD_PORT_Run(void)
+{
+    TCD_PORT_Stop();
+
+    if ( sim.initialized == 0U )
+    {
+        pthread_condattr_t attr;
+
+        pthread_condattr_init( &attr );
+        pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+        pthread_cond_init( &sim.wakeup, &attr );
+        pthread_condattr_destroy( &attr );
+        sim.initialized = 1U;
+    }
+
+    if ( spectrum_built == 0U )
+    {
+        TCD_PORT_HOST_BuildSpectrum();
+    }
+
+    sim.running = 1U;
+    if ( pthread_create( &sim.thread, NULL, TCD_PORT_HOST_Thread, NULL ) != 0 )
+    {
+        sim.running = 0U;
+    }
+}
+
+/*******************************************************************************
+ * @Brief   Stop the virtual timers
+ * @param   None
+ * @retval  None
+ *
+ * A frame in progress is discarded. The virtual clock keeps its value.
+ ******************************************************************************/
+void TCD_PORT_Stop(void)
+{
+    if ( sim.running == 0U )
+    {
+        return;
+    }
+
+    pthread_mutex_lock( &sim.lock );
+    sim.running = 0U;
+    pthread_cond_broadcast( &sim.wakeup );
+    pthread_mutex_unlock( &sim.lock );
+
+    pthread_join( sim.thread, NULL );
+}
+
+/*******************************************************************************
+ * @brief   Configure the CCD master clock
+ * @param   freq, uint32_t: Clock frequency in Hz
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_FM_ConfigClock(const uint32_t freq)
+{
+    pthread_mutex_lock( &sim.lock );
+    timer_conf.f_master = freq;
+    pthread_mutex_unlock( &sim.lock );
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Configure the SH pulse generator
+ * @param   t_int_us, uint32_t: Integration time for the CCD in microseconds
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us)
+{
+    pthread_mutex_lock( &sim.lock );
+    timer_conf.t_int_us = t_int_us;
+    pthread_mutex_unlock( &sim.lock );
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Configure the ICG pulse generator
+ * @param   t_icg_us, uint32_t: Sensor readout period in microseconds
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
+{
+    pthread_mutex_lock( &sim.lock );
+    timer_conf.t_icg_us = t_icg_us;
+    pthread_mutex_unlock( &sim.lock );
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Find the timer settings for an ICG and an SH period
+ * @param   t_icg_us, uint32_t: Sensor readout period in microseconds
+ * @param   t_int_us, uint32_t: Integration time for the CCD in microseconds
+ * @param   timing, TCD_PORT_TIMING_t: Timer settings, the error is always 0
+ * @retval  0 on success, -1 if the periods can not be generated
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_SolveTiming(uint32_t t_icg_us, uint32_t t_int_us, TCD_PORT_TIMING_t *timing)
+{
+    if ( (timing == NULL) || (t_int_us == 0U) || ((t_icg_us % t_int_us) != 0U) )
+    {
+        return -1;
+    }
+
+    timing->prescaler = 1U;
+    timing->icgTicks = t_icg_us;
+    timing->shTicks = t_int_us;
+    timing->icgPulseTicks = CFG_ICG_DEFAULT_PULSE_US;
+    timing->shPulseTicks = CFG_SH_DEFAULT_PULSE_US;
+    timing->t_icg_err_ns = 0;
+    timing->t_int_err_ns = 0;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Set new ICG and SH periods from the next ICG pulse on
+ * @param   timing, TCD_PORT_TIMING_t: Settings from TCD_PORT_SolveTiming()
+ * @retval  None
+ *
+ * Called from TCD_IcgCallback(), which the simulation thread calls before
+ * an ICG pulse, or while the virtual timers are stopped.
+ ******************************************************************************/
+void TCD_PORT_SetTiming(const TCD_PORT_TIMING_t *timing)
+{
+    pthread_mutex_lock( &sim.lock );
+    timer_conf.t_icg_us = timing->icgTicks;
+    timer_conf.t_int_us = timing->shTicks;
+    pthread_mutex_unlock( &sim.lock );
+}
+
+/*******************************************************************************
+ * @brief   Enable the emulated ICG interrupt from the next ICG pulse on
+ * @param   None
+ * @retval  None
+ *
+ * The simulation thread calls TCD_IcgCallback() until it returns 0. A request
+ * made while the callback runs keeps the interrupt enabled, as the threads
+ * run concurrently here.
+ ******************************************************************************/
+void TCD_PORT_ICG_EnableInterrupt(void)
+{
+    pthread_mutex_lock( &sim.lock );
+    sim.icgRequests++;
+    pthread_mutex_unlock( &sim.lock );
+}
+
+/*******************************************************************************
+ * @brief   Get the emulated master clock frequency
+ * @param   None
+ * @retval  Frequency in Hz
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_FM_GetFrequency(void)
+{
+    return timer_conf.f_master;
+}
+
+/*******************************************************************************
+ * @brief   Initialize the emulated ADC+DMA
+ * @param   None
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_ADC_Init(void)
+{
+    TCD_PORT_Stop();
+
+    sim.dmaBuffer[ 0 ] = NULL;
+    sim.dmaBuffer[ 1 ] = NULL;
+    sim.doubleBuffer = 0U;
+    sim.currentTarget = 0U;
+    sim.deferredPending = 0U;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Configure the ADC trigger
+ * @param   f_adc, uint32_t: ADC sampling frequency
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_ConfigTrigger(uint32_t f_adc)
+{
+    pthread_mutex_lock( &sim.lock );
+    timer_conf.f_adc = f_adc;
+    pthread_mutex_unlock( &sim.lock );
+}
+
+/*******************************************************************************
+ * @brief   Start the emulated ADC+DMA in circular mode
+ * @param   dataBuffer, uint16_t: Buffer for CFG_CCD_NUM_PIXELS samples
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_ADC_Start(uint16_t *dataBuffer)
+{
+    sim.dmaBuffer[ 0 ] = dataBuffer;
+    sim.dmaBuffer[ 1 ] = dataBuffer;
+    sim.doubleBuffer = 0U;
+    sim.currentTarget = 0U;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Start the emulated ADC+DMA in double buffer mode
+ * @param   dataBuffer0, uint16_t: Buffer of DMA memory 0
+ * @param   dataBuffer1, uint16_t: Buffer of DMA memory 1
+ * @retval  Error code
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_ADC_StartDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1)
+{
+    sim.dmaBuffer[ 0 ] = dataBuffer0;
+    sim.dmaBuffer[ 1 ] = dataBuffer1;
+    sim.doubleBuffer = 1U;
+    sim.currentTarget = 0U;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Get the index of the buffer holding the completed readout
+ * @param   None
+ * @retval  0 for dataBuffer0 and 1 for dataBuffer1. Always 0 in single buffer mode.
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_ADC_GetCompletedBuffer(void)
+{
+    return sim.completedBuffer;
+}
+
+/*******************************************************************************
+ * @brief   Check for a readout not yet passed to TCD_ReadCompletedCallback()
+ * @param   None
+ * @retval  Always 0, the thread completes each readout before the next ICG
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_ADC_IsReadoutPending(void)
+{
+    return 0U;
+}
+
+/*******************************************************************************
+ * @brief   Set the data buffer of one of the DMA memories in double buffer mode
+ * @param   buffer, uint32_t: DMA memory index; 0 or 1
+ * @param   dataBuffer, uint16_t: New buffer for CFG_CCD_NUM_PIXELS samples
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_SetBuffer(uint32_t buffer, uint16_t *dataBuffer)
+{
+    sim.dmaBuffer[ buffer & 1U ] = dataBuffer;
+}
+
+/*******************************************************************************
+ * @brief   Request the deferred frame processing to run
+ * @param   None
+ * @retval  None
+ *
+ * The simulation thread runs the deferred processing when the emulated
+ * interrupt handler has returned, like a tail-chained PendSV.
+ ******************************************************************************/
+void TCD_PORT_RequestDeferredProcessing(void)
+{
+    sim.deferredPending = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Enable the cycle counter
+ * @param   None
+ * @retval  None
+ *
+ * Nothing to enable on the host.
+ ******************************************************************************/
+void TCD_PORT_CycleCounter_Init(void)
+{
+}
+
+/*******************************************************************************
+ * @brief   Get the cycle counter
+ * @param   None
+ * @retval  Monotonic host time in nanoseconds, wraps around at 2^32.
+ *
+ * On the host all "cycle" counts of the driver are in nanoseconds.
+ ******************************************************************************/
+uint32_t TCD_PORT_CycleCounter_Get(void)
+{
+    return (uint32_t) TCD_PORT_HOST_MonotonicNs();
+}
+
+/*******************************************************************************
+ * @brief   Get the duration of the emulated ADC+DMA interrupt handler
+ * @param   cycles, uint32_t: Last measurement in nanoseconds
+ * @param   maxCycles, uint32_t: Maximum measurement in nanoseconds
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_GetIrqCycles(uint32_t *cycles, uint32_t *maxCycles)
+{
+    *cycles = irq_cycles;
+    *maxCycles = irq_max_cycles;
+}
+
+/*******************************************************************************
+ * @brief   Reset the duration of the emulated ADC+DMA interrupt handler
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_ResetIrqCycles(void)
+{
+    irq_cycles = 0U;
+    irq_max_cycles = 0U;
+}
+
+/*******************************************************************************
+ * @brief   Configure the simulation
+ * @param   config, TCD_HOST_CONFIG_t: Speed and synthetic spectrum
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_HOST_Configure(const TCD_HOST_CONFIG_t *config)
+{
+    if ( config == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock( &sim.lock );
+    host_conf = *config;
+    noise_state = (config->seed != 0U) ? config->seed : 1U;
+    TCD_PORT_HOST_BuildSpectrum();
+    pthread_mutex_unlock( &sim.lock );
+}
+
+/*******************************************************************************
+ * @brief   Get the virtual clock
+ * @param   None
+ * @retval  Virtual time in microseconds
+ *
+ ******************************************************************************/
+uint64_t TCD_PORT_HOST_GetTimeUs(void)
+{
+    uint64_t t;
+
+    pthread_mutex_lock( &sim.lock );
+    t = sim.virtualNs / NS_PER_US;
+    pthread_mutex_unlock( &sim.lock );
+
+    return t;
+}
+
+/*******************************************************************************
+ * @brief   Get the number of frames generated by the emulated ADC+DMA
+ * @param   None
+ * @retval  Number of frames
+ *
+ ******************************************************************************/
+uint64_t TCD_PORT_HOST_GetFramesGenerated(void)
+{
+    uint64_t n;
+
+    pthread_mutex_lock( &sim.lock );
+    n = sim.framesGenerated;
+    pthread_mutex_unlock( &sim.lock );
+
+    return n;
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   The simulation thread
+ * @param   arg, void: Not used
+ * @retval  NULL
+ *
+ * Every ICG period one frame is read out. The readout starts at the end of
+ * the ICG pulse and takes CFG_CCD_NUM_PIXELS ADC samples at f_adc. The frame
+ * is written to the DMA buffer and the interrupt handler is called when the
+ * virtual clock reaches the end of the readout.
+ *
+ * Before an ICG pulse TCD_IcgCallback() is called as by the ICG interrupt
+ * of the hardware, while it is enabled. New periods apply from that pulse on, but the frame read
+ * out at it has the exposure of the SH period that ends there.
+ ******************************************************************************/
+static void *TCD_PORT_HOST_Thread(void *arg)
+{
+    uint64_t wallStart = TCD_PORT_HOST_MonotonicNs();
+    uint64_t virtualStart;
+    uint64_t icg;
+
+    (void) arg;
+
+    pthread_mutex_lock( &sim.lock );
+    virtualStart = sim.virtualNs;
+    icg = virtualStart;
+
+    while ( sim.running == 1U )
+    {
+        uint64_t period = (uint64_t) timer_conf.t_icg_us * NS_PER_US;
+        uint64_t readout = 0U;
+        uint64_t frameDone;
+        uint32_t exposure = timer_conf.t_int_us;
+        uint32_t speed = host_conf.speed;
+        uint32_t staged;
+
+        if ( timer_conf.f_adc > 0U )
+        {
+            readout = (uint64_t) CFG_CCD_NUM_PIXELS * NS_PER_S / timer_conf.f_adc;
+        }
+        if ( period == 0U )
+        {
+            period = (uint64_t) CFG_ICG_DEFAULT_PERIOD_US * NS_PER_US;
+        }
+
+        icg += period;
+        frameDone = icg + (uint64_t) CFG_ICG_DEFAULT_PULSE_US * NS_PER_US + readout;
+
+        if ( sim.icgRequests != sim.icgServed )
+        {
+            uint32_t requests = sim.icgRequests;
+
+            pthread_mutex_unlock( &sim.lock );
+            staged = TCD_IcgCallback();
+            pthread_mutex_lock( &sim.lock );
+
+            if ( staged == 0U )
+            {
+                sim.icgServed = requests;
+            }
+        }
+
+        /* Pace the virtual clock against the wall clock */
+        if ( speed > 0U )
+        {
+            uint64_t wake = wallStart + (frameDone - virtualStart) / speed;
+            struct timespec ts;
+
+            ts.tv_sec = (time_t) (wake / NS_PER_S);
+            ts.tv_nsec = (long) (wake % NS_PER_S);
+
+            while ( (sim.running == 1U) && (TCD_PORT_HOST_MonotonicNs() < wake) )
+            {
+                pthread_cond_timedwait( &sim.wakeup, &sim.lock, &ts );
+            }
+            if ( sim.running == 0U )
+            {
+                break;
+            }
+        }
+
+        sim.virtualNs = frameDone;
+        sim.framesGenerated++;
+
+        /* The DMA writes the frame and switches to the other memory */
+        if ( sim.dmaBuffer[ sim.currentTarget ] != NULL )
+        {
+            TCD_PORT_HOST_FillFrame( sim.dmaBuffer[ sim.currentTarget ], exposure );
+        }
+        sim.completedBuffer = sim.currentTarget;
+        if ( sim.doubleBuffer == 1U )
+        {
+            sim.currentTarget ^= 1U;
+        }
+
+        pthread_mutex_unlock( &sim.lock );
+        TCD_PORT_HOST_Interrupt();
+        pthread_mutex_lock( &sim.lock );
+    }
+
+    pthread_mutex_unlock( &sim.lock );
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * @brief   Emulate the ADC+DMA interrupt and the tail-chained PendSV
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+static void TCD_PORT_HOST_Interrupt(void)
+{
+    uint32_t start = TCD_PORT_CycleCounter_Get();
+
+    TCD_ReadCompletedCallback( TCD_PORT_ADC_GetCompletedBuffer() );
+
+    irq_cycles = TCD_PORT_CycleCounter_Get() - start;
+    if ( irq_cycles > irq_max_cycles )
+    {
+        irq_max_cycles = irq_cycles;
+    }
+
+    if ( sim.deferredPending == 1U )
+    {
+        sim.deferredPending = 0U;
+        TCD_ProcessCompletedFrames();
+    }
+
+    /* Make the results visible to the application thread */
+    __sync_synchronize();
+}
+
+/*******************************************************************************
+ * @brief   Calculate the normalized light level of every pixel
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+static void TCD_PORT_HOST_BuildSpectrum(void)
+{
+    /* Pixel position and width (sigma) of the emission lines */
+    static const float lines[][ 3 ] =
+    {
+        /* pixel, sigma, relative intensity */
+        {  420.0f,  4.0f, 0.35f },
+        {  910.0f,  3.0f, 1.00f },
+        { 1530.0f,  5.0f, 0.60f },
+        { 1980.0f,  3.0f, 0.85f },
+        { 2010.0f,  3.0f, 0.80f },
+        { 2890.0f,  8.0f, 0.25f },
+        { 3400.0f,  4.0f, 0.50f },
+    };
+    const uint32_t first = TCD_HOST_DUMMY_PIXELS_FRONT;
+    const uint32_t last = CFG_CCD_NUM_PIXELS - TCD_HOST_DUMMY_PIXELS_BACK;
+    uint32_t i;
+    uint32_t k;
+
+    for ( i = 0U; i < CFG_CCD_NUM_PIXELS; i++ )
+    {
+        float level = 0.0f;
+
+        if ( (i >= first) && (i < last) )
+        {
+            switch ( host_conf.spectrum )
+            {
+                case TCD_HOST_SPECTRUM_FLAT:
+                    level = 1.0f;
+                    break;
+
+                case TCD_HOST_SPECTRUM_RAMP:
+                    level = (float) (i - first + 1U) / (float) (last - first);
+                    break;
+
+                case TCD_HOST_SPECTRUM_LINES:
+                default:
+                    for ( k = 0U; k < sizeof(lines) / sizeof(lines[ 0 ]); k++ )
+                    {
+                        float d = ((float) i - lines[ k ][ 0 ]) / lines[ k ][ 1 ];
+                        level += lines[ k ][ 2 ] * expf( -0.5f * d * d );
+                    }
+                    break;
+            }
+        }
+
+        spectrum[ i ] = (level > 1.0f) ? 1.0f : level;
+    }
+
+    spectrum_built = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Write one synthetic readout to a DMA buffer
+ * @param   dataBuffer, uint16_t: Buffer for CFG_CCD_NUM_PIXELS samples
+ * @param   t_int_us, uint32_t: Integration time
+ * @retval  None
+ *
+ * The signal is proportional to the integration time and lowers the output
+ * from the dark level, saturating at 0.
+ ******************************************************************************/
+static void TCD_PORT_HOST_FillFrame(uint16_t *dataBuffer, uint32_t t_int_us)
+{
+    float gain = 0.0f;
+    int32_t halfNoise = host_conf.noise / 2;
+    uint32_t i;
+
+    if ( host_conf.refIntTimeUs > 0U )
+    {
+        gain = (float) host_conf.amplitude * (float) t_int_us / (float) host_conf.refIntTimeUs;
+    }
+
+    for ( i = 0U; i < CFG_CCD_NUM_PIXELS; i++ )
+    {
+        int32_t value = (int32_t) host_conf.darkLevel - (int32_t) (gain * spectrum[ i ]);
+
+        if ( host_conf.noise > 0U )
+        {
+            value += (int32_t) (TCD_PORT_HOST_Random() % (host_conf.noise + 1U)) - halfNoise;
+        }
+
+        if ( value < 0 )
+        {
+            value = 0;
+        }
+        else if ( value > (int32_t) TCD_HOST_ADC_MAX )
+        {
+            value = TCD_HOST_ADC_MAX;
+        }
+
+        dataBuffer[ i ] = (uint16_t) value;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Xorshift pseudo random number generator for the noise
+ * @param   None
+ * @retval  Random number
+ *
+ ******************************************************************************/
+static uint32_t TCD_PORT_HOST_Random(void)
+{
+    uint32_t x = noise_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    noise_state = x;
+
+    return x;
+}
+
+/*******************************************************************************
+ * @brief   Get the monotonic host time
+ * @param   None
+ * @retval  Time in nanoseconds
+ *
+ ******************************************************************************/
+static uint64_t TCD_PORT_HOST_MonotonicNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t) ts.tv_sec * NS_PER_S + (uint64_t) ts.tv_nsec;
+}
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,201 @@
+/**
+ *******************************************************************************
+ * @file    : tcd1304_port.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host simulation of the portable layer of the TCD1304 driver
+ *
+ * Runs the TCD1304 driver on a workstation. A virtual clock emulates the
+ * fM, SH and ICG timing, the ADC+DMA is replaced by synthetic spectra written
+ * into the DMA buffers, and the driver callbacks are called on the frame
+ * schedule of the real hardware.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef TCD1304_PORT_H_
+#define TCD1304_PORT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "tcd1304_conf.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    TCD_HOST_SPECTRUM_FLAT = 0,     /* Same light level on all pixels         */
+    TCD_HOST_SPECTRUM_RAMP,         /* Light level rising over the pixels     */
+    TCD_HOST_SPECTRUM_LINES         /* Gaussian emission lines                */
+} TCD_HOST_SPECTRUM_t;
+
+typedef struct
+{
+    uint32_t speed;                 /* 0 = as fast as possible, 1 = real time,
+                                       N = N times faster than real time      */
+    TCD_HOST_SPECTRUM_t spectrum;
+    uint16_t darkLevel;             /* ADC value of a dark pixel              */
+    uint16_t amplitude;             /* Peak signal at refIntTimeUs, ADC counts */
+    uint32_t refIntTimeUs;          /* Integration time of the amplitude      */
+    uint16_t noise;                 /* Peak-to-peak white noise, ADC counts   */
+    uint32_t seed;                  /* Seed of the noise generator            */
+} TCD_HOST_CONFIG_t;
+
+/**
+ * Timer settings for one pair of periods, see TCD_PORT_SolveTiming(). The
+ * emulated timers count microseconds, so every period is exact.
+ */
+typedef struct
+{
+    uint32_t prescaler;
+    uint32_t icgTicks;              /* ICG period in microseconds             */
+    uint32_t shTicks;               /* SH period in microseconds              */
+    uint32_t icgPulseTicks;
+    uint32_t shPulseTicks;
+    int32_t  t_icg_err_ns;          /* Achieved minus requested ICG period    */
+    int32_t  t_int_err_ns;          /* Achieved minus requested SH period     */
+} TCD_PORT_TIMING_t;
+
+/* Exported defines ----------------------------------------------------------*/
+
+/**
+ *******************************************************************************
+ *                         SENSOR DEFINITIONS
+ *******************************************************************************
+ *
+ * The TCD1304 outputs 32 dummy pixels before and 14 dummy pixels after the
+ * 3648 light sensitive pixels. The output voltage, and the ADC value, falls
+ * with the light level.
+ */
+#define TCD_HOST_DUMMY_PIXELS_FRONT         (32U)
+#define TCD_HOST_DUMMY_PIXELS_BACK          (14U)
+#define TCD_HOST_ADC_MAX                    (4095U)
+
+/**
+ *******************************************************************************
+ *                         MEMORY PLACEMENT
+ *******************************************************************************
+ *
+ * No caches or tightly coupled memory to manage on the host.
+ */
+#define TCD_DMA_BUFFER
+#define TCD_ITCM_CODE
+#define TCD_DTCM_DATA
+
+/**
+ *******************************************************************************
+ *                         MEMORY ORDERING
+ *******************************************************************************
+ *
+ * The emulated interrupts run on another thread, a full fence is needed.
+ */
+#define TCD_MEMORY_BARRIER()                __sync_synchronize()
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+void    TCD_PORT_Run(void);
+void    TCD_PORT_Stop(void);
+
+int32_t TCD_PORT_FM_ConfigClock(const uint32_t freq);
+int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us);
+int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us);
+int32_t TCD_PORT_SolveTiming(uint32_t t_icg_us, uint32_t t_int_us, TCD_PORT_TIMING_t *timing);
+void    TCD_PORT_SetTiming(const TCD_PORT_TIMING_t *timing);
+void    TCD_PORT_ICG_EnableInterrupt(void);
+uint32_t TCD_PORT_FM_GetFrequency(void);
+
+int32_t TCD_PORT_ADC_Init(void);
+void    TCD_PORT_ADC_ConfigTrigger(uint32_t f_adc);
+int32_t TCD_PORT_ADC_Start(uint16_t *dataBuffer);
+int32_t TCD_PORT_ADC_StartDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1);
+uint32_t TCD_PORT_ADC_GetCompletedBuffer(void);
+uint32_t TCD_PORT_ADC_IsReadoutPending(void);
+void    TCD_PORT_ADC_SetBuffer(uint32_t buffer, uint16_t *dataBuffer);
+void    TCD_PORT_RequestDeferredProcessing(void);
+
+void    TCD_PORT_CycleCounter_Init(void);
+uint32_t TCD_PORT_CycleCounter_Get(void);
+void    TCD_PORT_ADC_GetIrqCycles(uint32_t *cycles, uint32_t *maxCycles);
+void    TCD_PORT_ADC_ResetIrqCycles(void);
+
+/**
+ * Host simulation control.
+ * TCD_PORT_HOST_Configure() may be called before TCD_Init() or at any time
+ * later. The virtual clock only runs between TCD_PORT_Run() and
+ * TCD_PORT_Stop().
+ */
+void    TCD_PORT_HOST_Configure(const TCD_HOST_CONFIG_t *config);
+uint64_t TCD_PORT_HOST_GetTimeUs(void);
+uint64_t TCD_PORT_HOST_GetFramesGenerated(void);
+
+/**
+ * This function is called when a complete CCD sensor readout is finished.
+ * This function is called in the interrupt handler of the portable layer.
+ * The tcd1304.c implements what should be done in this function.
+ *
+ * The buffer parameter is the index of the data buffer holding the completed
+ * readout; 0 for dataBuffer0 and 1 for dataBuffer1. Always 0 in single
+ * buffer mode.
+ */
+void TCD_ReadCompletedCallback(uint32_t buffer);
+
+/**
+ * This function is called in the deferred processing context of the portable
+ * layer after TCD_PORT_RequestDeferredProcessing() has been called.
+ * The tcd1304.c implements what should be done in this function.
+ *
+ */
+void TCD_ProcessCompletedFrames(void);
+
+/**
+ * This function is called in the interrupt handler of the portable layer in
+ * the last SH period before an ICG pulse, after TCD_PORT_ICG_EnableInterrupt()
+ * has been called. Timer values passed to TCD_PORT_SetTiming() here take
+ * effect at that ICG pulse. It returns 1 while it must be called again at the
+ * next ICG pulse, 0 when the interrupt can be disabled.
+ * The tcd1304.c implements what should be done in this function.
+ */
+uint32_t TCD_IcgCallback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCD1304_PORT_H_ */
@@ -69,12 +69,17 @@ static TIM_HandleTypeDef htim5;
 static ADC_HandleTypeDef hadc1;
 static DMA_HandleTypeDef hdma_adc1;
 static PORT_TIMER_CONF_t timer_conf;
+static uint32_t irq_cycles;
+static uint32_t irq_max_cycles;
 
 /* Private function prototypes -----------------------------------------------*/
-static void TCD_PORT_EnableADCTrigger(void);
 static void TCD_PORT_DisableADCTrigger(void);
+static void TCD_PORT_RestartADC(void);
 static void TCD_PORT_ICG_SetDelay(uint32_t cnt);
 static void TCD_PORT_SH_SetDelay(uint32_t cnt);
+#if ( CFG_PROFILING == 1U )
+static void TCD_PORT_UpdateADCIrqCycles(uint32_t start);
+#endif
 
 /**
  *******************************************************************************
@@ -188,7 +193,7 @@ int32_t TCD_PORT_ConfigMasterClock(uint32_t freq)
 }
 
 /*******************************************************************************
- * @brief   Configure the ICG pulse generator with interrupt request
+ * @brief   Configure the ICG pulse generator as master of the ADC trigger
  * @param   t_int_us, uint32_t: Sensor readout period in microseconds
  * @retval  Error code
  *
@@ -243,7 +248,8 @@ int32_t TCD_PORT_ConfigICGClock(const uint32_t t_icg_us)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
-    sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+    /* The compare match at the end of the ICG pulse starts the ADC trigger timer */
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_OC1;
     sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
 
     if ( HAL_TIMEx_MasterConfigSynchronization( &htim2, &sMasterConfig ) != HAL_OK )
@@ -261,10 +267,6 @@ int32_t TCD_PORT_ConfigICGClock(const uint32_t t_icg_us)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
-    /* Set TIM2 interrupt level and enable interrupt for TIM2 */
-    HAL_NVIC_SetPriority( TIM2_IRQn, TIM_ICG_INTERRUPT_LEVEL, 0 );
-    HAL_NVIC_EnableIRQ( TIM2_IRQn );
-
     /* Check the parameters */
     assert_param( IS_TIM_CCX_INSTANCE(htim2.Instance, TIM_CHANNEL_1) );
 
@@ -277,9 +279,6 @@ int32_t TCD_PORT_ConfigICGClock(const uint32_t t_icg_us)
         __HAL_TIM_MOE_ENABLE( &htim2 );
     }
 
-    /* Enable the TIM Capture/Compare 1 interrupt */
-    __HAL_TIM_ENABLE_IT( &htim2, TIM_IT_CC1 );
-
     return err;
 }
 
@@ -361,8 +360,10 @@ int32_t TCD_PORT_ConfigSHClock(const uint32_t t_int_us)
  * @retval  None
  *
  * Background:
- * The ICG timer generates an ICG pulse. When this timer overflows, an interrupt is
- * generated. In this interrupt handler, the ADC Trigger timer is started.
+ * The ICG timer generates an ICG pulse. The ADC Trigger timer is a slave of the
+ * ICG timer in trigger mode: the compare match at the end of the ICG pulse is
+ * routed through TRGO/ITR1 and starts the ADC Trigger timer in hardware, at a
+ * fixed phase after the ICG edge and with no interrupt involved.
  * Remember that the DMA is connected to the ADC in CIRCULAR mode. When the DMA has
  * transfered 3694 ADC samples to RAM, a new interrupt is generated. In this
  * interrupt handler the ADC trigger timer MUST be disabled to avoid false restart of
@@ -383,7 +384,7 @@ int32_t TCD_PORT_ConfigSHClock(const uint32_t t_int_us)
  *
  * Solution:
  * The STM32 timers has a function called One-Pulse-Timer. This timer is programmed
- * to generate 3694 pulses when triggered. We use software trigger, by enabling the
+ * to generate 3694 pulses when triggered. The trigger from the ICG timer sets the
  * CEN bit in timer CR1 register. When this timer has generated 3694 pulses, it
  * automatically shuts down the counter by disabling the CEN bit in its own CR1
  * register. This eliminates the above problem, and the interrupt response time is no
@@ -397,6 +398,7 @@ void TCD_PORT_ConfigADCTrigger(uint32_t f_adc)
     TIM_MasterConfigTypeDef sMasterConfig;
     TIM_OC_InitTypeDef sConfigOC;
     GPIO_InitTypeDef GPIO_InitStruct;
+    TIM_SlaveConfigTypeDef sSlaveConfig;
     TIM_BreakDeadTimeConfigTypeDef sBreakDeadTimeConfig;
     uint32_t period = HAL_RCC_GetSysClockFreq() / f_adc - 1U;
     timer_conf.f_adc = f_adc;
@@ -446,6 +448,18 @@ void TCD_PORT_ConfigADCTrigger(uint32_t f_adc)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
+    /* Started by TIM2 TRGO (ITR1 of TIM1) at the end of the ICG pulse */
+    sSlaveConfig.SlaveMode = TIM_SLAVEMODE_TRIGGER;
+    sSlaveConfig.InputTrigger = TIM_TS_ITR1;
+    sSlaveConfig.TriggerPolarity = TIM_TRIGGERPOLARITY_RISING;
+    sSlaveConfig.TriggerPrescaler = TIM_TRIGGERPRESCALER_DIV1;
+    sSlaveConfig.TriggerFilter = 0;
+
+    if ( HAL_TIM_SlaveConfigSynchronization( &htim8, &sSlaveConfig ) != HAL_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
     sConfigOC.OCMode = TIM_OCMODE_PWM1;
     sConfigOC.Pulse = period / 10U;
     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
@@ -525,6 +539,9 @@ int32_t TCD_PORT_InitADC(void)
     HAL_NVIC_SetPriority( DMA2_Stream0_IRQn, DMA_ADC_INTERRUPT_LEVEL, 0 );
     HAL_NVIC_EnableIRQ( DMA2_Stream0_IRQn );
 
+    /* PendSV runs the deferred frame processing at the lowest priority */
+    HAL_NVIC_SetPriority( PendSV_IRQn, DEFERRED_INTERRUPT_LEVEL, 0 );
+
     /**
      * Configure the global features of the ADC
      * (Clock, Resolution, Data Alignment and number of conversion)
@@ -584,6 +601,163 @@ int32_t TCD_PORT_StartADC(uint16_t *dataBuffer)
     return (int32_t) HAL_ADC_Start_DMA( &hadc1, (uint32_t *) dataBuffer, CFG_CCD_NUM_PIXELS );
 }
 
+/*******************************************************************************
+ * @brief   Start the ADC with DMA transfer in double buffer mode
+ * @param   *dataBuffer0, uint16_t: Pointer to the first data buffer in RAM
+ * @param   *dataBuffer1, uint16_t: Pointer to the second data buffer in RAM
+ * @retval  Error codes
+ *
+ * The DMA stream is configured with the double buffer mode (DBM) where M0AR and
+ * M1AR hold the two buffer addresses. The DMA hardware swaps the target buffer
+ * at every transfer complete, so the readout that just finished is left
+ * untouched while the next readout is written to the other buffer.
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_StartADCDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1)
+{
+    __IO uint32_t counter;
+
+    if ( (dataBuffer0 == NULL) || (dataBuffer1 == NULL) )
+    {
+        return -1;
+    }
+
+    /* Enable the ADC and wait for the stabilization time */
+    if ( (hadc1.Instance->CR2 & ADC_CR2_ADON) != ADC_CR2_ADON )
+    {
+        __HAL_ADC_ENABLE( &hadc1 );
+
+        counter = ADC_STAB_DELAY_US * (SystemCoreClock / 1000000U);
+        while ( counter != 0U )
+        {
+            counter--;
+        }
+    }
+
+    /* Clear stale conversion flags and let the ADC issue DMA requests */
+    __HAL_ADC_CLEAR_FLAG( &hadc1, ADC_FLAG_EOC | ADC_FLAG_OVR );
+    hadc1.Instance->CR2 |= ADC_CR2_DMA;
+
+    if ( HAL_DMAEx_MultiBufferStart_IT( &hdma_adc1,
+                                        (uint32_t) &hadc1.Instance->DR,
+                                        (uint32_t) dataBuffer0,
+                                        (uint32_t) dataBuffer1,
+                                        CFG_CCD_NUM_PIXELS ) != HAL_OK )
+    {
+        return -1;
+    }
+
+    /* The stream runs in direct mode, a FIFO error is of no interest */
+    hdma_adc1.Instance->FCR &= ~DMA_SxFCR_FEIE;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Get the index of the data buffer holding the last completed readout
+ * @param   None
+ * @retval  0 for dataBuffer0, 1 for dataBuffer1
+ *
+ * The current target (CT) bit points to the buffer the DMA is filling now,
+ * hence the completed buffer is the other one. Always 0 in single buffer mode.
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_GetADCCompletedBuffer(void)
+{
+    if ( (hdma_adc1.Instance->CR & DMA_SxCR_DBM) == 0U )
+    {
+        return 0U;
+    }
+
+    return ((hdma_adc1.Instance->CR & DMA_SxCR_CT) != 0U) ? 0U : 1U;
+}
+
+/*******************************************************************************
+ * @brief   Set the data buffer of one of the DMA memories in double buffer mode
+ * @param   buffer, uint32_t: DMA memory index; 0 for M0AR and 1 for M1AR
+ * @param   *dataBuffer, uint16_t: Pointer to the new data location in RAM
+ * @retval  None
+ *
+ * Only the memory that is not the current target may be changed. Call this
+ * from TCD_ReadCompletedCallback() with the index of the completed buffer.
+ * The new address is used when the DMA swaps back to this memory.
+ *
+ ******************************************************************************/
+void TCD_PORT_SetADCBuffer(uint32_t buffer, uint16_t *dataBuffer)
+{
+    if ( buffer == 0U )
+    {
+        hdma_adc1.Instance->M0AR = (uint32_t) dataBuffer;
+    }
+    else
+    {
+        hdma_adc1.Instance->M1AR = (uint32_t) dataBuffer;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Request the deferred frame processing to run
+ * @param   None
+ * @retval  None
+ *
+ * Pends the PendSV exception. It runs at DEFERRED_INTERRUPT_LEVEL as soon as
+ * all higher priority interrupts have returned.
+ *
+ ******************************************************************************/
+void TCD_PORT_RequestDeferredProcessing(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/*******************************************************************************
+ * @brief   Enable the DWT cycle counter
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_InitCycleCounter(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+ * @brief   Get the DWT cycle counter
+ * @param   None
+ * @retval  The CPU cycles since the counter was enabled, wraps around at 2^32.
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_GetCycleCount(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+ * @brief   Get the cycle count of the ADC+DMA interrupt handler
+ * @param   cycles, uint32_t: Last measurement
+ * @param   maxCycles, uint32_t: Maximum measurement
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_GetADCIrqCycles(uint32_t *cycles, uint32_t *maxCycles)
+{
+    *cycles = irq_cycles;
+    *maxCycles = irq_max_cycles;
+}
+
+/*******************************************************************************
+ * @brief   Reset the cycle count of the ADC+DMA interrupt handler
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ResetADCIrqCycles(void)
+{
+    irq_cycles = 0U;
+    irq_max_cycles = 0U;
+}
+
 /**
  *******************************************************************************
  *                        PRIVATE IMPLEMENTATION SECTION
@@ -594,17 +768,6 @@ int32_t TCD_PORT_StartADC(uint16_t *dataBuffer)
  * The compiler is smart to inline these functions calls into where it is called
  * to remove function call overheads.
  */
-/*******************************************************************************
- * @brief   Enable the timer that generates ADC trigger signal
- * @param   None
- * @retval  None
- *
- ******************************************************************************/
-static void TCD_PORT_EnableADCTrigger(void)
-{
-    TCD_ADC_TRIG_TIMER->CR1 |= TIM_CR1_CEN;
-}
-
 /*******************************************************************************
  * @brief   Disable the timer that generates ADC trigger signal
  * @param   None
@@ -614,6 +777,9 @@ static void TCD_PORT_EnableADCTrigger(void)
 static void TCD_PORT_DisableADCTrigger(void)
 {
     TCD_ADC_TRIG_TIMER->CR1 &= ~TIM_CR1_CEN;
+
+    /* Rewind, so the next trigger from the ICG timer starts at the same phase */
+    TCD_ADC_TRIG_TIMER->CNT = 0U;
 }
 
 /*******************************************************************************
@@ -638,32 +804,52 @@ static void TCD_PORT_SH_SetDelay(uint32_t cnt)
     TCD_ICG_TIMER->CNT = cnt;
 }
 
-/**
- *******************************************************************************
- *                         INTERRUPT HANDLERS
- *******************************************************************************
- */
-
 /*******************************************************************************
- * @brief   This function handles ICG PULSE interrupt.
+ * @brief   Re-arm the ADC DMA stream after a transfer error
  * @param   None
  * @retval  None
  *
- * When the ICG TIMER has generated an ICG pulse to start moving out charges
- * from the CCD, an interrupt request (TIMx_IRQ) is generated.
- *
- * This interrupt handler function is to start the ADC+DMA acquisition of
- * CFG_CCD_NUM_PIXELS ADC samples. This is 3694 for the TCD1304 sensor.
- * When this acquisition is finished, a new interrupt is generated;
- * TCD_CCD_ADC_INTERRUPT_HANDLER().
+ * The stream was disabled by the hardware and the ADC trigger timer has been
+ * stopped, so no conversion happens until the next ICG pulse. The memory
+ * addresses and the current target are kept, the next readout overwrites the
+ * buffer of the aborted one. The ADC stops its DMA requests after an overrun.
  *
  ******************************************************************************/
-void TCD_ICG_TIMER_INTERRUPT_HANDLER(void)
+static void TCD_PORT_RestartADC(void)
 {
-    TCD_PORT_EnableADCTrigger();
+    hadc1.Instance->CR2 &= ~ADC_CR2_DMA;
+    __HAL_ADC_CLEAR_FLAG( &hadc1, ADC_FLAG_EOC | ADC_FLAG_OVR );
+    hadc1.Instance->CR2 |= ADC_CR2_DMA;
+
+    /* HAL_DMA_IRQHandler() disables the transfer error interrupt */
+    TCD_ADC_DMA->LIFCR = TCD_ADC_DMA_FLAGS;
+    hdma_adc1.Instance->NDTR = CFG_CCD_NUM_PIXELS;
+    hdma_adc1.Instance->CR |= DMA_SxCR_TEIE;
+    hdma_adc1.Instance->CR |= DMA_SxCR_EN;
+}
 
-    HAL_TIM_IRQHandler( &htim2 );
+#if ( CFG_PROFILING == 1U )
+/*******************************************************************************
+ * @brief   Store the cycles of the ADC+DMA interrupt handler
+ * @param   start, uint32_t: Cycle counter at the entry of the handler
+ * @retval  None
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE static void TCD_PORT_UpdateADCIrqCycles(uint32_t start)
+{
+    irq_cycles = TCD_PORT_GetCycleCount() - start;
+    if ( irq_cycles > irq_max_cycles )
+    {
+        irq_max_cycles = irq_cycles;
+    }
 }
+#endif
+
+/**
+ *******************************************************************************
+ *                         INTERRUPT HANDLERS
+ *******************************************************************************
+ */
 
 /*******************************************************************************
  * @brief   This function handles ADC+DMA acquisition complete interrupt.
@@ -671,29 +857,82 @@ void TCD_ICG_TIMER_INTERRUPT_HANDLER(void)
  * @retval  None
  *
  * The ADC+DMA acquisition of CFG_CCD_NUM_PIXELS samples were started in
- * TCD_ICG_TIMER_INTERRUPT_HANDLER().
+ * hardware by the ICG timer, see TCD_PORT_ConfigADCTrigger().
  *
  * When the DMA transfer has completed an interrupt request (DMAX_StreamX_IRQ)
  * is generated.
  * This is the interrupt handler for that request. Following is done:
  * 1) Disable the ADC trigger signal (TCD_ADC_TRIG_TIMER).
- * 2) Let the HAL layer handle the DMA interrupt request
- * 3) Call the user callback function to deal with the acquired ADC samples.
+ * 2) Find the data buffer that holds the completed readout
+ * 3) Let the HAL layer handle the DMA interrupt request
+ * 4) Call the user callback function to deal with the acquired ADC samples.
+ *
+ * A transfer error disables the stream in hardware. The readout is reported
+ * lost and the stream is re-armed here, the trigger timer is already stopped.
  *
  ******************************************************************************/
 void TCD_CCD_ADC_INTERRUPT_HANDLER(void)
 {
+#if ( CFG_PROFILING == 1U )
+    uint32_t start = TCD_PORT_GetCycleCount();
+#endif
+    uint32_t buffer = TCD_PORT_GetADCCompletedBuffer();
+    uint32_t flags = TCD_ADC_DMA->LISR & TCD_ADC_DMA_FLAGS;
+
     TCD_PORT_DisableADCTrigger();
     
-    if ( hdma_adc1.Instance->NDTR != CFG_CCD_NUM_PIXELS )
+    if ( ((flags & TCD_ADC_DMA_FLAG_TE) == 0U) &&
+         (hdma_adc1.Instance->NDTR != CFG_CCD_NUM_PIXELS) )
     {
         __BKPT( 0U );
     }
     
+#if ( CFG_HAL_IRQ_HANDLERS == 1U )
     HAL_DMA_IRQHandler( &hdma_adc1 );
 
-    /* Do something with the acquired AD samples in RAM */
-    TCD_ReadCompletedCallback();
+    if ( (flags & TCD_ADC_DMA_FLAG_TE) != 0U )
+    {
+        TCD_PORT_RestartADC();
+        TCD_ReadErrorCallback();
+    }
+    else
+    {
+        /* Do something with the acquired AD samples in RAM */
+        TCD_ReadCompletedCallback( buffer );
+    }
+#else
+    /* Only transfer complete and transfer error are used */
+    TCD_ADC_DMA->LIFCR = flags;
+
+    if ( (flags & TCD_ADC_DMA_FLAG_TE) != 0U )
+    {
+        TCD_PORT_RestartADC();
+        TCD_ReadErrorCallback();
+    }
+    else if ( (flags & TCD_ADC_DMA_FLAG_TC) != 0U )
+    {
+        /* Do something with the acquired AD samples in RAM */
+        TCD_ReadCompletedCallback( buffer );
+    }
+#endif
+#if ( CFG_PROFILING == 1U )
+    TCD_PORT_UpdateADCIrqCycles( start );
+#endif
+}
+
+/*******************************************************************************
+ * @brief   This function handles the deferred frame processing.
+ * @param   None
+ * @retval  None
+ *
+ * PendSV is pended by TCD_PORT_RequestDeferredProcessing() from the ADC+DMA
+ * interrupt handler. Accumulation and averaging of the queued frames is done
+ * here, at a lower priority than all acquisition interrupts.
+ *
+ ******************************************************************************/
+void TCD_DEFERRED_INTERRUPT_HANDLER(void)
+{
+    TCD_ProcessCompletedFrames();
 }
 
 /**
@@ -66,13 +66,28 @@ extern "C"
 #define TCD_SH_TIMER                        (TIM5)
 #define TCD_ADC_TRIG_TIMER                  (TIM1)
 
+/**
+ *******************************************************************************
+ *                         DMA DEFINITIONS
+ *******************************************************************************
+ *
+ * The ADC data is moved by DMA2 Stream0. The interrupt flags of streams 0..3
+ * are in the LISR register and cleared in LIFCR at the same bit positions.
+ */
+#define TCD_ADC_DMA                         (DMA2)
+#define TCD_ADC_DMA_FLAG_TC                 (DMA_LISR_TCIF0)
+#define TCD_ADC_DMA_FLAG_TE                 (DMA_LISR_TEIF0)
+#define TCD_ADC_DMA_FLAGS                   (DMA_LISR_TCIF0 | DMA_LISR_HTIF0 | \
+                                             DMA_LISR_TEIF0 | DMA_LISR_DMEIF0 | \
+                                             DMA_LISR_FEIF0)
+
 /**
  *******************************************************************************
  *                         INTERRUPT HANDLERS
  *******************************************************************************
  */
-#define TCD_ICG_TIMER_INTERRUPT_HANDLER     TIM2_IRQHandler
 #define TCD_CCD_ADC_INTERRUPT_HANDLER       DMA2_Stream0_IRQHandler
+#define TCD_DEFERRED_INTERRUPT_HANDLER      PendSV_Handler
 
 /**
  *******************************************************************************
@@ -82,11 +97,32 @@ extern "C"
  * In STM32 MCU 4 interrupt priority bits are implemented. This means that
  * the lowest (highest value) interrupt priority is 15 (0x0F).
  * We set:
- * TIM_ICG_INTERRUPT_LEVEL to default value = 6.
  * DMA_ADC_INTERRUPT_LEVEL to default value = 5.
  */
-#define TIM_ICG_INTERRUPT_LEVEL             (0U)
 #define DMA_ADC_INTERRUPT_LEVEL             (1U)
+#define DEFERRED_INTERRUPT_LEVEL            (15U)
+
+/**
+ *******************************************************************************
+ *                         MEMORY PLACEMENT
+ *******************************************************************************
+ *
+ * The Cortex-M4 has no D-cache, DMA buffers need no special placement.
+ * The STM32F401 has no tightly coupled memory.
+ */
+#define TCD_DMA_BUFFER
+#define TCD_ITCM_CODE
+#define TCD_DTCM_DATA
+
+/**
+ *******************************************************************************
+ *                         MEMORY ORDERING
+ *******************************************************************************
+ *
+ * Orders the sequence counter of the averaged data against the data itself
+ * between the deferred processing and the main loop.
+ */
+#define TCD_MEMORY_BARRIER()                __DMB()
 
 /**
  *******************************************************************************
@@ -114,14 +150,42 @@ int32_t TCD_PORT_ConfigICGClock(const uint32_t t_icg_us);
 int32_t TCD_PORT_InitADC(void);
 void    TCD_PORT_ConfigADCTrigger(uint32_t Fs);
 int32_t TCD_PORT_StartADC(uint16_t *dataBuffer);
+int32_t TCD_PORT_StartADCDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1);
+uint32_t TCD_PORT_GetADCCompletedBuffer(void);
+void    TCD_PORT_SetADCBuffer(uint32_t buffer, uint16_t *dataBuffer);
+void    TCD_PORT_RequestDeferredProcessing(void);
+
+void    TCD_PORT_InitCycleCounter(void);
+uint32_t TCD_PORT_GetCycleCount(void);
+void    TCD_PORT_GetADCIrqCycles(uint32_t *cycles, uint32_t *maxCycles);
+void    TCD_PORT_ResetADCIrqCycles(void);
 
 /**
  * This function is called when a complete CCD sensor readout is finished.
  * This function is called in the interrupt handler of the portable layer.
  * The tcd1304.c implements what should be done in this function.
  *
+ * The buffer parameter is the index of the data buffer holding the completed
+ * readout; 0 for dataBuffer0 and 1 for dataBuffer1. Always 0 in single
+ * buffer mode.
+ */
+void TCD_ReadCompletedCallback(uint32_t buffer);
+
+/**
+ * This function is called in the interrupt handler of the portable layer when
+ * a readout is lost to a DMA transfer error. The DMA is re-armed before the
+ * next readout.
+ * The tcd1304.c implements what should be done in this function.
+ */
+void TCD_ReadErrorCallback(void);
+
+/**
+ * This function is called in the deferred processing context of the portable
+ * layer after TCD_PORT_RequestDeferredProcessing() has been called.
+ * The tcd1304.c implements what should be done in this function.
+ *
  */
-void TCD_ReadCompletedCallback(void);
+void TCD_ProcessCompletedFrames(void);
 
 #ifdef __cplusplus
 }
@@ -53,10 +53,10 @@
 /* Private typedef -----------------------------------------------------------*/
 typedef struct
 {
-    uint32_t f_master;
+    uint32_t f_master;              /* Achieved master clock                  */
     uint32_t t_int_us;
     uint32_t t_icg_us;
-    uint32_t f_adc;
+    uint32_t f_adc;                 /* Achieved ADC sampling rate             */
 } PORT_TIMER_CONF_t;
 
 /* Private define ------------------------------------------------------------*/
@@ -69,12 +69,21 @@ static TIM_HandleTypeDef htim14;
 static ADC_HandleTypeDef hadc3;
 static DMA_HandleTypeDef hdma_adc3;
 static PORT_TIMER_CONF_t timer_conf;
+static uint32_t irq_cycles;
+static uint32_t irq_max_cycles;
+static volatile uint8_t adc_restart;    /* Set by a DMA transfer error */
 
 /* Private function prototypes -----------------------------------------------*/
-static void TCD_PORT_EnableADCTrigger(void);
 static void TCD_PORT_DisableADCTrigger(void);
+static void TCD_PORT_ADC_Restart(void);
 static void TCD_PORT_ICG_SetDelay(uint32_t cnt);
 static void TCD_PORT_SH_SetDelay(uint32_t cnt);
+static uint32_t TCD_PORT_GetTimerClock(const TIM_TypeDef *tim);
+static uint32_t TCD_PORT_FM_GetCycles(uint32_t freq);
+static uint32_t TCD_PORT_UsToTicks(uint32_t us, uint32_t clock, uint32_t prescaler);
+#if ( CFG_PROFILING == 1U )
+static void TCD_PORT_UpdateIrqCycles(uint32_t start);
+#endif
 
 /**
  *******************************************************************************
@@ -95,6 +104,10 @@ void TCD_PORT_Run(void)
     /* Disable the DMA transfer half complete interrupt */
     __HAL_DMA_DISABLE_IT( &hdma_adc3, DMA_IT_HT ); /*lint !e506 */
 
+    /* Load the preloaded periods, see TCD_PORT_SetTiming() */
+    htim2.Instance->EGR = TIM_EGR_UG;
+    htim14.Instance->EGR = TIM_EGR_UG;
+
     /* Reset the timer counters to 0 */
     htim2.Instance->CNT = 0U;
     htim14.Instance->CNT = 0U;
@@ -119,17 +132,20 @@ void TCD_PORT_Stop(void)
 
 /*******************************************************************************
  * @brief   Configure the CCD master clock
- * @param   freq, uint32_t: Clock frequency in MHz
+ * @param   freq, uint32_t: Clock frequency in Hz
  * @retval  Error code
  *
+ * The timer divides its clock by the nearest integer, see
+ * TCD_PORT_FM_GetFrequency() for the frequency achieved.
  ******************************************************************************/
 int32_t TCD_PORT_FM_ConfigClock(uint32_t freq)
 {
     TIM_OC_InitTypeDef sConfigOC;
     GPIO_InitTypeDef GPIO_InitStruct;
     int32_t err = 0;
-    uint32_t period = (HAL_RCC_GetSysClockFreq() / 2U) / freq - 1U;
-    timer_conf.f_master = freq;
+    uint32_t cycles = TCD_PORT_FM_GetCycles( freq );
+    uint32_t period = cycles - 1U;
+    timer_conf.f_master = TCD_PORT_GetTimerClock( TCD_MCLK_TIMER ) / cycles;
 
     /* Peripheral clock enable */
     __HAL_RCC_TIM13_CLK_ENABLE();
@@ -163,7 +179,7 @@ int32_t TCD_PORT_FM_ConfigClock(uint32_t freq)
     }
 
     sConfigOC.OCMode = TIM_OCMODE_PWM1;
-    sConfigOC.Pulse = period / 2U;
+    sConfigOC.Pulse = cycles / 2U;
     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
     sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
 
@@ -188,10 +204,12 @@ int32_t TCD_PORT_FM_ConfigClock(uint32_t freq)
 }
 
 /*******************************************************************************
- * @brief   Configure the ICG pulse generator with interrupt request
- * @param   t_int_us, uint32_t: Sensor readout period in microseconds
+ * @brief   Configure the ICG pulse generator as master of the ADC trigger
+ * @param   t_icg_us, uint32_t: Sensor readout period in microseconds
  * @retval  Error code
  *
+ * The timer starts with the SH period equal to the ICG period.
+ * TCD_PORT_SH_ConfigClock() sets the final prescaler and periods.
  ******************************************************************************/
 int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
 {
@@ -199,10 +217,17 @@ int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
     TIM_MasterConfigTypeDef sMasterConfig;
     TIM_OC_InitTypeDef sConfigOC;
     GPIO_InitTypeDef GPIO_InitStruct;
+    TCD_PORT_TIMING_t timing;
     int32_t err = 0;
-    uint32_t prescaler = (HAL_RCC_GetSysClockFreq() / 2U) / CFG_FM_FREQUENCY_HZ - 1U;
-    uint32_t period = (uint32_t) ((uint64_t) t_icg_us * CFG_FM_FREQUENCY_HZ / 1000000U) - 1U;
-    uint32_t pulse = CFG_ICG_DEFAULT_PULSE_US * CFG_FM_FREQUENCY_HZ / 1000000U;
+
+    if ( TCD_PORT_SolveTiming( t_icg_us, t_icg_us, &timing ) != 0 )
+    {
+        return -1;
+    }
+
+    uint32_t prescaler = timing.prescaler - 1U;
+    uint32_t period = timing.icgTicks - 1U;
+    uint32_t pulse = timing.icgPulseTicks;
     timer_conf.t_icg_us = t_icg_us;
 
     /* Peripheral clock enable */
@@ -243,7 +268,8 @@ int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
-    sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+    /* The compare match at the end of the ICG pulse starts the ADC trigger timer */
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_OC1;
     sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
 
     if ( HAL_TIMEx_MasterConfigSynchronization( &htim2, &sMasterConfig ) != HAL_OK )
@@ -261,10 +287,6 @@ int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
-    /* Set TIM2 interrupt level and enable interrupt for TIM2 */
-    HAL_NVIC_SetPriority( TIM2_IRQn, TIM_ICG_INTERRUPT_LEVEL, 0 );
-    HAL_NVIC_EnableIRQ( TIM2_IRQn );
-
     /* Check the parameters */
     assert_param( IS_TIM_CCX_INSTANCE(htim2.Instance, TIM_CHANNEL_1) );
 
@@ -277,8 +299,27 @@ int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us)
         __HAL_TIM_MOE_ENABLE( &htim2 );
     }
 
-    /* Enable the TIM Capture/Compare 1 interrupt */
-    __HAL_TIM_ENABLE_IT( &htim2, TIM_IT_CC1 );
+    /**
+     * Channel 2 interrupts in the last SH period before the ICG pulse, see
+     * TCD_PORT_SetTiming(). The period and the compare value are preloaded
+     * and change at the update event, which is the ICG pulse. The interrupt
+     * is only enabled while it has work, see TCD_PORT_ICG_EnableInterrupt().
+     */
+    sConfigOC.OCMode = TIM_OCMODE_TIMING;
+    sConfigOC.Pulse = period;
+
+    if ( HAL_TIM_OC_ConfigChannel( &htim2, &sConfigOC, TIM_CHANNEL_2 ) != HAL_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
+    htim2.Instance->CCMR1 |= TIM_CCMR1_OC2PE;
+    htim2.Instance->CR1 |= TIM_CR1_ARPE;
+
+    __HAL_TIM_DISABLE_IT( &htim2, TIM_IT_CC2 );
+    __HAL_TIM_CLEAR_IT( &htim2, TIM_IT_CC2 );
+    HAL_NVIC_SetPriority( TIM2_IRQn, ICG_INTERRUPT_LEVEL, 0 );
+    HAL_NVIC_EnableIRQ( TIM2_IRQn );
 
     return err;
 }
@@ -293,10 +334,17 @@ int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us)
 {
     TIM_OC_InitTypeDef sConfigOC;
     GPIO_InitTypeDef GPIO_InitStruct;
+    TCD_PORT_TIMING_t timing;
     int32_t err = 0;
-    uint32_t prescaler = (HAL_RCC_GetSysClockFreq() / 2U) / CFG_FM_FREQUENCY_HZ - 1U;
-    uint32_t period = t_int_us * CFG_FM_FREQUENCY_HZ / 1000000U - 1U;
-    uint32_t pulse = CFG_SH_DEFAULT_PULSE_US * CFG_FM_FREQUENCY_HZ / 1000000U;
+
+    if ( TCD_PORT_SolveTiming( timer_conf.t_icg_us, t_int_us, &timing ) != 0 )
+    {
+        return -1;
+    }
+
+    uint32_t prescaler = timing.prescaler - 1U;
+    uint32_t period = timing.shTicks - 1U;
+    uint32_t pulse = timing.shPulseTicks;
     timer_conf.t_int_us = t_int_us;
 
     /* Peripheral clock enable */
@@ -352,17 +400,174 @@ int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us)
         __HAL_TIM_MOE_ENABLE( &htim14 );
     }
 
+    htim14.Instance->CR1 |= TIM_CR1_ARPE;
+
+    /* Common prescaler, and the ICG interrupt in the last SH period */
+    TCD_PORT_SetTiming( &timing );
+
     return err;
 }
 
+/*******************************************************************************
+ * @brief   Find the timer settings for an ICG and an SH period
+ * @param   t_icg_us, uint32_t: Sensor readout period in microseconds
+ * @param   t_int_us, uint32_t: Integration time for the CCD in microseconds
+ * @param   timing, TCD_PORT_TIMING_t: Register values and quantization error
+ * @retval  0 on success, -1 if the periods can not be generated
+ *
+ * The periods are counted in the timer clock of the APB bus, divided by a
+ * prescaler common to both timers. The solver takes the smallest prescaler
+ * that fits the SH period in the 16 bit counter, and larger ones up to
+ * TCD_PRESCALER_SEARCH more, until one divides the period exactly. Otherwise
+ * it keeps the smallest error. The ICG period is N times the SH period in
+ * ticks, so its error is N times the SH error.
+ *
+ * The pulse widths round up, so they never get shorter than configured.
+ * Takes too long for an interrupt handler; solve when the change is staged.
+ ******************************************************************************/
+int32_t TCD_PORT_SolveTiming(uint32_t t_icg_us, uint32_t t_int_us, TCD_PORT_TIMING_t *timing)
+{
+    uint32_t clock = TCD_PORT_GetTimerClock( TCD_SH_TIMER );
+    uint64_t bestError = UINT64_MAX;
+    uint64_t shCycles;
+    uint64_t icgTicks;
+    uint32_t first;
+    uint32_t last;
+    uint32_t n;
+    int64_t error;
+
+    if ( (timing == NULL) || (t_int_us == 0U) || ((t_icg_us % t_int_us) != 0U) ||
+         (TCD_PORT_GetTimerClock( TCD_ICG_TIMER ) != clock) )
+    {
+        return -1;
+    }
+
+    n = t_icg_us / t_int_us;
+    shCycles = ((uint64_t) t_int_us * clock + 500000U) / 1000000U;
+    first = (uint32_t) ((shCycles + TCD_SH_TIMER_MAX_TICKS - 1U) / TCD_SH_TIMER_MAX_TICKS);
+    last = first + TCD_PRESCALER_SEARCH - 1U;
+
+    if ( last > TCD_TIMER_MAX_PRESCALER )
+    {
+        last = TCD_TIMER_MAX_PRESCALER;
+    }
+
+    timing->prescaler = 0U;
+
+    for ( uint32_t prescaler = first; prescaler <= last; prescaler++ )
+    {
+        uint64_t ticks = (shCycles + (prescaler / 2U)) / prescaler;
+        uint64_t cycles = ticks * prescaler;
+        uint64_t diff = (cycles > shCycles) ? (cycles - shCycles) : (shCycles - cycles);
+
+        if ( (ticks <= TCD_SH_TIMER_MAX_TICKS) && (diff < bestError) )
+        {
+            bestError = diff;
+            timing->prescaler = prescaler;
+            timing->shTicks = (uint32_t) ticks;
+
+            if ( diff == 0U )
+            {
+                break;
+            }
+        }
+    }
+
+    if ( timing->prescaler == 0U )
+    {
+        return -1;
+    }
+
+    icgTicks = (uint64_t) n * timing->shTicks;
+    if ( icgTicks > TCD_ICG_TIMER_MAX_TICKS )
+    {
+        return -1;
+    }
+
+    timing->icgTicks = (uint32_t) icgTicks;
+    timing->icgPulseTicks = TCD_PORT_UsToTicks( CFG_ICG_DEFAULT_PULSE_US, clock, timing->prescaler );
+    timing->shPulseTicks = TCD_PORT_UsToTicks( CFG_SH_DEFAULT_PULSE_US, clock, timing->prescaler );
+
+    /* Achieved minus requested period in units of 1 / (clock x 10^6) s */
+    error = (int64_t) ((uint64_t) timing->shTicks * timing->prescaler * 1000000U) -
+            (int64_t) ((uint64_t) t_int_us * clock);
+    timing->t_int_err_ns = (int32_t) ((error * 1000) / (int64_t) clock);
+    timing->t_icg_err_ns = (int32_t) ((error * (int64_t) n * 1000) / (int64_t) clock);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Write new ICG and SH timer settings to the preload registers
+ * @param   timing, TCD_PORT_TIMING_t: Settings from TCD_PORT_SolveTiming()
+ * @retval  None
+ *
+ * Called from TCD_IcgCallback() in the last SH period before an ICG pulse.
+ * The ICG and SH timers count from the same clock and P_ICG = N x P_SH, so
+ * both overflow at the ICG pulse and load the new prescaler, periods and
+ * pulse widths together. The next ICG interrupt is moved into the middle of
+ * the new last SH period, which leaves half an SH period (at least 5 us) of
+ * interrupt latency. While the timers are stopped TCD_PORT_Run() loads the
+ * values.
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_PORT_SetTiming(const TCD_PORT_TIMING_t *timing)
+{
+    TCD_ICG_TIMER->PSC = timing->prescaler - 1U;
+    TCD_ICG_TIMER->ARR = timing->icgTicks - 1U;
+    TCD_ICG_TIMER->CCR1 = timing->icgPulseTicks;
+    TCD_ICG_TIMER->CCR2 = timing->icgTicks - (timing->shTicks / 2U);
+
+    TCD_SH_TIMER->PSC = timing->prescaler - 1U;
+    TCD_SH_TIMER->ARR = timing->shTicks - 1U;
+    TCD_SH_TIMER->CCR1 = timing->shPulseTicks;
+}
+
+/*******************************************************************************
+ * @brief   Enable the ICG interrupt from the next ICG pulse on
+ * @param   None
+ * @retval  None
+ *
+ * The interrupt is needed only while a configuration is staged or the ADC
+ * DMA must be re-armed; the handler disables it again when both are done.
+ * A stale compare flag is cleared first, so the first interrupt comes in the
+ * last SH period and not at once. An interrupt that is already enabled is
+ * left alone; the handler commits everything staged before it runs.
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_PORT_ICG_EnableInterrupt(void)
+{
+    if ( (TCD_ICG_TIMER->DIER & TIM_DIER_CC2IE) == 0U )
+    {
+        TCD_ICG_TIMER->SR = ~TIM_SR_CC2IF;
+        TCD_ICG_TIMER->DIER |= TIM_DIER_CC2IE;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Get the master clock frequency achieved by the timer
+ * @param   None
+ * @retval  Frequency in Hz
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_FM_GetFrequency(void)
+{
+    return timer_conf.f_master;
+}
+
 /*******************************************************************************
  * @brief   Configure the ADC trigger as One-Pulse-Timer with 3693 repetitions
- * @param   Fs, uint32_t: ADC sampling frequency
+ * @param   f_adc, uint32_t: ADC sampling frequency, f_master / 4
  * @retval  None
  *
+ * The sample period is four periods of the master clock as the timer
+ * generates it, converted to the clock of the ADC trigger timer. The samples
+ * stay locked to the pixels also when f_master is not an exact divisor.
+ *
  * Background:
- * The ICG timer generates an ICG pulse. When this timer overflows, an interrupt is
- * generated. In this interrupt handler, the ADC Trigger timer is started.
+ * The ICG timer generates an ICG pulse. The ADC Trigger timer is a slave of the
+ * ICG timer in trigger mode: the compare match at the end of the ICG pulse is
+ * routed through TRGO/ITR1 and starts the ADC Trigger timer in hardware, at a
+ * fixed phase after the ICG edge and with no interrupt involved.
  * Remember that the DMA is connected to the ADC in CIRCULAR mode. When the DMA has
  * transfered 3694 ADC samples to RAM, a new interrupt is generated. In this
  * interrupt handler the ADC trigger timer MUST be disabled to avoid false restart of
@@ -383,7 +588,7 @@ int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us)
  *
  * Solution:
  * The STM32 timers has a function called One-Pulse-Timer. This timer is programmed
- * to generate 3694 pulses when triggered. We use software trigger, by enabling the
+ * to generate 3694 pulses when triggered. The trigger from the ICG timer sets the
  * CEN bit in timer CR1 register. When this timer has generated 3694 pulses, it
  * automatically shuts down the counter by disabling the CEN bit in its own CR1
  * register. This eliminates the above problem, and the interrupt response time is no
@@ -397,9 +602,14 @@ void TCD_PORT_ADC_ConfigTrigger(uint32_t f_adc)
     TIM_MasterConfigTypeDef sMasterConfig;
     TIM_OC_InitTypeDef sConfigOC;
     GPIO_InitTypeDef GPIO_InitStruct;
+    TIM_SlaveConfigTypeDef sSlaveConfig;
     TIM_BreakDeadTimeConfigTypeDef sBreakDeadTimeConfig;
-    uint32_t period = HAL_RCC_GetSysClockFreq() / f_adc - 1U;
-    timer_conf.f_adc = f_adc;
+    uint32_t clock = TCD_PORT_GetTimerClock( TCD_ADC_TRIG_TIMER );
+    uint32_t fmClock = TCD_PORT_GetTimerClock( TCD_MCLK_TIMER );
+    uint64_t fmCycles = TCD_PORT_FM_GetCycles( f_adc * 4U );
+    uint32_t cycles = (uint32_t) ((fmCycles * 4U * clock + (fmClock / 2U)) / fmClock);
+    uint32_t period = cycles - 1U;
+    timer_conf.f_adc = clock / cycles;
 
     /* Peripheral clock enable */
     __HAL_RCC_TIM8_CLK_ENABLE();
@@ -451,6 +661,18 @@ void TCD_PORT_ADC_ConfigTrigger(uint32_t f_adc)
         _Error_Handler( __FILE__, __LINE__ );
     }
 
+    /* Started by TIM2 TRGO (ITR1 of TIM8) at the end of the ICG pulse */
+    sSlaveConfig.SlaveMode = TIM_SLAVEMODE_TRIGGER;
+    sSlaveConfig.InputTrigger = TIM_TS_ITR1;
+    sSlaveConfig.TriggerPolarity = TIM_TRIGGERPOLARITY_RISING;
+    sSlaveConfig.TriggerPrescaler = TIM_TRIGGERPRESCALER_DIV1;
+    sSlaveConfig.TriggerFilter = 0;
+
+    if ( HAL_TIM_SlaveConfigSynchronization( &htim8, &sSlaveConfig ) != HAL_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
     sConfigOC.OCMode = TIM_OCMODE_PWM1;
     sConfigOC.Pulse = period / 10U;
     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
@@ -534,6 +756,9 @@ int32_t TCD_PORT_ADC_Init(void)
     HAL_NVIC_SetPriority( DMA2_Stream0_IRQn, DMA_ADC_INTERRUPT_LEVEL, 0 );
     HAL_NVIC_EnableIRQ( DMA2_Stream0_IRQn );
 
+    /* PendSV runs the deferred frame processing at the lowest priority */
+    HAL_NVIC_SetPriority( PendSV_IRQn, DEFERRED_INTERRUPT_LEVEL, 0 );
+
     /**
      * Configure the global features of the ADC
      * (Clock, Resolution, Data Alignment and number of conversion)
@@ -593,6 +818,183 @@ int32_t TCD_PORT_ADC_Start(uint16_t *dataBuffer)
     return (int32_t) HAL_ADC_Start_DMA( &hadc3, (uint32_t *) dataBuffer, CFG_CCD_NUM_PIXELS );
 }
 
+/*******************************************************************************
+ * @brief   Start the ADC with DMA transfer in double buffer mode
+ * @param   *dataBuffer0, uint16_t: Pointer to the first data buffer in RAM
+ * @param   *dataBuffer1, uint16_t: Pointer to the second data buffer in RAM
+ * @retval  Error codes
+ *
+ * The DMA stream is configured with the double buffer mode (DBM) where M0AR and
+ * M1AR hold the two buffer addresses. The DMA hardware swaps the target buffer
+ * at every transfer complete, so the readout that just finished is left
+ * untouched while the next readout is written to the other buffer.
+ *
+ ******************************************************************************/
+int32_t TCD_PORT_ADC_StartDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1)
+{
+    __IO uint32_t counter;
+
+    if ( (dataBuffer0 == NULL) || (dataBuffer1 == NULL) )
+    {
+        return -1;
+    }
+
+    /* Enable the ADC and wait for the stabilization time */
+    if ( (hadc3.Instance->CR2 & ADC_CR2_ADON) != ADC_CR2_ADON )
+    {
+        __HAL_ADC_ENABLE( &hadc3 );
+
+        counter = ADC_STAB_DELAY_US * (SystemCoreClock / 1000000U);
+        while ( counter != 0U )
+        {
+            counter--;
+        }
+    }
+
+    /* Clear stale conversion flags and let the ADC issue DMA requests */
+    __HAL_ADC_CLEAR_FLAG( &hadc3, ADC_FLAG_EOC | ADC_FLAG_OVR );
+    hadc3.Instance->CR2 |= ADC_CR2_DMA;
+
+    adc_restart = 0U;
+    if ( HAL_DMAEx_MultiBufferStart_IT( &hdma_adc3,
+                                        (uint32_t) &hadc3.Instance->DR,
+                                        (uint32_t) dataBuffer0,
+                                        (uint32_t) dataBuffer1,
+                                        CFG_CCD_NUM_PIXELS ) != HAL_OK )
+    {
+        return -1;
+    }
+
+    /* The stream runs in direct mode, a FIFO error is of no interest */
+    hdma_adc3.Instance->FCR &= ~DMA_SxFCR_FEIE;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * @brief   Get the index of the data buffer holding the last completed readout
+ * @param   None
+ * @retval  0 for dataBuffer0, 1 for dataBuffer1
+ *
+ * The current target (CT) bit points to the buffer the DMA is filling now,
+ * hence the completed buffer is the other one. Always 0 in single buffer mode.
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE uint32_t TCD_PORT_ADC_GetCompletedBuffer(void)
+{
+    if ( (hdma_adc3.Instance->CR & DMA_SxCR_DBM) == 0U )
+    {
+        return 0U;
+    }
+
+    return ((hdma_adc3.Instance->CR & DMA_SxCR_CT) != 0U) ? 0U : 1U;
+}
+
+/*******************************************************************************
+ * @brief   Check for a readout not yet passed to TCD_ReadCompletedCallback()
+ * @param   None
+ * @retval  1 while the ADC trigger timer runs or the transfer complete
+ *          interrupt is pending, 0 otherwise
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE uint32_t TCD_PORT_ADC_IsReadoutPending(void)
+{
+    if ( ((TCD_ADC_TRIG_TIMER->CR1 & TIM_CR1_CEN) != 0U) ||
+         ((TCD_ADC_DMA->LISR & TCD_ADC_DMA_FLAG_TC) != 0U) )
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+
+/*******************************************************************************
+ * @brief   Set the data buffer of one of the DMA memories in double buffer mode
+ * @param   buffer, uint32_t: DMA memory index; 0 for M0AR and 1 for M1AR
+ * @param   *dataBuffer, uint16_t: Pointer to the new data location in RAM
+ * @retval  None
+ *
+ * Only the memory that is not the current target may be changed. Call this
+ * from TCD_ReadCompletedCallback() with the index of the completed buffer.
+ * The new address is used when the DMA swaps back to this memory.
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_PORT_ADC_SetBuffer(uint32_t buffer, uint16_t *dataBuffer)
+{
+    if ( buffer == 0U )
+    {
+        hdma_adc3.Instance->M0AR = (uint32_t) dataBuffer;
+    }
+    else
+    {
+        hdma_adc3.Instance->M1AR = (uint32_t) dataBuffer;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Request the deferred frame processing to run
+ * @param   None
+ * @retval  None
+ *
+ * Pends the PendSV exception. It runs at DEFERRED_INTERRUPT_LEVEL as soon as
+ * all higher priority interrupts have returned.
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_PORT_RequestDeferredProcessing(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/*******************************************************************************
+ * @brief   Enable the DWT cycle counter
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_CycleCounter_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U;     /* Unlock the DWT registers on Cortex-M7 */
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+ * @brief   Get the DWT cycle counter
+ * @param   None
+ * @retval  The CPU cycles since the counter was enabled, wraps around at 2^32.
+ *
+ ******************************************************************************/
+uint32_t TCD_PORT_CycleCounter_Get(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+ * @brief   Get the cycle count of the ADC+DMA interrupt handler
+ * @param   cycles, uint32_t: Last measurement
+ * @param   maxCycles, uint32_t: Maximum measurement
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_GetIrqCycles(uint32_t *cycles, uint32_t *maxCycles)
+{
+    *cycles = irq_cycles;
+    *maxCycles = irq_max_cycles;
+}
+
+/*******************************************************************************
+ * @brief   Reset the cycle count of the ADC+DMA interrupt handler
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_PORT_ADC_ResetIrqCycles(void)
+{
+    irq_cycles = 0U;
+    irq_max_cycles = 0U;
+}
+
 /**
  *******************************************************************************
  *                        PRIVATE IMPLEMENTATION SECTION
@@ -604,25 +1006,38 @@ int32_t TCD_PORT_ADC_Start(uint16_t *dataBuffer)
  * to remove function call overheads.
  */
 /*******************************************************************************
- * @brief   Enable the timer that generates ADC trigger signal
+ * @brief   Disable the timer that generates ADC trigger signal
  * @param   None
  * @retval  None
  *
  ******************************************************************************/
-static void TCD_PORT_EnableADCTrigger(void)
+static void TCD_PORT_DisableADCTrigger(void)
 {
-    TCD_ADC_TRIG_TIMER->CR1 |= TIM_CR1_CEN;
+    TCD_ADC_TRIG_TIMER->CR1 &= ~TIM_CR1_CEN;
 }
 
 /*******************************************************************************
- * @brief   Disable the timer that generates ADC trigger signal
+ * @brief   Re-arm the ADC DMA stream after a transfer error
  * @param   None
  * @retval  None
  *
+ * The stream was disabled by the hardware. The memory addresses and the
+ * current target are kept, so the next readout overwrites the buffer of the
+ * aborted one. The ADC stops its DMA requests after an overrun, which the
+ * rest of the aborted readout has caused.
+ *
  ******************************************************************************/
-static void TCD_PORT_DisableADCTrigger(void)
+TCD_ITCM_CODE static void TCD_PORT_ADC_Restart(void)
 {
-    TCD_ADC_TRIG_TIMER->CR1 &= ~TIM_CR1_CEN;
+    hadc3.Instance->CR2 &= ~ADC_CR2_DMA;
+    __HAL_ADC_CLEAR_FLAG( &hadc3, ADC_FLAG_EOC | ADC_FLAG_OVR );
+    hadc3.Instance->CR2 |= ADC_CR2_DMA;
+
+    /* HAL_DMA_IRQHandler() disables the transfer error interrupt */
+    TCD_ADC_DMA->LIFCR = TCD_ADC_DMA_FLAGS;
+    hdma_adc3.Instance->NDTR = CFG_CCD_NUM_PIXELS;
+    hdma_adc3.Instance->CR |= DMA_SxCR_TEIE;
+    hdma_adc3.Instance->CR |= DMA_SxCR_EN;
 }
 
 /*******************************************************************************
@@ -647,55 +1062,206 @@ static void TCD_PORT_SH_SetDelay(uint32_t cnt)
     TCD_ICG_TIMER->CNT = cnt;
 }
 
-/**
- *******************************************************************************
- *                         INTERRUPT HANDLERS
- *******************************************************************************
- */
-
 /*******************************************************************************
- * @brief   This function handles ICG PULSE interrupt.
- * @param   None
- * @retval  None
+ * @brief   Get the clock frequency a timer counts with
+ * @param   tim, TIM_TypeDef: Timer instance
+ * @retval  Frequency in Hz
  *
- * When the ICG TIMER has generated an ICG pulse to start moving out charges
- * from the CCD, an interrupt request (TIMx_IRQ) is generated.
+ * The timers get the APB clock times 1 when the APB prescaler is 1, else
+ * times 2. With TIMPRE set it is times 4, but at most HCLK.
+ ******************************************************************************/
+static uint32_t TCD_PORT_GetTimerClock(const TIM_TypeDef *tim)
+{
+    uint32_t pclk;
+    uint32_t ppre;
+
+    if ( (tim == TIM1) || (tim == TIM8) || (tim == TIM9) || (tim == TIM10) || (tim == TIM11) )
+    {
+        pclk = HAL_RCC_GetPCLK2Freq();
+        ppre = (RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+    }
+    else
+    {
+        pclk = HAL_RCC_GetPCLK1Freq();
+        ppre = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    }
+
+    /* PPRE values 0..3 are a divider of 1, 4..7 divide by 2, 4, 8 and 16 */
+    if ( ppre < 4U )
+    {
+        return pclk;
+    }
+
+    if ( (RCC->DCKCFGR1 & RCC_DCKCFGR1_TIMPRE) != 0U )
+    {
+        return (ppre <= 5U) ? HAL_RCC_GetHCLKFreq() : (pclk * 4U);
+    }
+
+    return pclk * 2U;
+}
+
+/*******************************************************************************
+ * @brief   Get the divider of the master clock timer
+ * @param   freq, uint32_t: Requested master clock in Hz
+ * @retval  Timer clock cycles per master clock period, rounded to nearest
  *
- * This interrupt handler function is to start the ADC+DMA acquisition of
- * CFG_CCD_NUM_PIXELS ADC samples. This is 3694 for the TCD1304 sensor.
- * When this acquisition is finished, a new interrupt is generated;
- * TCD_CCD_ADC_INTERRUPT_HANDLER().
+ ******************************************************************************/
+static uint32_t TCD_PORT_FM_GetCycles(uint32_t freq)
+{
+    uint32_t clock = TCD_PORT_GetTimerClock( TCD_MCLK_TIMER );
+
+    return (clock + (freq / 2U)) / freq;
+}
+
+/*******************************************************************************
+ * @brief   Convert microseconds to timer ticks, rounded up
+ * @param   us, uint32_t: Time in microseconds
+ * @param   clock, uint32_t: Timer clock in Hz
+ * @param   prescaler, uint32_t: Timer clock divider, PSC + 1
+ * @retval  Timer ticks
  *
  ******************************************************************************/
-void TCD_ICG_TIMER_INTERRUPT_HANDLER(void)
+static uint32_t TCD_PORT_UsToTicks(uint32_t us, uint32_t clock, uint32_t prescaler)
 {
-    TCD_PORT_EnableADCTrigger();
+    uint64_t cycles = ((uint64_t) us * clock + 999999U) / 1000000U;
 
-    HAL_TIM_IRQHandler( &htim2 );
+    return (uint32_t) ((cycles + prescaler - 1U) / prescaler);
 }
 
+#if ( CFG_PROFILING == 1U )
+/*******************************************************************************
+ * @brief   Store the cycles of the ADC+DMA interrupt handler
+ * @param   start, uint32_t: Cycle counter at the entry of the handler
+ * @retval  None
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE static void TCD_PORT_UpdateIrqCycles(uint32_t start)
+{
+    irq_cycles = TCD_PORT_CycleCounter_Get() - start;
+    if ( irq_cycles > irq_max_cycles )
+    {
+        irq_max_cycles = irq_cycles;
+    }
+}
+#endif
+
+/**
+ *******************************************************************************
+ *                         INTERRUPT HANDLERS
+ *******************************************************************************
+ */
+
 /*******************************************************************************
  * @brief   This function handles ADC+DMA acquisition complete interrupt.
  * @param   None
  * @retval  None
  *
  * The ADC+DMA acquisition of CFG_CCD_NUM_PIXELS samples were started in
- * TCD_ICG_TIMER_INTERRUPT_HANDLER().
+ * hardware by the ICG timer, see TCD_PORT_ADC_ConfigTrigger().
  *
  * When the DMA transfer has completed an interrupt request (DMAX_StreamX_IRQ)
  * is generated.
  * This is the interrupt handler for that request. Following is done:
- * 1) Disable the ADC trigger signal (TCD_ADC_TRIG_TIMER).
- * 2) Let the HAL layer handle the DMA interrupt request
+ * 1) Find the data buffer that holds the completed readout
+ * 2) Clear the DMA interrupt flags, or let the HAL layer handle the DMA
+ *    interrupt request if CFG_HAL_IRQ_HANDLERS is set
  * 3) Call the user callback function to deal with the acquired ADC samples.
  *
  ******************************************************************************/
-void TCD_CCD_ADC_INTERRUPT_HANDLER(void)
+TCD_ITCM_CODE void TCD_CCD_ADC_INTERRUPT_HANDLER(void)
 {
+#if ( CFG_PROFILING == 1U )
+    uint32_t start = TCD_PORT_CycleCounter_Get();
+#endif
+#if ( CFG_HAL_IRQ_HANDLERS == 1U )
+    uint32_t buffer = TCD_PORT_ADC_GetCompletedBuffer();
+    uint32_t flags = TCD_ADC_DMA->LISR & TCD_ADC_DMA_FLAGS;
+
     HAL_DMA_IRQHandler( &hdma_adc3 );
 
-    /* Do something with the acquired AD samples in RAM */
-    TCD_ReadCompletedCallback();
+    if ( (flags & TCD_ADC_DMA_FLAG_TE) != 0U )
+    {
+        adc_restart = 1U;
+        TCD_PORT_ICG_EnableInterrupt();
+        TCD_ReadErrorCallback();
+    }
+    else
+    {
+        /* Do something with the acquired AD samples in RAM */
+        TCD_ReadCompletedCallback( buffer );
+    }
+#else
+    /**
+     * Only transfer complete and transfer error are used. A transfer error
+     * disables the stream in hardware, it is re-armed by the ICG interrupt
+     * before the next readout.
+     */
+    uint32_t flags = TCD_ADC_DMA->LISR & TCD_ADC_DMA_FLAGS;
+    TCD_ADC_DMA->LIFCR = flags;
+
+    if ( (flags & TCD_ADC_DMA_FLAG_TE) != 0U )
+    {
+        adc_restart = 1U;
+        TCD_PORT_ICG_EnableInterrupt();
+        TCD_ReadErrorCallback();
+    }
+    else if ( (flags & TCD_ADC_DMA_FLAG_TC) != 0U )
+    {
+        /* Do something with the acquired AD samples in RAM */
+        TCD_ReadCompletedCallback( TCD_PORT_ADC_GetCompletedBuffer() );
+    }
+#endif
+#if ( CFG_PROFILING == 1U )
+    TCD_PORT_UpdateIrqCycles( start );
+#endif
+}
+
+/*******************************************************************************
+ * @brief   This function handles the ICG timer compare interrupt.
+ * @param   None
+ * @retval  None
+ *
+ * Channel 2 of the ICG timer matches in the last SH period before each ICG
+ * pulse, see TCD_PORT_SetTiming(). The driver commits a new configuration
+ * here. A DMA stream stopped by a transfer error is re-armed here as well,
+ * once the ADC trigger timer has finished the aborted readout. The interrupt
+ * is disabled again when neither is left to do.
+ *
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_ICG_INTERRUPT_HANDLER(void)
+{
+    uint32_t staged;
+
+    /* The status bits are cleared by writing 0 */
+    TCD_ICG_TIMER->SR = ~TIM_SR_CC2IF;
+
+    if ( (adc_restart != 0U) && ((TCD_ADC_TRIG_TIMER->CR1 & TIM_CR1_CEN) == 0U) )
+    {
+        adc_restart = 0U;
+        TCD_PORT_ADC_Restart();
+    }
+
+    staged = TCD_IcgCallback();
+
+    if ( (staged == 0U) && (adc_restart == 0U) )
+    {
+        TCD_ICG_TIMER->DIER &= ~TIM_DIER_CC2IE;
+    }
+}
+
+/*******************************************************************************
+ * @brief   This function handles the deferred frame processing.
+ * @param   None
+ * @retval  None
+ *
+ * PendSV is pended by TCD_PORT_RequestDeferredProcessing() from the ADC+DMA
+ * interrupt handler. Accumulation and averaging of the queued frames is done
+ * here, at a lower priority than all acquisition interrupts.
+ *
+ ******************************************************************************/
+void TCD_DEFERRED_INTERRUPT_HANDLER(void)
+{
+    TCD_ProcessCompletedFrames();
 }
 
 /**
@@ -53,6 +53,23 @@ extern "C"
 #include "stm32f7xx_hal.h"
 
 /* Exported typedefs ---------------------------------------------------------*/
+
+/**
+ * Register values of the ICG and SH timers for one pair of periods, see
+ * TCD_PORT_SolveTiming(). The two timers share the prescaler, so the ICG
+ * period is exactly N SH periods also after quantization.
+ */
+typedef struct
+{
+    uint32_t prescaler;             /* Timer clock divider, PSC + 1           */
+    uint32_t icgTicks;              /* ICG period, ARR + 1                    */
+    uint32_t shTicks;               /* SH period, ARR + 1                     */
+    uint32_t icgPulseTicks;
+    uint32_t shPulseTicks;
+    int32_t  t_icg_err_ns;          /* Achieved minus requested ICG period    */
+    int32_t  t_int_err_ns;          /* Achieved minus requested SH period     */
+} TCD_PORT_TIMING_t;
+
 /* Exported defines ----------------------------------------------------------*/
 
 /**
@@ -65,13 +82,38 @@ extern "C"
 #define TCD_SH_TIMER                        (TIM14)
 #define TCD_ADC_TRIG_TIMER                  (TIM8)
 
+/**
+ * TIM14 has a 16 bit counter and TIM2 a 32 bit counter. The solver tries this
+ * many prescalers from the smallest one that fits the SH period in the counter.
+ */
+#define TCD_SH_TIMER_MAX_TICKS              (0x10000U)
+#define TCD_ICG_TIMER_MAX_TICKS             (0xFFFFFFFFU)
+#define TCD_TIMER_MAX_PRESCALER             (0x10000U)
+#define TCD_PRESCALER_SEARCH                (256U)
+
+/**
+ *******************************************************************************
+ *                         DMA DEFINITIONS
+ *******************************************************************************
+ *
+ * The ADC data is moved by DMA2 Stream0. The interrupt flags of streams 0..3
+ * are in the LISR register and cleared in LIFCR at the same bit positions.
+ */
+#define TCD_ADC_DMA                         (DMA2)
+#define TCD_ADC_DMA_FLAG_TC                 (DMA_LISR_TCIF0)
+#define TCD_ADC_DMA_FLAG_TE                 (DMA_LISR_TEIF0)
+#define TCD_ADC_DMA_FLAGS                   (DMA_LISR_TCIF0 | DMA_LISR_HTIF0 | \
+                                             DMA_LISR_TEIF0 | DMA_LISR_DMEIF0 | \
+                                             DMA_LISR_FEIF0)
+
 /**
  *******************************************************************************
  *                         INTERRUPT HANDLERS
  *******************************************************************************
  */
-#define TCD_ICG_TIMER_INTERRUPT_HANDLER     TIM2_IRQHandler
 #define TCD_CCD_ADC_INTERRUPT_HANDLER       DMA2_Stream0_IRQHandler
+#define TCD_ICG_INTERRUPT_HANDLER           TIM2_IRQHandler
+#define TCD_DEFERRED_INTERRUPT_HANDLER      PendSV_Handler
 
 /**
  *******************************************************************************
@@ -81,11 +123,42 @@ extern "C"
  * In STM32 MCU 4 interrupt priority bits are implemented. This means that
  * the lowest (highest value) interrupt priority is 15 (0x0F).
  * We set:
- * TIM_ICG_INTERRUPT_LEVEL to default value = 6.
  * DMA_ADC_INTERRUPT_LEVEL to default value = 5.
+ * DEFERRED_INTERRUPT_LEVEL to the lowest level = 15, so frame processing in
+ * PendSV never blocks any other interrupt.
+ * ICG_INTERRUPT_LEVEL equal to the ADC level. The two handlers never preempt
+ * each other, so the ICG handler sees every readout either counted or pending.
  */
-#define TIM_ICG_INTERRUPT_LEVEL             (6U)
 #define DMA_ADC_INTERRUPT_LEVEL             (5U)
+#define ICG_INTERRUPT_LEVEL                 (DMA_ADC_INTERRUPT_LEVEL)
+#define DEFERRED_INTERRUPT_LEVEL            (15U)
+
+/**
+ *******************************************************************************
+ *                         MEMORY PLACEMENT
+ *******************************************************************************
+ *
+ * The D-cache of the Cortex-M7 is not coherent with the DMA. Buffers written
+ * by the DMA are placed in the .dma_buffer section, which the linker puts in
+ * a RAM region that the MPU configures as non-cacheable.
+ *
+ * The interrupt chain of the readout runs from the zero wait state ITCM RAM
+ * instead of flash (FLASH_LATENCY_7), and the accumulators live in the DTCM
+ * RAM. The startup code copies .itcm_text from flash and zeroes .dtcm_bss.
+ */
+#define TCD_DMA_BUFFER                      __attribute__((section(".dma_buffer")))
+#define TCD_ITCM_CODE                       __attribute__((section(".itcm_text")))
+#define TCD_DTCM_DATA                       __attribute__((section(".dtcm_bss")))
+
+/**
+ *******************************************************************************
+ *                         MEMORY ORDERING
+ *******************************************************************************
+ *
+ * Orders the sequence counter of the averaged data against the data itself
+ * between the deferred processing and the main loop.
+ */
+#define TCD_MEMORY_BARRIER()                __DMB()
 
 /**
  *******************************************************************************
@@ -109,18 +182,61 @@ void    TCD_PORT_Stop(void);
 int32_t TCD_PORT_FM_ConfigClock(const uint32_t freq);
 int32_t TCD_PORT_SH_ConfigClock(const uint32_t t_int_us);
 int32_t TCD_PORT_ICG_ConfigClock(const uint32_t t_icg_us);
+int32_t TCD_PORT_SolveTiming(uint32_t t_icg_us, uint32_t t_int_us, TCD_PORT_TIMING_t *timing);
+void    TCD_PORT_SetTiming(const TCD_PORT_TIMING_t *timing);
+void    TCD_PORT_ICG_EnableInterrupt(void);
+uint32_t TCD_PORT_FM_GetFrequency(void);
 
 int32_t TCD_PORT_ADC_Init(void);
 void    TCD_PORT_ADC_ConfigTrigger(uint32_t f_adc);
 int32_t TCD_PORT_ADC_Start(uint16_t *dataBuffer);
+int32_t TCD_PORT_ADC_StartDoubleBuffer(uint16_t *dataBuffer0, uint16_t *dataBuffer1);
+uint32_t TCD_PORT_ADC_GetCompletedBuffer(void);
+uint32_t TCD_PORT_ADC_IsReadoutPending(void);
+void    TCD_PORT_ADC_SetBuffer(uint32_t buffer, uint16_t *dataBuffer);
+void    TCD_PORT_RequestDeferredProcessing(void);
+
+void    TCD_PORT_CycleCounter_Init(void);
+uint32_t TCD_PORT_CycleCounter_Get(void);
+void    TCD_PORT_ADC_GetIrqCycles(uint32_t *cycles, uint32_t *maxCycles);
+void    TCD_PORT_ADC_ResetIrqCycles(void);
 
 /**
  * This function is called when a complete CCD sensor readout is finished.
  * This function is called in the interrupt handler of the portable layer.
  * The tcd1304.c implements what should be done in this function.
  *
+ * The buffer parameter is the index of the data buffer holding the completed
+ * readout; 0 for dataBuffer0 and 1 for dataBuffer1. Always 0 in single
+ * buffer mode.
+ */
+void TCD_ReadCompletedCallback(uint32_t buffer);
+
+/**
+ * This function is called in the interrupt handler of the portable layer when
+ * a readout is lost to a DMA transfer error. The DMA is re-armed before the
+ * next readout.
+ * The tcd1304.c implements what should be done in this function.
+ */
+void TCD_ReadErrorCallback(void);
+
+/**
+ * This function is called in the deferred processing context of the portable
+ * layer after TCD_PORT_RequestDeferredProcessing() has been called.
+ * The tcd1304.c implements what should be done in this function.
+ *
+ */
+void TCD_ProcessCompletedFrames(void);
+
+/**
+ * This function is called in the interrupt handler of the portable layer in
+ * the last SH period before an ICG pulse, after TCD_PORT_ICG_EnableInterrupt()
+ * has been called. Timer values passed to TCD_PORT_SetTiming() here take
+ * effect at that ICG pulse. It returns 1 while it must be called again at the
+ * next ICG pulse, 0 when the interrupt can be disabled.
+ * The tcd1304.c implements what should be done in this function.
  */
-void TCD_ReadCompletedCallback(void);
+uint32_t TCD_IcgCallback(void);
 
 #ifdef __cplusplus
 }
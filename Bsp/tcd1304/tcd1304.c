@@ -47,29 +47,109 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "tcd1304.h"
+#include "tcd1304_dsp.h"
 
 /* Private typedef -----------------------------------------------------------*/
+
+/**
+ * Single-producer/single-consumer ring of frame buffer indices.
+ * The head is only written by the producer and the tail only by the consumer,
+ * so no locking is needed as long as each side stays in its own context.
+ */
+typedef struct
+{
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint8_t frame[ CFG_FRAME_QUEUE_SIZE ];
+} TCD_FRAME_RING_t;
+
 typedef struct
 {
     TCD_DATA_t data;
     uint8_t readyToRun;
+    uint8_t running;
     volatile uint8_t dataReady;
     volatile uint32_t counter;
+    uint32_t avg;                   /* Averaging latched for the current block */
+    TCD_DSP_DIVIDER_t divider;
+    TCD_AVG_MODE_t mode;            /* Averaging mode of the current state     */
+    uint32_t boxcarHead;            /* History slot of the oldest frame        */
     uint64_t totalSpectrumsAcquired;
+    TCD_CONFIG_t active;            /* Configuration of the averaged frames    */
+    uint32_t numWindows;            /* Windows of active, 1 for all pixels     */
+    TCD_WINDOW_t window[ CFG_MAX_WINDOWS ];
+    uint32_t pixelCount;            /* Output values, pixels or bins           */
+
+    /**
+     * Reconfiguration, see TCD_Reconfigure(). The main loop writes staged,
+     * the ICG interrupt moves it to committed and the frame processing makes
+     * it active at the first frame acquired with it.
+     */
+    TCD_CONFIG_t staged;
+    TCD_PORT_TIMING_t stagedTiming; /* Timer settings of staged                */
+    volatile uint32_t stageSequence;    /* Odd while staged is being written */
+    uint32_t stageTaken;            /* stageSequence of the last commit        */
+    TCD_CONFIG_t committed;
+    TCD_PORT_TIMING_t committedTiming;
+    uint32_t committedFrame;        /* Stamp of the first frame acquired with it */
+    volatile uint8_t committedValid;
+
+    /* Odd while SensorDataAvg is being updated, see TCD_ReadSensorDataAvg() */
+    volatile uint32_t avgSequence;
+    TCD_DATA_INFO_t avgInfo;        /* Parameters of SensorDataAvg             */
+
+    /* Frame buffer bookkeeping */
+    uint8_t dmaFrame[ 2 ];          /* Frame buffers owned by DMA memory 0 and 1 */
+    uint32_t frameStamp[ CFG_ADC_NUM_BUFFERS ]; /* Readout number of each frame */
+    TCD_FRAME_RING_t readyRing;     /* Completed frames. ISR -> processing      */
+    TCD_FRAME_RING_t freeRing;      /* Released frames. Processing -> ISR       */
+    volatile uint32_t queueHighWater;
+    volatile uint32_t framesDropped;
+    volatile uint32_t readErrors;
+
+    TCD_PROFILE_t profile;
 } TCD_PCB_t;
 
 /* Private define ------------------------------------------------------------*/
+#define TCD_FRAME_RING_MASK             (CFG_FRAME_QUEUE_SIZE - 1U)
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static TCD_CONFIG_t *TCD_config;
-static TCD_PCB_t TCD_pcb;
+static TCD_PCB_t TCD_pcb TCD_DTCM_DATA;
+
+/* Boxcar history, too large for the DTCM */
+static uint16_t TCD_boxcarHistory[ CFG_BOXCAR_MAX_FRAMES ][ CFG_CCD_NUM_PIXELS ];
+
+/* ADC frame buffers written by the DMA */
+static uint16_t TCD_frameBuffer[ CFG_ADC_NUM_BUFFERS ][ CFG_CCD_NUM_PIXELS ] TCD_DMA_BUFFER;
 
 /* Private function prototypes -----------------------------------------------*/
 static TCD_ERR_t TCD_FM_Init(void);
 static TCD_ERR_t TCD_ICG_Init(void);
 static TCD_ERR_t TCD_SH_Init(void);
 static TCD_ERR_t TCD_ADC_Init(void);
+static void TCD_FrameQueue_Init(void);
+static TCD_ERR_t TCD_CheckConfig(const TCD_CONFIG_t *config);
+static TCD_ERR_t TCD_CheckWindows(const TCD_CONFIG_t *config);
+static TCD_ERR_t TCD_CheckBinning(const TCD_CONFIG_t *config);
+static void TCD_SetActive(const TCD_CONFIG_t *config);
+static void TCD_CommitStaged(uint32_t firstFrame);
+static void TCD_ApplyCommitted(uint32_t stamp);
+static uint8_t TCD_FrameRing_Push(TCD_FRAME_RING_t *ring, uint8_t frame);
+static uint8_t TCD_FrameRing_Pop(TCD_FRAME_RING_t *ring, uint8_t *frame);
+static void TCD_AccumulateFrame(const uint16_t *sensorData);
+static void TCD_AverageBlock(const uint16_t *sensorData);
+static void TCD_AverageBoxcar(const uint16_t *sensorData);
+static void TCD_AverageEma(const uint16_t *sensorData);
+static void TCD_BinWindows(const uint32_t *accu, const uint16_t *data,
+                           const TCD_DSP_DIVIDER_t *div);
+static void TCD_PublishAverage(uint32_t avg);
+#if ( CFG_PROFILING == 1U )
+static void TCD_Profile_Update(uint32_t *cycles, uint32_t *maxCycles, uint32_t start);
+#endif
 
 /* External functions --------------------------------------------------------*/
 
@@ -98,6 +178,14 @@ TCD_ERR_t TCD_Init(TCD_CONFIG_t *config)
         TCD_config = config;
     }
 
+    if ( (TCD_CheckWindows( config ) != TCD_OK) || (TCD_CheckBinning( config ) != TCD_OK) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    /* Hand out the frame buffers before the DMA starts to use them */
+    TCD_FrameQueue_Init();
+
     /* Configure and start the ADC + DMA */
     err = TCD_ADC_Init();
     if ( err != TCD_OK )
@@ -128,8 +216,14 @@ TCD_ERR_t TCD_Init(TCD_CONFIG_t *config)
 
     /* Set the process controll block to initial values */
     TCD_pcb.counter = 0U;
+    TCD_pcb.avg = 0U;
     TCD_pcb.totalSpectrumsAcquired = 0U;
+    TCD_SetActive( config );
+    TCD_pcb.stageSequence = 0U;
+    TCD_pcb.stageTaken = 0U;
+    TCD_pcb.committedValid = 0U;
     TCD_pcb.readyToRun = 1U;
+    TCD_pcb.running = 0U;
     TCD_pcb.dataReady = 0U;
 
     return err;
@@ -145,8 +239,18 @@ TCD_ERR_t TCD_Start(void)
 {
     if ( TCD_pcb.readyToRun == 1U )
     {
+        /* A configuration staged before the stop applies from the first frame */
+        TCD_CommitStaged( (uint32_t) TCD_pcb.totalSpectrumsAcquired + 1U );
+
         /* Start to generate ICG and SH pulses */
         TCD_PORT_Run();
+        TCD_pcb.running = 1U;
+
+        /* Still waiting for the previous configuration to reach the averaging */
+        if ( TCD_pcb.stageSequence != TCD_pcb.stageTaken )
+        {
+            TCD_PORT_ICG_EnableInterrupt();
+        }
         return TCD_OK;
     }
     else
@@ -167,6 +271,7 @@ TCD_ERR_t TCD_Stop(void)
     {
         /* Stop to generate ICG and SH pulses */
         TCD_PORT_Stop();
+        TCD_pcb.running = 0U;
         return TCD_OK;
     }
     else
@@ -180,48 +285,178 @@ TCD_ERR_t TCD_Stop(void)
  * @param   config, TCD_CONFIG_t: Struct holding configuration for the TCD1304.
  * @retval  TCD_OK on success or TCD_ERR_t error codes.
  *
- * Make sure that the ICG and SH pulses overlap.
+ * Make sure that the ICG and SH pulses overlap. t_int_us is rounded up to
+ * the next divisor of t_icg_us, and the configuration is applied with
+ * TCD_Reconfigure(). config is only updated on success.
  ******************************************************************************/
 TCD_ERR_t TCD_SetIntTime(TCD_CONFIG_t *config)
 {
-    if ( TCD_pcb.readyToRun == 1U )
+    TCD_CONFIG_t rounded;
+    TCD_ERR_t err;
+
+    if ( config == NULL )
     {
-        TCD_PORT_Stop();
+        return TCD_ERR_NULL_POINTER;
+    }
+
+    if ( (config->t_int_us < CFG_SH_MIN_PERIOD_US) || (config->t_int_us > config->t_icg_us) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
 
-        /* Find the first valid integration time */
-        uint32_t remainder;
-        uint32_t t_int_us = config->t_int_us;
+    /* Find the first valid integration time */
+    uint32_t remainder;
+    uint32_t t_int_us = config->t_int_us;
 
-        do
-        {
-            remainder = config->t_icg_us % t_int_us;
-            t_int_us++;
-        }
-        while ( (remainder != 0U) && (t_int_us <= config->t_icg_us) );
+    do
+    {
+        remainder = config->t_icg_us % t_int_us;
+        t_int_us++;
+    }
+    while ( (remainder != 0U) && (t_int_us <= config->t_icg_us) );
 
-        if ( config->t_int_us <= config->t_icg_us )
-        {
-            config->t_int_us = t_int_us - 1U;
+    rounded = *config;
+    rounded.t_int_us = t_int_us - 1U;
+
+    err = TCD_Reconfigure( &rounded );
+    if ( err == TCD_OK )
+    {
+        config->t_int_us = rounded.t_int_us;
+    }
 
-            TCD_SH_Init();
-            TCD_PORT_Run();
+    return err;
+}
 
-            return TCD_OK;
-        }
-        else
-        {
-            return TCD_ERR_PARAM_OUT_OF_RANGE;
-        }
+/*******************************************************************************
+ * @Brief   Change the configuration without stopping the acquisition
+ * @param   config, TCD_CONFIG_t: The complete new configuration
+ * @retval  TCD_OK on success or TCD_ERR_t error codes.
+ *
+ * The configuration is checked as a whole and staged. Shortly before the next
+ * ICG pulse the portable layer loads the new ICG and SH periods into the
+ * preload registers of the timers, which switch both at the ICG pulse. The
+ * frame read out at that pulse was still exposed with the old SH period; the
+ * averaging restarts with the frame after it. A later call before the commit
+ * replaces the staged configuration.
+ *
+ * f_master can only be set by TCD_Init(). When the acquisition is stopped
+ * the configuration applies at once.
+ ******************************************************************************/
+TCD_ERR_t TCD_Reconfigure(const TCD_CONFIG_t *config)
+{
+    TCD_PORT_TIMING_t timing;
+    TCD_ERR_t err;
+
+    if ( config == NULL )
+    {
+        return TCD_ERR_NULL_POINTER;
     }
-    else
+
+    if ( TCD_pcb.readyToRun == 0U )
     {
         return TCD_ERR_NOT_INITIALIZED;
     }
+
+    err = TCD_CheckConfig( config );
+    if ( err != TCD_OK )
+    {
+        return err;
+    }
+
+    /* Solved here, the ICG interrupt only writes the registers */
+    if ( TCD_PORT_SolveTiming( config->t_icg_us, config->t_int_us, &timing ) != 0 )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    /* The ICG interrupt skips a configuration that is being written */
+    TCD_pcb.stageSequence++;
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.staged = *config;
+    TCD_pcb.stagedTiming = timing;
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.stageSequence++;
+
+    if ( TCD_pcb.running == 0U )
+    {
+        TCD_CommitStaged( (uint32_t) TCD_pcb.totalSpectrumsAcquired + 1U );
+    }
+    else
+    {
+        /* The ICG interrupt only runs while a configuration is staged */
+        TCD_PORT_ICG_EnableInterrupt();
+    }
+
+    return TCD_OK;
 }
 
 /*******************************************************************************
- * @brief   Handle sensor data when the ADC+DMA has samples all pixels.
+ * @Brief   Check if a configuration is staged but not yet in use
+ * @param   None
+ * @retval  1U while the last TCD_Reconfigure() has not reached the averaging
+ *
+ ******************************************************************************/
+uint8_t TCD_IsReconfigurePending(void)
+{
+    return ((TCD_pcb.stageSequence != TCD_pcb.stageTaken) ||
+            (TCD_pcb.committedValid == 1U)) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @Brief   Get the periods the timers generate for a configuration
+ * @param   config, TCD_CONFIG_t: The configuration, e.g. the one in use
+ * @param   timing, TCD_TIMING_t: Achieved periods and their errors
+ * @retval  TCD_OK on success or TCD_ERR_t error codes.
+ *
+ * The timers divide the clocks of the MCU by integers, so a period is only
+ * exact when it is a whole number of timer ticks. f_master is the one set by
+ * TCD_Init().
+ ******************************************************************************/
+TCD_ERR_t TCD_GetTiming(const TCD_CONFIG_t *config, TCD_TIMING_t *timing)
+{
+    TCD_PORT_TIMING_t port;
+
+    if ( (config == NULL) || (timing == NULL) )
+    {
+        return TCD_ERR_NULL_POINTER;
+    }
+
+    if ( TCD_PORT_SolveTiming( config->t_icg_us, config->t_int_us, &port ) != 0 )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    timing->f_master = TCD_PORT_FM_GetFrequency();
+    timing->f_master_err_hz = (int32_t) (timing->f_master - config->f_master);
+    timing->t_int_us = config->t_int_us;
+    timing->t_int_err_ns = port.t_int_err_ns;
+    timing->t_icg_us = config->t_icg_us;
+    timing->t_icg_err_ns = port.t_icg_err_ns;
+
+    return TCD_OK;
+}
+
+/*******************************************************************************
+ * @brief   Commit a staged configuration at the coming ICG pulse
  * @param   None
+ * @retval  1U while a staged configuration still waits for a later ICG pulse
+ *
+ * Called from the ICG interrupt of the portable layer, see tcd1304_port.h.
+ * The frames up to the one read out at the coming ICG pulse are acquired
+ * with the old configuration. The readout before it may not have reached
+ * TCD_ReadCompletedCallback() yet.
+ ******************************************************************************/
+TCD_ITCM_CODE uint32_t TCD_IcgCallback(void)
+{
+    TCD_CommitStaged( (uint32_t) TCD_pcb.totalSpectrumsAcquired + 2U +
+                      TCD_PORT_ADC_IsReadoutPending() );
+
+    return (TCD_pcb.stageSequence != TCD_pcb.stageTaken) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @brief   Handle sensor data when the ADC+DMA has samples all pixels.
+ * @param   buffer, uint32_t: Index of the DMA memory that was completed
  * @retval  None
  *
  * This function is called from the ADC DMA transfer complete interrupt handler.
@@ -229,30 +464,100 @@ TCD_ERR_t TCD_SetIntTime(TCD_CONFIG_t *config)
  * flag is generated just before the tranfer counter is re-set to the programmed
  * value.
  *
+ * In double buffer mode the DMA is already filling the other memory. The
+ * completed frame is published to the frame queue and the DMA memory that
+ * just finished is pointed to a free frame buffer, so a queued frame is never
+ * overwritten. If no free frame buffer is available the frame is dropped and
+ * the DMA reuses the same buffer for the next readout.
+ *
  * NOTE: This function is called from the portable layer in interrupt context.
  ******************************************************************************/
-void TCD_ReadCompletedCallback(void)
+TCD_ITCM_CODE void TCD_ReadCompletedCallback(uint32_t buffer)
 {
     TCD_pcb.totalSpectrumsAcquired++;
-    TCD_pcb.counter++;
 
-    /* Accumulate the spectrum data vector */
-    for ( uint32_t i = 0U; i < CFG_CCD_NUM_PIXELS; i++ )
+#if ( CFG_ADC_DOUBLE_BUFFER == 1U )
+    uint8_t completed;
+    uint8_t next;
+    uint32_t depth;
+
+    if ( buffer >= 2U )
     {
-        TCD_pcb.data.SensorDataAccu[ i ] += TCD_pcb.data.SensorData[ i ];
+        return;
     }
+    completed = TCD_pcb.dmaFrame[ buffer ];
 
-    /* Calculate average data vector */
-    if ( TCD_pcb.counter == TCD_config->avg )
+    if ( TCD_FrameRing_Pop( &TCD_pcb.freeRing, &next ) == 1U )
     {
-        for ( uint32_t i = 0U; i < CFG_CCD_NUM_PIXELS; i++ )
+        TCD_PORT_ADC_SetBuffer( buffer, TCD_frameBuffer[ next ] );
+        TCD_pcb.dmaFrame[ buffer ] = next;
+
+        TCD_pcb.frameStamp[ completed ] = (uint32_t) TCD_pcb.totalSpectrumsAcquired;
+        (void) TCD_FrameRing_Push( &TCD_pcb.readyRing, completed );
+
+        depth = TCD_pcb.readyRing.head - TCD_pcb.readyRing.tail;
+        if ( depth > TCD_pcb.queueHighWater )
         {
-            TCD_pcb.data.SensorDataAvg[ i ] = (uint16_t) (TCD_pcb.data.SensorDataAccu[ i ] / TCD_config->avg);
-            TCD_pcb.data.SensorDataAccu[ i ] = 0U;
+            TCD_pcb.queueHighWater = depth;
         }
+    }
+    else
+    {
+        TCD_pcb.framesDropped++;
+    }
 
-        TCD_pcb.counter = 0U;
-        TCD_pcb.dataReady = 1U;
+#if ( CFG_DEFERRED_PROCESSING == 1U )
+    TCD_PORT_RequestDeferredProcessing();
+#else
+    TCD_ProcessCompletedFrames();
+#endif
+
+#else
+    (void) buffer;
+    TCD_ApplyCommitted( (uint32_t) TCD_pcb.totalSpectrumsAcquired );
+    TCD_AccumulateFrame( TCD_frameBuffer[ 0 ] );
+#endif
+}
+
+/*******************************************************************************
+ * @brief   Account for a readout lost to an ADC DMA transfer error
+ * @param   None
+ * @retval  None
+ *
+ * The readout never reaches TCD_ReadCompletedCallback(). It is still counted
+ * as acquired, so the frame stamps and the commit points of TCD_IcgCallback()
+ * stay aligned with the ICG pulses.
+ *
+ * NOTE: This function is called from the portable layer in interrupt context.
+ ******************************************************************************/
+TCD_ITCM_CODE void TCD_ReadErrorCallback(void)
+{
+    TCD_pcb.totalSpectrumsAcquired++;
+    TCD_pcb.readErrors++;
+}
+
+/*******************************************************************************
+ * @brief   Accumulate and average all frames waiting in the frame queue
+ * @param   None
+ * @retval  None
+ *
+ * This is the consumer side of the frame queue. Each frame buffer is released
+ * back to the DMA as soon as it has been accumulated.
+ *
+ * NOTE: This function is called from the portable layer in the deferred
+ * processing context, or directly from TCD_ReadCompletedCallback() when
+ * CFG_DEFERRED_PROCESSING is disabled. It must not be called from more than
+ * one context.
+ ******************************************************************************/
+void TCD_ProcessCompletedFrames(void)
+{
+    uint8_t frame;
+
+    while ( TCD_FrameRing_Pop( &TCD_pcb.readyRing, &frame ) == 1U )
+    {
+        TCD_ApplyCommitted( TCD_pcb.frameStamp[ frame ] );
+        TCD_AccumulateFrame( TCD_frameBuffer[ frame ] );
+        (void) TCD_FrameRing_Push( &TCD_pcb.freeRing, frame );
     }
 }
 
@@ -268,6 +573,69 @@ TCD_DATA_t* TCD_GetSensorData(void)
     return &TCD_pcb.data;
 }
 
+/*******************************************************************************
+ * @brief   Copy the averaged data and its acquisition parameters
+ * @param   data, uint16_t: Destination for up to CFG_CCD_NUM_PIXELS pixels
+ * @param   info, TCD_DATA_INFO_t: Acquisition parameters, may be NULL
+ * @retval  TCD_OK on success or TCD_ERR_t code
+ *
+ * In boxcar and EMA mode SensorDataAvg is updated with every frame, so the
+ * frame processing can interrupt a plain copy and leave a torn spectrum.
+ * The copy is repeated until no update has happened while copying.
+ *
+ * With pixel windows only the windows of the average are copied, one after
+ * the other; info->pixelCount pixels in total. With binning the bins are
+ * copied instead, info->pixelCount bins in total.
+ ******************************************************************************/
+TCD_ERR_t TCD_ReadSensorDataAvg(uint16_t *data, TCD_DATA_INFO_t *info)
+{
+    TCD_DATA_INFO_t snapshot;
+    uint32_t sequence;
+
+    if ( data == NULL )
+    {
+        return TCD_ERR_NULL_POINTER;
+    }
+
+    do
+    {
+        sequence = TCD_pcb.avgSequence;
+        TCD_MEMORY_BARRIER();
+
+        snapshot = TCD_pcb.avgInfo;
+
+        if ( snapshot.bin != 1U )
+        {
+            memcpy( data, TCD_pcb.data.SensorDataBin, snapshot.pixelCount * sizeof(uint16_t) );
+        }
+        else if ( snapshot.windows == 0U )
+        {
+            memcpy( data, TCD_pcb.data.SensorDataAvg, sizeof(TCD_pcb.data.SensorDataAvg) );
+        }
+        else
+        {
+            uint16_t *dst = data;
+
+            for ( uint32_t w = 0U; w < snapshot.windows; w++ )
+            {
+                memcpy( dst, &TCD_pcb.data.SensorDataAvg[ snapshot.window[ w ].first ],
+                        snapshot.window[ w ].count * sizeof(uint16_t) );
+                dst += snapshot.window[ w ].count;
+            }
+        }
+
+        TCD_MEMORY_BARRIER();
+    }
+    while ( ((sequence & 1U) != 0U) || (sequence != TCD_pcb.avgSequence) );
+
+    if ( info != NULL )
+    {
+        *info = snapshot;
+    }
+
+    return TCD_OK;
+}
+
 /*******************************************************************************
  * @brief   Check if new data is ready
  * @param   None
@@ -290,6 +658,85 @@ void TCD_ClearDataReadyFlag(void)
     TCD_pcb.dataReady = 0U;
 }
 
+/*******************************************************************************
+ * @brief   Called when a new average is ready, see tcd1304.h
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+__attribute__((weak)) void TCD_DataReadyCallback(void)
+{
+}
+
+/*******************************************************************************
+ * @brief   Get the frame queue statistics
+ * @param   stats, TCD_QUEUE_STATS_t: Struct to fill with the statistics
+ * @retval  None
+ *
+ * queueHighWater close to CFG_FRAME_QUEUE_SIZE or framesDropped > 0 means that
+ * the frame processing can not keep up with the readout rate. readErrors > 0
+ * means that readouts were lost in the ADC DMA.
+ ******************************************************************************/
+void TCD_GetQueueStats(TCD_QUEUE_STATS_t *stats)
+{
+    if ( stats == NULL )
+    {
+        return;
+    }
+
+    stats->queueDepth = TCD_pcb.readyRing.head - TCD_pcb.readyRing.tail;
+    stats->queueHighWater = TCD_pcb.queueHighWater;
+    stats->framesDropped = TCD_pcb.framesDropped;
+    stats->readErrors = TCD_pcb.readErrors;
+}
+
+/*******************************************************************************
+ * @brief   Reset the frame queue high-water mark and dropped frames counter
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_ResetQueueStats(void)
+{
+    TCD_pcb.queueHighWater = 0U;
+    TCD_pcb.framesDropped = 0U;
+    TCD_pcb.readErrors = 0U;
+}
+
+/*******************************************************************************
+ * @brief   Get the cycle count profile of the frame processing
+ * @param   profile, TCD_PROFILE_t: Struct to fill with the cycle counts
+ * @retval  None
+ *
+ * All zero if CFG_PROFILING is disabled.
+ ******************************************************************************/
+void TCD_GetProfile(TCD_PROFILE_t *profile)
+{
+    if ( profile == NULL )
+    {
+        return;
+    }
+
+    *profile = TCD_pcb.profile;
+#if ( CFG_PROFILING == 1U )
+    TCD_PORT_ADC_GetIrqCycles( &profile->irqCycles, &profile->irqMaxCycles );
+#endif
+}
+
+/*******************************************************************************
+ * @brief   Reset the cycle count profile of the frame processing
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_ResetProfile(void)
+{
+    memset( &TCD_pcb.profile, 0, sizeof(TCD_pcb.profile) );
+#if ( CFG_PROFILING == 1U )
+    TCD_PORT_ADC_ResetIrqCycles();
+#endif
+}
+
 /*******************************************************************************
  * @brief   Get the total of spectrum collected since the start
  * @param   None
@@ -342,7 +789,10 @@ static TCD_ERR_t TCD_ICG_Init(void)
 
     if ( (TCD_config->t_icg_us > 0U) && (TCD_config->t_icg_us <= CFG_ICG_MAX_PERIOD_US) )
     {
-        TCD_PORT_ICG_ConfigClock( TCD_config->t_icg_us );
+        if ( TCD_PORT_ICG_ConfigClock( TCD_config->t_icg_us ) != 0 )
+        {
+            return TCD_ERR_ICG_INIT;
+        }
     }
     else
     {
@@ -373,9 +823,13 @@ static TCD_ERR_t TCD_SH_Init(void)
         return TCD_ERR_SH_INIT;
     }
 
-    if ( (TCD_config->t_int_us >= 10U) && (TCD_config->t_int_us <= TCD_config->t_icg_us) )
+    if ( (TCD_config->t_int_us >= CFG_SH_MIN_PERIOD_US) &&
+         (TCD_config->t_int_us <= TCD_config->t_icg_us) )
     {
-        TCD_PORT_SH_ConfigClock( TCD_config->t_int_us );
+        if ( TCD_PORT_SH_ConfigClock( TCD_config->t_int_us ) != 0 )
+        {
+            return TCD_ERR_SH_INIT;
+        }
     }
     else
     {
@@ -399,6 +853,10 @@ static TCD_ERR_t TCD_ADC_Init(void)
         return TCD_ERR_ADC_INIT;
     }
 
+#if ( CFG_PROFILING == 1U )
+    TCD_PORT_CycleCounter_Init();
+#endif
+
     /* Check that the master clock is dividable by 4 */
     if ( TCD_config->f_master % 4U )
     {
@@ -408,7 +866,11 @@ static TCD_ERR_t TCD_ADC_Init(void)
     TCD_PORT_ADC_ConfigTrigger( TCD_config->f_master / 4U );
 
     /* Start the DMA transfer */
-    if ( TCD_PORT_ADC_Start( TCD_pcb.data.SensorData ) == 0 )
+#if ( CFG_ADC_DOUBLE_BUFFER == 1U )
+    if ( TCD_PORT_ADC_StartDoubleBuffer( TCD_frameBuffer[ 0 ], TCD_frameBuffer[ 1 ] ) == 0 )
+#else
+    if ( TCD_PORT_ADC_Start( TCD_frameBuffer[ 0 ] ) == 0 )
+#endif
     {
         return TCD_OK;
     }
@@ -422,4 +884,643 @@ static TCD_ERR_t TCD_ADC_Init(void)
      */
 }
 
+/*******************************************************************************
+ * @brief   Set the frame queue to initial state
+ * @param   None
+ * @retval  None
+ *
+ * Frame buffer 0 and 1 are given to the DMA memory 0 and 1. The rest of the
+ * frame buffers are free.
+ ******************************************************************************/
+static void TCD_FrameQueue_Init(void)
+{
+    TCD_pcb.readyRing.head = 0U;
+    TCD_pcb.readyRing.tail = 0U;
+    TCD_pcb.freeRing.head = 0U;
+    TCD_pcb.freeRing.tail = 0U;
+    TCD_pcb.queueHighWater = 0U;
+    TCD_pcb.framesDropped = 0U;
+    TCD_pcb.readErrors = 0U;
+
+    TCD_pcb.dmaFrame[ 0 ] = 0U;
+    TCD_pcb.dmaFrame[ 1 ] = (CFG_ADC_NUM_BUFFERS > 1U) ? 1U : 0U;
+
+    for ( uint32_t i = 2U; i < CFG_ADC_NUM_BUFFERS; i++ )
+    {
+        (void) TCD_FrameRing_Push( &TCD_pcb.freeRing, (uint8_t) i );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check a complete configuration before it is staged
+ * @param   config, TCD_CONFIG_t: The configuration to check
+ * @retval  TCD_OK or TCD_ERR_PARAM_OUT_OF_RANGE
+ *
+ * The readout of CFG_CCD_NUM_PIXELS samples at f_master / 4 must end before
+ * the next ICG pulse, and P_ICG = N x P_SH, see TCD_SH_Init(). The readout
+ * time is rounded up from the master clock the timer achieves.
+ ******************************************************************************/
+static TCD_ERR_t TCD_CheckConfig(const TCD_CONFIG_t *config)
+{
+    uint32_t f_master = TCD_PORT_FM_GetFrequency();
+    uint64_t readout_us = ((uint64_t) CFG_CCD_NUM_PIXELS * 4U * 1000000U + f_master - 1U) / f_master;
+
+    if ( config->f_master != TCD_pcb.active.f_master )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    if ( (config->t_icg_us > CFG_ICG_MAX_PERIOD_US) ||
+         (config->t_icg_us < (readout_us + CFG_ICG_DEFAULT_PULSE_US)) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    if ( (config->t_int_us < CFG_SH_MIN_PERIOD_US) || (config->t_int_us > config->t_icg_us) ||
+         ((config->t_icg_us % config->t_int_us) != 0U) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    if ( (config->avg == 0U) || (config->avg_mode > TCD_AVG_EMA) ||
+         (config->ema_alpha == 0U) || (config->ema_alpha > TCD_EMA_ALPHA_ONE) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    if ( TCD_CheckWindows( config ) != TCD_OK )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    return TCD_CheckBinning( config );
+}
+
+/*******************************************************************************
+ * @brief   Check the pixel windows of a configuration
+ * @param   config, TCD_CONFIG_t: The configuration to check
+ * @retval  TCD_OK or TCD_ERR_PARAM_OUT_OF_RANGE
+ *
+ * The windows must not be empty, must be inside the sensor and must be in
+ * ascending order without overlap, so every pixel is averaged only once.
+ ******************************************************************************/
+static TCD_ERR_t TCD_CheckWindows(const TCD_CONFIG_t *config)
+{
+    uint32_t next = 0U;
+
+    if ( config->windows > CFG_MAX_WINDOWS )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    for ( uint32_t w = 0U; w < config->windows; w++ )
+    {
+        uint32_t first = config->window[ w ].first;
+        uint32_t count = config->window[ w ].count;
+
+        if ( (count == 0U) || (first < next) || ((first + count) > CFG_CCD_NUM_PIXELS) )
+        {
+            return TCD_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        next = first + count;
+    }
+
+    return TCD_OK;
+}
+
+/*******************************************************************************
+ * @brief   Check the binning of a configuration
+ * @param   config, TCD_CONFIG_t: The configuration with checked windows
+ * @retval  TCD_OK or TCD_ERR_PARAM_OUT_OF_RANGE
+ *
+ * A bin is at most CFG_BIN_MAX_WIDTH pixels wide, so its sum fits 16 bit.
+ * With a factor every window must hold at least one bin; the pixels at the
+ * end of a window that do not fill a bin are dropped. A bin edge table
+ * selects the pixels itself and cannot be combined with windows.
+ ******************************************************************************/
+static TCD_ERR_t TCD_CheckBinning(const TCD_CONFIG_t *config)
+{
+    if ( config->bin == TCD_BIN_EDGES )
+    {
+        if ( (config->windows != 0U) || (config->binEdges < 2U) ||
+             (config->binEdges > CFG_MAX_BIN_EDGES) ||
+             (config->binEdge[ config->binEdges - 1U ] > CFG_CCD_NUM_PIXELS) )
+        {
+            return TCD_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        for ( uint32_t k = 1U; k < config->binEdges; k++ )
+        {
+            uint32_t width = (uint32_t) config->binEdge[ k ] - config->binEdge[ k - 1U ];
+
+            if ( (config->binEdge[ k ] <= config->binEdge[ k - 1U ]) ||
+                 (width > CFG_BIN_MAX_WIDTH) )
+            {
+                return TCD_ERR_PARAM_OUT_OF_RANGE;
+            }
+        }
+
+        return TCD_OK;
+    }
+
+    if ( (config->bin > CFG_BIN_MAX_WIDTH) || ((config->bin & (config->bin - 1U)) != 0U) )
+    {
+        return TCD_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    for ( uint32_t w = 0U; w < config->windows; w++ )
+    {
+        if ( config->window[ w ].count < config->bin )
+        {
+            return TCD_ERR_PARAM_OUT_OF_RANGE;
+        }
+    }
+
+    return TCD_OK;
+}
+
+/*******************************************************************************
+ * @brief   Make a configuration the one of the averaged frames
+ * @param   config, TCD_CONFIG_t: Checked configuration
+ * @retval  None
+ *
+ * Without windows the frame processing works on one window of all pixels,
+ * or on the pixels from the first to the last edge of a bin edge table.
+ ******************************************************************************/
+static void TCD_SetActive(const TCD_CONFIG_t *config)
+{
+    TCD_pcb.active = *config;
+    TCD_pcb.mode = config->avg_mode;
+
+    if ( config->bin == TCD_BIN_EDGES )
+    {
+        TCD_pcb.numWindows = 1U;
+        TCD_pcb.window[ 0 ].first = config->binEdge[ 0 ];
+        TCD_pcb.window[ 0 ].count = config->binEdge[ config->binEdges - 1U ] - config->binEdge[ 0 ];
+        TCD_pcb.pixelCount = config->binEdges - 1U;
+        return;
+    }
+
+    if ( config->windows == 0U )
+    {
+        TCD_pcb.numWindows = 1U;
+        TCD_pcb.window[ 0 ].first = 0U;
+        TCD_pcb.window[ 0 ].count = CFG_CCD_NUM_PIXELS;
+    }
+    else
+    {
+        TCD_pcb.numWindows = config->windows;
+        memcpy( TCD_pcb.window, config->window, sizeof(TCD_pcb.window) );
+    }
+
+    TCD_pcb.pixelCount = 0U;
+    for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+    {
+        TCD_pcb.pixelCount += TCD_pcb.window[ w ].count / config->bin;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Hand the staged configuration over to the frame processing
+ * @param   firstFrame, uint32_t: Readout number of the first frame acquired
+ *          with it, see frameStamp
+ * @retval  None
+ *
+ * Called from the ICG interrupt, or from the main loop while the timers are
+ * stopped. Nothing is done while the previous commit is not yet active, or
+ * while the main loop is writing the staged configuration; the next ICG
+ * interrupt tries again.
+ ******************************************************************************/
+TCD_ITCM_CODE static void TCD_CommitStaged(uint32_t firstFrame)
+{
+    uint32_t sequence = TCD_pcb.stageSequence;
+
+    if ( ((sequence & 1U) != 0U) || (sequence == TCD_pcb.stageTaken) ||
+         (TCD_pcb.committedValid == 1U) )
+    {
+        return;
+    }
+
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.committed = TCD_pcb.staged;
+    TCD_pcb.committedTiming = TCD_pcb.stagedTiming;
+    TCD_MEMORY_BARRIER();
+
+    if ( sequence != TCD_pcb.stageSequence )
+    {
+        return;
+    }
+
+    TCD_PORT_SetTiming( &TCD_pcb.committedTiming );
+
+    TCD_pcb.committedFrame = firstFrame;
+    TCD_pcb.stageTaken = sequence;
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.committedValid = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Make a committed configuration active from its first frame on
+ * @param   stamp, uint32_t: Readout number of the frame about to be averaged
+ * @retval  None
+ *
+ * All averaging modes restart with the new configuration, so no average
+ * mixes frames of two configurations.
+ ******************************************************************************/
+static void TCD_ApplyCommitted(uint32_t stamp)
+{
+    if ( (TCD_pcb.committedValid == 0U) ||
+         ((int32_t) (stamp - TCD_pcb.committedFrame) < 0) )
+    {
+        return;
+    }
+
+    TCD_MEMORY_BARRIER();
+    TCD_SetActive( &TCD_pcb.committed );
+    TCD_pcb.counter = 0U;
+    TCD_pcb.avg = 0U;
+
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.committedValid = 0U;
+}
+
+/*******************************************************************************
+ * @brief   Put a frame buffer index into a frame ring
+ * @param   ring, TCD_FRAME_RING_t: The ring to write to
+ * @param   frame, uint8_t: Frame buffer index
+ * @retval  1U on success and 0U if the ring is full
+ *
+ * Must only be called from the producer context of the ring.
+ ******************************************************************************/
+TCD_ITCM_CODE static uint8_t TCD_FrameRing_Push(TCD_FRAME_RING_t *ring, uint8_t frame)
+{
+    uint32_t head = ring->head;
+
+    if ( (head - ring->tail) >= CFG_FRAME_QUEUE_SIZE )
+    {
+        return 0U;
+    }
+
+    /* Store the item before it is made visible to the consumer */
+    ring->frame[ head & TCD_FRAME_RING_MASK ] = frame;
+    ring->head = head + 1U;
+
+    return 1U;
+}
+
+/*******************************************************************************
+ * @brief   Get a frame buffer index from a frame ring
+ * @param   ring, TCD_FRAME_RING_t: The ring to read from
+ * @param   frame, uint8_t: Location to store the frame buffer index
+ * @retval  1U on success and 0U if the ring is empty
+ *
+ * Must only be called from the consumer context of the ring.
+ ******************************************************************************/
+TCD_ITCM_CODE static uint8_t TCD_FrameRing_Pop(TCD_FRAME_RING_t *ring, uint8_t *frame)
+{
+    uint32_t tail = ring->tail;
+
+    if ( ring->head == tail )
+    {
+        return 0U;
+    }
+
+    /* Read the item before the slot is handed back to the producer */
+    *frame = ring->frame[ tail & TCD_FRAME_RING_MASK ];
+    ring->tail = tail + 1U;
+
+    return 1U;
+}
+
+/*******************************************************************************
+ * @brief   Accumulate one frame with the active averaging mode
+ * @param   sensorData, uint16_t: The frame to accumulate
+ * @retval  None
+ *
+ ******************************************************************************/
+static void TCD_AccumulateFrame(const uint16_t *sensorData)
+{
+    TCD_AVG_MODE_t mode = TCD_pcb.mode;
+#if ( CFG_PROFILING == 1U )
+    uint32_t start = TCD_PORT_CycleCounter_Get();
+#endif
+
+    /* Readers of SensorDataAvg retry while the sequence is odd */
+    TCD_pcb.avgSequence++;
+    TCD_MEMORY_BARRIER();
+
+    switch ( mode )
+    {
+        case TCD_AVG_BOXCAR:
+            TCD_AverageBoxcar( sensorData );
+            break;
+
+        case TCD_AVG_EMA:
+            TCD_AverageEma( sensorData );
+            break;
+
+        case TCD_AVG_BLOCK:
+        default:
+            TCD_AverageBlock( sensorData );
+            break;
+    }
+
+    TCD_MEMORY_BARRIER();
+    TCD_pcb.avgSequence++;
+
+#if ( CFG_PROFILING == 1U )
+    /* Boxcar and EMA update the average with every frame */
+    if ( (mode == TCD_AVG_BLOCK) && (TCD_pcb.counter != 0U) )
+    {
+        TCD_Profile_Update( &TCD_pcb.profile.accumulateCycles,
+                            &TCD_pcb.profile.accumulateMaxCycles, start );
+    }
+    else
+    {
+        TCD_Profile_Update( &TCD_pcb.profile.averageCycles,
+                            &TCD_pcb.profile.averageMaxCycles, start );
+    }
+#endif
+}
+
+/*******************************************************************************
+ * @brief   Block average of avg frames
+ * @param   sensorData, uint16_t: The frame to accumulate
+ * @retval  None
+ *
+ * Every frame costs exactly one pass over the pixels:
+ * - The first frame of a block is loaded into the accumulator, which removes
+ *   the need to clear the accumulator after the average is calculated.
+ * - The last frame of a block is added and normalized in one fused pass with
+ *   a precomputed reciprocal (or shift), writing straight to SensorDataAvg.
+ * A new configuration restarts the block, see TCD_ApplyCommitted().
+ * All averaging modes only touch the pixels inside the windows.
+ *
+ * With binning the last frame is added, binned and normalized in one pass
+ * from the accumulator instead, and SensorDataAvg is not written.
+ ******************************************************************************/
+static void TCD_AverageBlock(const uint16_t *sensorData)
+{
+    if ( TCD_pcb.counter == 0U )
+    {
+        TCD_pcb.avg = (TCD_pcb.active.avg > 0U) ? TCD_pcb.active.avg : 1U;
+
+        if ( TCD_pcb.divider.divisor != TCD_pcb.avg )
+        {
+            TCD_DSP_DividerInit( &TCD_pcb.divider, TCD_pcb.avg );
+        }
+    }
+
+    TCD_pcb.counter++;
+
+    if ( (TCD_pcb.counter == TCD_pcb.avg) && (TCD_pcb.active.bin != 1U) )
+    {
+        if ( TCD_pcb.avg == 1U )
+        {
+            /* A block of one frame has no accumulator to add the frame to */
+            for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+            {
+                uint32_t first = TCD_pcb.window[ w ].first;
+
+                TCD_DSP_Load( &TCD_pcb.data.SensorDataAccu[ first ], &sensorData[ first ],
+                              TCD_pcb.window[ w ].count );
+            }
+            TCD_BinWindows( TCD_pcb.data.SensorDataAccu, NULL, &TCD_pcb.divider );
+        }
+        else
+        {
+            TCD_BinWindows( TCD_pcb.data.SensorDataAccu, sensorData, &TCD_pcb.divider );
+        }
+
+        TCD_pcb.counter = 0U;
+        TCD_PublishAverage( TCD_pcb.avg );
+        return;
+    }
+
+    for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+    {
+        uint32_t first = TCD_pcb.window[ w ].first;
+        uint32_t count = TCD_pcb.window[ w ].count;
+
+        if ( TCD_pcb.counter == TCD_pcb.avg )
+        {
+            /* Calculate average data vector */
+            if ( TCD_pcb.avg == 1U )
+            {
+                memcpy( &TCD_pcb.data.SensorDataAvg[ first ], &sensorData[ first ],
+                        count * sizeof(uint16_t) );
+            }
+            else
+            {
+                TCD_DSP_AccumulateAverage( &TCD_pcb.data.SensorDataAvg[ first ],
+                                           &TCD_pcb.data.SensorDataAccu[ first ],
+                                           &sensorData[ first ], count, &TCD_pcb.divider );
+            }
+        }
+        else if ( TCD_pcb.counter == 1U )
+        {
+            /* First frame of the block */
+            TCD_DSP_Load( &TCD_pcb.data.SensorDataAccu[ first ], &sensorData[ first ], count );
+        }
+        else
+        {
+            /* Accumulate the spectrum data vector */
+            TCD_DSP_Accumulate( &TCD_pcb.data.SensorDataAccu[ first ], &sensorData[ first ], count );
+        }
+    }
+
+    if ( TCD_pcb.counter == TCD_pcb.avg )
+    {
+        TCD_pcb.counter = 0U;
+        TCD_PublishAverage( TCD_pcb.avg );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Sliding window (boxcar) average of the last avg frames
+ * @param   sensorData, uint16_t: The new frame
+ * @retval  None
+ *
+ * A new average is output for every frame. The window length is avg, limited
+ * to CFG_BOXCAR_MAX_FRAMES. Until the window is filled, the average is over
+ * the frames received so far. A new window length restarts the window.
+ ******************************************************************************/
+static void TCD_AverageBoxcar(const uint16_t *sensorData)
+{
+    uint32_t window = TCD_pcb.active.avg;
+
+    if ( window == 0U )
+    {
+        window = 1U;
+    }
+    else if ( window > CFG_BOXCAR_MAX_FRAMES )
+    {
+        window = CFG_BOXCAR_MAX_FRAMES;
+    }
+
+    /* (Re)start the window with an empty history */
+    if ( window != TCD_pcb.avg )
+    {
+        TCD_pcb.avg = window;
+        TCD_pcb.counter = 0U;
+        TCD_pcb.boxcarHead = 0U;
+        memset( TCD_pcb.data.SensorDataAccu, 0, sizeof(TCD_pcb.data.SensorDataAccu) );
+        memset( TCD_boxcarHistory, 0, sizeof(TCD_boxcarHistory) );
+    }
+
+    /* The number of frames in the window only changes while it is filled */
+    if ( TCD_pcb.counter < window )
+    {
+        TCD_pcb.counter++;
+        TCD_DSP_DividerInit( &TCD_pcb.divider, TCD_pcb.counter );
+    }
+
+    for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+    {
+        uint32_t first = TCD_pcb.window[ w ].first;
+
+        TCD_DSP_BoxcarUpdate( &TCD_pcb.data.SensorDataAvg[ first ],
+                              &TCD_pcb.data.SensorDataAccu[ first ],
+                              &TCD_boxcarHistory[ TCD_pcb.boxcarHead ][ first ],
+                              &sensorData[ first ], TCD_pcb.window[ w ].count,
+                              &TCD_pcb.divider );
+    }
+
+    if ( TCD_pcb.active.bin != 1U )
+    {
+        TCD_BinWindows( TCD_pcb.data.SensorDataAccu, NULL, &TCD_pcb.divider );
+    }
+
+    TCD_pcb.boxcarHead++;
+    if ( TCD_pcb.boxcarHead >= window )
+    {
+        TCD_pcb.boxcarHead = 0U;
+    }
+
+    TCD_PublishAverage( TCD_pcb.counter );
+}
+
+/*******************************************************************************
+ * @brief   Exponential moving average with the smoothing factor ema_alpha
+ * @param   sensorData, uint16_t: The new frame
+ * @retval  None
+ *
+ * A new average is output for every frame. The EMA state is kept in Q16 in
+ * SensorDataAccu. The first frame after a restart loads the state. Bins are
+ * summed from the Q16 state.
+ ******************************************************************************/
+static void TCD_AverageEma(const uint16_t *sensorData)
+{
+    uint32_t alpha = TCD_pcb.active.ema_alpha;
+    TCD_DSP_DIVIDER_t q16;
+
+    if ( (alpha == 0U) || (alpha > TCD_EMA_ALPHA_ONE) || (TCD_pcb.counter == 0U) )
+    {
+        alpha = TCD_EMA_ALPHA_ONE;
+    }
+
+    for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+    {
+        uint32_t first = TCD_pcb.window[ w ].first;
+
+        TCD_DSP_EmaUpdate( &TCD_pcb.data.SensorDataAvg[ first ],
+                           &TCD_pcb.data.SensorDataAccu[ first ],
+                           &sensorData[ first ], TCD_pcb.window[ w ].count, alpha );
+    }
+
+    if ( TCD_pcb.active.bin != 1U )
+    {
+        TCD_DSP_DividerInit( &q16, TCD_EMA_ALPHA_ONE );
+        TCD_BinWindows( TCD_pcb.data.SensorDataAccu, NULL, &q16 );
+    }
+
+    TCD_pcb.counter = 1U;
+    TCD_PublishAverage( alpha );
+}
+
+/*******************************************************************************
+ * @brief   Bin the pixels of the active windows into SensorDataBin
+ * @param   accu, uint32_t: Accumulator vector of all pixels
+ * @param   data, uint16_t: Last frame of a block to add on the fly, or NULL
+ * @param   div, TCD_DSP_DIVIDER_t: Divider for the accumulated frames
+ * @retval  None
+ *
+ * The bins of all windows are stored one after the other.
+ ******************************************************************************/
+static void TCD_BinWindows(const uint32_t *accu, const uint16_t *data,
+                           const TCD_DSP_DIVIDER_t *div)
+{
+    uint16_t *bin = TCD_pcb.data.SensorDataBin;
+    uint32_t width = TCD_pcb.active.bin;
+
+    if ( width == TCD_BIN_EDGES )
+    {
+        TCD_DSP_AccumulateBin( bin, accu, data, TCD_pcb.active.binEdge, 0U,
+                               TCD_pcb.active.binEdges - 1U, div );
+        return;
+    }
+
+    for ( uint32_t w = 0U; w < TCD_pcb.numWindows; w++ )
+    {
+        uint32_t first = TCD_pcb.window[ w ].first;
+        uint32_t bins = TCD_pcb.window[ w ].count / width;
+
+        TCD_DSP_AccumulateBin( bin, &accu[ first ], (data != NULL) ? &data[ first ] : NULL,
+                               NULL, width, bins, div );
+        bin += bins;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Record the acquisition parameters of a new average and flag it ready
+ * @param   avg, uint32_t: Frames in the average, or the EMA alpha
+ * @retval  None
+ *
+ ******************************************************************************/
+static void TCD_PublishAverage(uint32_t avg)
+{
+    TCD_pcb.avgInfo.spectrums = TCD_pcb.totalSpectrumsAcquired;
+    TCD_pcb.avgInfo.t_int_us = TCD_pcb.active.t_int_us;
+    TCD_pcb.avgInfo.t_icg_us = TCD_pcb.active.t_icg_us;
+    TCD_pcb.avgInfo.avg = avg;
+    TCD_pcb.avgInfo.avg_mode = TCD_pcb.mode;
+    TCD_pcb.avgInfo.pixelCount = TCD_pcb.pixelCount;
+    TCD_pcb.avgInfo.windows = TCD_pcb.active.windows;
+    memcpy( TCD_pcb.avgInfo.window, TCD_pcb.active.window, sizeof(TCD_pcb.avgInfo.window) );
+    TCD_pcb.avgInfo.bin = TCD_pcb.active.bin;
+    TCD_pcb.avgInfo.binEdges = 0U;
+
+    if ( TCD_pcb.active.bin == TCD_BIN_EDGES )
+    {
+        TCD_pcb.avgInfo.binEdges = TCD_pcb.active.binEdges;
+        memcpy( TCD_pcb.avgInfo.binEdge, TCD_pcb.active.binEdge,
+                TCD_pcb.active.binEdges * sizeof(uint16_t) );
+    }
+
+    TCD_pcb.dataReady = 1U;
+    TCD_DataReadyCallback();
+}
+
+#if ( CFG_PROFILING == 1U )
+/*******************************************************************************
+ * @brief   Store the cycles elapsed since start and track the maximum
+ * @param   cycles, uint32_t: Last measurement
+ * @param   maxCycles, uint32_t: Maximum measurement
+ * @param   start, uint32_t: Cycle counter at the start of the measurement
+ * @retval  None
+ *
+ ******************************************************************************/
+static void TCD_Profile_Update(uint32_t *cycles, uint32_t *maxCycles, uint32_t start)
+{
+    uint32_t elapsed = TCD_PORT_CycleCounter_Get() - start;
+
+    *cycles = elapsed;
+    if ( elapsed > *maxCycles )
+    {
+        *maxCycles = elapsed;
+    }
+}
+#endif
+
 /****************************** END OF FILE ***********************************/
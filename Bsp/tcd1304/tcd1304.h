@@ -50,23 +50,96 @@ extern "C"
 
 /* Includes ------------------------------------------------------------------*/
 #include "tcd1304_port.h"
+#include "tcd1304_dsp.h"
 
 /* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    TCD_AVG_BLOCK = 0,      /* Average of avg frames, output every avg frames       */
+    TCD_AVG_BOXCAR,         /* Sliding window of the last avg frames, every frame   */
+    TCD_AVG_EMA             /* Exponential moving average with ema_alpha, every frame */
+} TCD_AVG_MODE_t;
+
+/**
+ * A range of pixels, see CFG_MAX_WINDOWS
+ */
+typedef struct
+{
+    uint16_t first;         /* Index of the first pixel                         */
+    uint16_t count;         /* Number of pixels                                 */
+} TCD_WINDOW_t;
+
 typedef struct
 {
     uint32_t avg;
     uint32_t f_master;
     uint32_t t_icg_us;
     uint32_t t_int_us;
+    TCD_AVG_MODE_t avg_mode;
+    uint32_t ema_alpha;     /* Q16 fixed-point, TCD_EMA_ALPHA_ONE = 1.0 */
+    uint32_t windows;       /* Windows in use, 0 for all pixels         */
+    TCD_WINDOW_t window[ CFG_MAX_WINDOWS ]; /* Ascending, not overlapping */
+    uint32_t bin;           /* Pixels per bin 1, 2, 4, 8, 16 or TCD_BIN_EDGES */
+    uint32_t binEdges;      /* Edges in binEdge, the number of bins + 1 */
+    uint16_t binEdge[ CFG_MAX_BIN_EDGES ];  /* Ascending pixel indices  */
 } TCD_CONFIG_t;
 
 typedef struct
 {
-    uint16_t SensorData[ CFG_CCD_NUM_PIXELS ];
     uint16_t SensorDataAvg[ CFG_CCD_NUM_PIXELS ];
     uint32_t SensorDataAccu[ CFG_CCD_NUM_PIXELS ];
+    uint16_t SensorDataBin[ CFG_CCD_NUM_PIXELS / 2U ];
 } TCD_DATA_t;
 
+/**
+ * Acquisition parameters of the averaged data, see TCD_ReadSensorDataAvg()
+ */
+typedef struct
+{
+    uint64_t spectrums;     /* TCD_GetNumOfSpectrumsAcquired() at the average   */
+    uint32_t t_int_us;
+    uint32_t t_icg_us;
+    uint32_t avg;           /* Frames in the average, ema_alpha in EMA mode     */
+    TCD_AVG_MODE_t avg_mode;
+    uint32_t pixelCount;    /* Values copied, pixels or bins of the windows     */
+    uint32_t windows;       /* 0 when all pixels were copied                    */
+    TCD_WINDOW_t window[ CFG_MAX_WINDOWS ];
+    uint32_t bin;           /* Pixels per bin, TCD_BIN_EDGES for binEdge        */
+    uint32_t binEdges;      /* 0 unless bin is TCD_BIN_EDGES                    */
+    uint16_t binEdge[ CFG_MAX_BIN_EDGES ];
+} TCD_DATA_INFO_t;
+
+/**
+ * Periods the timers generate for a configuration, see TCD_GetTiming()
+ */
+typedef struct
+{
+    uint32_t f_master;      /* Achieved master clock in Hz                      */
+    int32_t  f_master_err_hz;   /* Achieved minus requested                     */
+    uint32_t t_int_us;      /* Requested SH period                              */
+    int32_t  t_int_err_ns;  /* Achieved minus requested                         */
+    uint32_t t_icg_us;      /* Requested ICG period                             */
+    int32_t  t_icg_err_ns;  /* Achieved minus requested                         */
+} TCD_TIMING_t;
+
+typedef struct
+{
+    uint32_t queueDepth;
+    uint32_t queueHighWater;
+    uint32_t framesDropped;
+    uint32_t readErrors;    /* Readouts lost to an ADC DMA transfer error      */
+} TCD_QUEUE_STATS_t;
+
+typedef struct
+{
+    uint32_t accumulateCycles;      /* Last frame accumulation              */
+    uint32_t accumulateMaxCycles;
+    uint32_t averageCycles;         /* Last pass producing SensorDataAvg    */
+    uint32_t averageMaxCycles;
+    uint32_t irqCycles;             /* Last ADC+DMA interrupt handler       */
+    uint32_t irqMaxCycles;
+} TCD_PROFILE_t;
+
 typedef enum
 {
     TCD_OK = 0,
@@ -95,6 +168,11 @@ typedef enum
 } TCD_ERR_t;
 
 /* Exported defines ----------------------------------------------------------*/
+/* The Q16 scale of ema_alpha is the one of the EMA kernel */
+#define TCD_EMA_ALPHA_ONE                   (TCD_DSP_EMA_ALPHA_ONE)
+
+/* TCD_CONFIG_t.bin: bin k holds the pixels binEdge[ k ] .. binEdge[ k + 1 ] - 1 */
+#define TCD_BIN_EDGES                       (0U)
 /* Exported macros -----------------------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
 /* Exported functions --------------------------------------------------------*/
@@ -103,13 +181,31 @@ TCD_ERR_t TCD_Start(void);
 TCD_ERR_t TCD_Stop(void);
 
 TCD_ERR_t TCD_SetIntTime(TCD_CONFIG_t *config);
+TCD_ERR_t TCD_Reconfigure(const TCD_CONFIG_t *config);
+uint8_t TCD_IsReconfigurePending(void);
+TCD_ERR_t TCD_GetTiming(const TCD_CONFIG_t *config, TCD_TIMING_t *timing);
 
 TCD_DATA_t* TCD_GetSensorData(void);
+TCD_ERR_t TCD_ReadSensorDataAvg(uint16_t *data, TCD_DATA_INFO_t *info);
 uint64_t TCD_GetNumOfSpectrumsAcquired(void);
 
 uint8_t TCD_IsDataReady(void);
 void TCD_ClearDataReadyFlag(void);
 
+void TCD_GetQueueStats(TCD_QUEUE_STATS_t *stats);
+void TCD_ResetQueueStats(void);
+
+void TCD_GetProfile(TCD_PROFILE_t *profile);
+void TCD_ResetProfile(void);
+
+/**
+ * This function is called in the deferred processing context when a new
+ * average is ready, after the data ready flag has been set. The default
+ * implementation does nothing; the application can override it to wake its
+ * main loop instead of polling TCD_IsDataReady().
+ */
+void TCD_DataReadyCallback(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,6 +68,84 @@ extern "C"
 #define CFG_CCD_NUM_PIXELS                  (3694U)
 #define CFG_ADC_SAMPLING_RATE_HZ            (CFG_FM_FREQUENCY_HZ / 4U)
 
+/**
+ * ADC DMA buffering.
+ * In double buffer mode the DMA alternates between two sensor data buffers.
+ * The buffer holding the completed readout is handed to the driver while the
+ * next readout is written to the other buffer, so a frame is never overwritten
+ * while it is being processed.
+ * Set to 0U to use a single buffer in circular mode.
+ */
+#define CFG_ADC_DOUBLE_BUFFER               (1U)
+
+/**
+ * Deferred frame processing.
+ * The ADC interrupt handler only publishes the completed frame to a lock-free
+ * single-producer/single-consumer queue. Accumulation and averaging are done
+ * later in a lower priority context provided by the portable layer.
+ * Set to 0U to process the frames directly in the ADC interrupt handler.
+ *
+ * CFG_FRAME_QUEUE_SIZE is the number of frames that can wait for processing.
+ * It MUST be a power of two. Two more buffers are always owned by the DMA.
+ * Deferred processing requires double buffer mode.
+ */
+#define CFG_DEFERRED_PROCESSING             (1U)
+#define CFG_FRAME_QUEUE_SIZE                (4U)
+
+/**
+ * Streaming averaging.
+ * The sliding window (boxcar) average keeps a history of the last frames in
+ * RAM. CFG_BOXCAR_MAX_FRAMES limits the window length and the RAM used:
+ * CFG_BOXCAR_MAX_FRAMES x CFG_CCD_NUM_PIXELS x 2 bytes.
+ */
+#define CFG_BOXCAR_MAX_FRAMES               (16U)
+
+/**
+ * Pixel windows (regions of interest).
+ * Up to CFG_MAX_WINDOWS ranges of pixels can be selected in TCD_CONFIG_t.
+ * Only these pixels are averaged and read out; with no window all pixels are.
+ */
+#define CFG_MAX_WINDOWS                     (4U)
+
+/**
+ * Pixel binning.
+ * A bin is the sum of up to CFG_BIN_MAX_WIDTH neighbouring averaged pixels.
+ * With the 12 bit ADC the sum of 16 pixels still fits the 16 bit output.
+ * A bin edge table in TCD_CONFIG_t holds up to CFG_MAX_BIN_EDGES - 1 bins.
+ */
+#define CFG_BIN_MAX_WIDTH                   (16U)
+#define CFG_MAX_BIN_EDGES                   (129U)
+
+/**
+ * Cycle count profiling.
+ * Measures the CPU cycles of the frame accumulation and of the averaging
+ * pass with the cycle counter of the portable layer. Read the results with
+ * TCD_GetProfile(). Set to 0U to remove the measurement.
+ */
+#define CFG_PROFILING                       (1U)
+
+/**
+ * Interrupt handlers of the portable layer.
+ * By default the acquisition interrupts are handled with direct register
+ * access: only the flags in use are cleared before the driver callback is
+ * called. Set to 1U to use the generic STM32 HAL handlers, e.g. for debugging.
+ */
+#define CFG_HAL_IRQ_HANDLERS                (0U)
+
+#if ( CFG_ADC_DOUBLE_BUFFER == 1U )
+    #define CFG_ADC_NUM_BUFFERS             (CFG_FRAME_QUEUE_SIZE + 2U)
+#else
+    #define CFG_ADC_NUM_BUFFERS             (1U)
+#endif
+
+#if ( (CFG_DEFERRED_PROCESSING == 1U) && (CFG_ADC_DOUBLE_BUFFER == 0U) )
+    #error "CFG_DEFERRED_PROCESSING requires CFG_ADC_DOUBLE_BUFFER"
+#endif
+
+#if ( (CFG_FRAME_QUEUE_SIZE & (CFG_FRAME_QUEUE_SIZE - 1U)) != 0U )
+    #error "CFG_FRAME_QUEUE_SIZE must be a power of two"
+#endif
+
 /**
  * Electronic shutter.
  * In normal mode the shutter period is equal the ICG period.
@@ -80,6 +158,7 @@ extern "C"
  * Minimum integration time is >= 10 us.
  * Minimum SH pulse width is >= 2 us.
  */
+#define CFG_SH_MIN_PERIOD_US                (10U)
 #define CFG_SH_DEFAULT_PERIOD_US            (100U)
 #define CFG_SH_DEFAULT_PULSE_US             (3U)
 #define CFG_SH_DEFAULT_PULSE_DELAY_CNT      (1U)
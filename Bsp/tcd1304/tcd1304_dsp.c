@@ -0,0 +1,513 @@
+/**
+ *******************************************************************************
+ * @file    : tcd1304_dsp.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Signal processing kernels for the TCD1304 CCD sensor driver
+ *
+ * The kernels in this file do the per pixel work on the sensor data vectors.
+ * Each optimized kernel has a portable scalar reference implementation with
+ * the suffix Ref. The optimized kernel MUST give bit-exact the same result as
+ * the reference.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "tcd1304_dsp.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/**
+ * The reciprocal multiplication is exact for all divisors below this limit
+ * when the accumulated sum is made of divisor samples of 16 bit each.
+ */
+#define TCD_DSP_RECIPROCAL_MAX_DIVISOR  (32768U)
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static inline uint32_t TCD_DSP_AddLowHalf(uint32_t acc, uint32_t val);
+static inline uint32_t TCD_DSP_AddHighHalf(uint32_t acc, uint32_t val);
+static inline uint16_t TCD_DSP_DivideBin(uint64_t sum, const TCD_DSP_DIVIDER_t *div);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Add a sensor data vector to the accumulator vector
+ * @param   accu, uint32_t: Accumulator vector
+ * @param   data, uint16_t: Sensor data vector
+ * @param   len, uint32_t: Number of pixels
+ * @retval  None
+ *
+ * Two pixels are read with a single word load and added to their accumulators
+ * with the packed halfword extend-and-add instruction (UXTAH) of the Cortex-M7
+ * DSP extension. The loop is unrolled to process 4 pixels per iteration.
+ * The packed halfword layout assumes a little endian core.
+ ******************************************************************************/
+void TCD_DSP_Accumulate(uint32_t *accu, const uint16_t *data, uint32_t len)
+{
+    uint32_t blkCnt = len >> 2U;
+    uint32_t in0;
+    uint32_t in1;
+
+    while ( blkCnt > 0U )
+    {
+        /* Read 4 pixels as two packed halfword pairs */
+        memcpy( &in0, &data[ 0 ], sizeof(in0) );
+        memcpy( &in1, &data[ 2 ], sizeof(in1) );
+
+        accu[ 0 ] = TCD_DSP_AddLowHalf( accu[ 0 ], in0 );
+        accu[ 1 ] = TCD_DSP_AddHighHalf( accu[ 1 ], in0 );
+        accu[ 2 ] = TCD_DSP_AddLowHalf( accu[ 2 ], in1 );
+        accu[ 3 ] = TCD_DSP_AddHighHalf( accu[ 3 ], in1 );
+
+        data += 4U;
+        accu += 4U;
+        blkCnt--;
+    }
+
+    /* Remaining pixels */
+    blkCnt = len & 3U;
+
+    while ( blkCnt > 0U )
+    {
+        *accu++ += *data++;
+        blkCnt--;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Reference implementation of TCD_DSP_Accumulate()
+ * @param   accu, uint32_t: Accumulator vector
+ * @param   data, uint16_t: Sensor data vector
+ * @param   len, uint32_t: Number of pixels
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_DSP_AccumulateRef(uint32_t *accu, const uint16_t *data, uint32_t len)
+{
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        accu[ i ] += data[ i ];
+    }
+}
+
+/*******************************************************************************
+ * @brief   Load a sensor data vector into the accumulator vector
+ * @param   accu, uint32_t: Accumulator vector
+ * @param   data, uint16_t: Sensor data vector
+ * @param   len, uint32_t: Number of pixels
+ * @retval  None
+ *
+ * Used for the first frame of an averaging block. The accumulator is
+ * overwritten, so it never has to be cleared after the average is calculated.
+ ******************************************************************************/
+void TCD_DSP_Load(uint32_t *accu, const uint16_t *data, uint32_t len)
+{
+    uint32_t blkCnt = len >> 2U;
+    uint32_t in0;
+    uint32_t in1;
+
+    while ( blkCnt > 0U )
+    {
+        memcpy( &in0, &data[ 0 ], sizeof(in0) );
+        memcpy( &in1, &data[ 2 ], sizeof(in1) );
+
+        accu[ 0 ] = in0 & 0xFFFFU;
+        accu[ 1 ] = in0 >> 16U;
+        accu[ 2 ] = in1 & 0xFFFFU;
+        accu[ 3 ] = in1 >> 16U;
+
+        data += 4U;
+        accu += 4U;
+        blkCnt--;
+    }
+
+    blkCnt = len & 3U;
+
+    while ( blkCnt > 0U )
+    {
+        *accu++ = *data++;
+        blkCnt--;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Precompute the divider used by TCD_DSP_AccumulateAverage()
+ * @param   div, TCD_DSP_DIVIDER_t: Divider to initialize
+ * @param   divisor, uint32_t: Number of averaged frames. 0 is treated as 1.
+ * @retval  None
+ *
+ * With k = floor(log2(divisor)) the reciprocal is
+ * mult = ceil(2^(32 + k) / divisor), and sum / divisor = (sum * mult) >> (32 + k).
+ * The error of the rounded reciprocal stays below 1 / divisor for every
+ * sum <= 65535 x divisor as long as divisor < 32768, so the result is exact.
+ ******************************************************************************/
+void TCD_DSP_DividerInit(TCD_DSP_DIVIDER_t *div, uint32_t divisor)
+{
+    uint32_t k = 0U;
+
+    if ( divisor == 0U )
+    {
+        divisor = 1U;
+    }
+
+    while ( (divisor >> (k + 1U)) != 0U )
+    {
+        k++;
+    }
+
+    div->divisor = divisor;
+
+    if ( (divisor & (divisor - 1U)) == 0U )
+    {
+        /* Power of two */
+        div->mult = 0U;
+        div->shift = k;
+    }
+    else if ( divisor < TCD_DSP_RECIPROCAL_MAX_DIVISOR )
+    {
+        uint64_t one = (uint64_t) 1U << (32U + k);
+        div->mult = (uint32_t) ((one + divisor - 1U) / divisor);
+        div->shift = 32U + k;
+    }
+    else
+    {
+        /* Fall back to true division */
+        div->mult = 0U;
+        div->shift = 0U;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Add the last frame of a block and calculate the average vector
+ * @param   avg, uint16_t: Averaged output vector
+ * @param   accu, uint32_t: Accumulator vector holding all but the last frame
+ * @param   data, uint16_t: Sensor data vector of the last frame
+ * @param   len, uint32_t: Number of pixels
+ * @param   div, TCD_DSP_DIVIDER_t: Divider from TCD_DSP_DividerInit()
+ * @retval  None
+ *
+ * The add, the normalization and the reset of the accumulator are fused into
+ * one pass. The accumulator is only read; the next block starts with
+ * TCD_DSP_Load().
+ ******************************************************************************/
+void TCD_DSP_AccumulateAverage(uint16_t *avg, const uint32_t *accu, const uint16_t *data,
+                               uint32_t len, const TCD_DSP_DIVIDER_t *div)
+{
+    const uint32_t mult = div->mult;
+    const uint32_t shift = div->shift;
+
+    if ( mult != 0U )
+    {
+        for ( uint32_t i = 0U; i < len; i++ )
+        {
+            uint32_t sum = accu[ i ] + data[ i ];
+            avg[ i ] = (uint16_t) (((uint64_t) sum * mult) >> shift);
+        }
+    }
+    else if ( (div->divisor >> shift) == 1U )
+    {
+        for ( uint32_t i = 0U; i < len; i++ )
+        {
+            avg[ i ] = (uint16_t) ((accu[ i ] + data[ i ]) >> shift);
+        }
+    }
+    else
+    {
+        TCD_DSP_AccumulateAverageRef( avg, accu, data, len, div->divisor );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Reference implementation of TCD_DSP_AccumulateAverage()
+ * @param   avg, uint16_t: Averaged output vector
+ * @param   accu, uint32_t: Accumulator vector holding all but the last frame
+ * @param   data, uint16_t: Sensor data vector of the last frame
+ * @param   len, uint32_t: Number of pixels
+ * @param   divisor, uint32_t: Number of averaged frames
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_DSP_AccumulateAverageRef(uint16_t *avg, const uint32_t *accu, const uint16_t *data,
+                                  uint32_t len, uint32_t divisor)
+{
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        avg[ i ] = (uint16_t) ((accu[ i ] + data[ i ]) / divisor);
+    }
+}
+
+/*******************************************************************************
+ * @brief   Slide the boxcar window one frame and calculate the average vector
+ * @param   avg, uint16_t: Averaged output vector
+ * @param   sum, uint32_t: Running sum of the frames in the window
+ * @param   history, uint16_t: History slot of the oldest frame in the window
+ * @param   data, uint16_t: Sensor data vector of the new frame
+ * @param   len, uint32_t: Number of pixels
+ * @param   div, TCD_DSP_DIVIDER_t: Divider for the number of frames in the window
+ * @retval  None
+ *
+ * O(1) per pixel regardless of the window length: the oldest frame is
+ * subtracted from the running sum, the new frame is added and replaces the
+ * oldest frame in the history. The sum and history MUST be cleared when the
+ * window is (re)started.
+ ******************************************************************************/
+void TCD_DSP_BoxcarUpdate(uint16_t *avg, uint32_t *sum, uint16_t *history, const uint16_t *data,
+                          uint32_t len, const TCD_DSP_DIVIDER_t *div)
+{
+    const uint32_t mult = div->mult;
+    const uint32_t shift = div->shift;
+    const uint32_t divisor = div->divisor;
+
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        uint32_t s = sum[ i ] - history[ i ] + data[ i ];
+
+        sum[ i ] = s;
+        history[ i ] = data[ i ];
+
+        if ( mult != 0U )
+        {
+            avg[ i ] = (uint16_t) (((uint64_t) s * mult) >> shift);
+        }
+        else if ( (divisor >> shift) == 1U )
+        {
+            avg[ i ] = (uint16_t) (s >> shift);
+        }
+        else
+        {
+            avg[ i ] = (uint16_t) (s / divisor);
+        }
+    }
+}
+
+/*******************************************************************************
+ * @brief   Update the exponential moving average with a new frame
+ * @param   avg, uint16_t: Averaged output vector
+ * @param   state, uint32_t: EMA state vector in Q16 fixed-point
+ * @param   data, uint16_t: Sensor data vector of the new frame
+ * @param   len, uint32_t: Number of pixels
+ * @param   alpha, uint32_t: Smoothing factor in Q16, 1 - TCD_DSP_EMA_ALPHA_ONE
+ * @retval  None
+ *
+ * state = (1 - alpha) x state + alpha x data, all unsigned in Q16.
+ * Calling with alpha = TCD_DSP_EMA_ALPHA_ONE loads the state with the frame,
+ * which is how the EMA is (re)started.
+ ******************************************************************************/
+void TCD_DSP_EmaUpdate(uint16_t *avg, uint32_t *state, const uint16_t *data,
+                       uint32_t len, uint32_t alpha)
+{
+    const uint32_t beta = TCD_DSP_EMA_ALPHA_ONE - alpha;
+
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        uint64_t acc = (uint64_t) state[ i ] * beta + (((uint64_t) data[ i ] << 16U) * alpha);
+        uint32_t s = (uint32_t) (acc >> 16U);
+
+        state[ i ] = s;
+        avg[ i ] = (uint16_t) ((s + 0x8000U) >> 16U);
+    }
+}
+
+/*******************************************************************************
+ * @brief   Sum neighbouring pixels into bins and normalize the sums
+ * @param   bin, uint16_t: Binned output vector, bins values
+ * @param   accu, uint32_t: Accumulator vector, the running sum or EMA state
+ * @param   data, uint16_t: Sensor data vector of the last frame of a block,
+ *          added to the accumulator on the fly; NULL if accu is complete
+ * @param   edge, uint16_t: Bin k holds the pixels edge[ k ] .. edge[ k + 1 ] - 1;
+ *          NULL for bins of width pixels each
+ * @param   width, uint32_t: Pixels per bin when edge is NULL
+ * @param   bins, uint32_t: Number of bins
+ * @param   div, TCD_DSP_DIVIDER_t: Divider for the accumulated frames
+ * @retval  None
+ *
+ * The pixels of a bin are summed at full precision before the one division,
+ * so the bin does not carry the rounding error of every pixel. A bin is the
+ * sum, not the mean, of its averaged pixels and saturates at 0xFFFF.
+ ******************************************************************************/
+void TCD_DSP_AccumulateBin(uint16_t *bin, const uint32_t *accu, const uint16_t *data,
+                           const uint16_t *edge, uint32_t width, uint32_t bins,
+                           const TCD_DSP_DIVIDER_t *div)
+{
+    uint32_t first = 0U;
+
+    for ( uint32_t k = 0U; k < bins; k++ )
+    {
+        uint32_t last;
+        uint64_t sum = 0U;
+
+        if ( edge != NULL )
+        {
+            first = edge[ k ];
+            last = edge[ k + 1U ];
+        }
+        else
+        {
+            last = first + width;
+        }
+
+        if ( data != NULL )
+        {
+            for ( uint32_t i = first; i < last; i++ )
+            {
+                sum += (uint64_t) accu[ i ] + data[ i ];
+            }
+        }
+        else
+        {
+            for ( uint32_t i = first; i < last; i++ )
+            {
+                sum += accu[ i ];
+            }
+        }
+
+        bin[ k ] = TCD_DSP_DivideBin( sum, div );
+        first = last;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Reference implementation of TCD_DSP_AccumulateBin()
+ * @param   bin, uint16_t: Binned output vector, bins values
+ * @param   accu, uint32_t: Accumulator vector
+ * @param   data, uint16_t: Sensor data vector of the last frame, or NULL
+ * @param   edge, uint16_t: Bin edges, or NULL for bins of width pixels each
+ * @param   width, uint32_t: Pixels per bin when edge is NULL
+ * @param   bins, uint32_t: Number of bins
+ * @param   divisor, uint32_t: Number of accumulated frames
+ * @retval  None
+ *
+ ******************************************************************************/
+void TCD_DSP_AccumulateBinRef(uint16_t *bin, const uint32_t *accu, const uint16_t *data,
+                              const uint16_t *edge, uint32_t width, uint32_t bins,
+                              uint32_t divisor)
+{
+    for ( uint32_t k = 0U; k < bins; k++ )
+    {
+        uint32_t first = (edge != NULL) ? edge[ k ] : k * width;
+        uint32_t last = (edge != NULL) ? edge[ k + 1U ] : first + width;
+        uint64_t sum = 0U;
+
+        for ( uint32_t i = first; i < last; i++ )
+        {
+            sum += accu[ i ] + ((data != NULL) ? (uint64_t) data[ i ] : 0U);
+        }
+
+        sum /= divisor;
+        bin[ k ] = (sum > 0xFFFFU) ? 0xFFFFU : (uint16_t) sum;
+    }
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Add the low halfword of val zero extended to acc
+ * @param   acc, uint32_t: Accumulator
+ * @param   val, uint32_t: Packed halfword pair
+ * @retval  acc + val[15:0]
+ *
+ ******************************************************************************/
+static inline uint32_t TCD_DSP_AddLowHalf(uint32_t acc, uint32_t val)
+{
+#if defined ( __GNUC__ ) && defined ( __ARM_FEATURE_DSP ) && ( __ARM_FEATURE_DSP == 1 )
+    uint32_t result;
+    __asm ( "uxtah %0, %1, %2" : "=r" (result) : "r" (acc), "r" (val) );
+    return result;
+#else
+    return acc + (val & 0xFFFFU);
+#endif
+}
+
+/*******************************************************************************
+ * @brief   Add the high halfword of val zero extended to acc
+ * @param   acc, uint32_t: Accumulator
+ * @param   val, uint32_t: Packed halfword pair
+ * @retval  acc + val[31:16]
+ *
+ ******************************************************************************/
+static inline uint32_t TCD_DSP_AddHighHalf(uint32_t acc, uint32_t val)
+{
+#if defined ( __GNUC__ ) && defined ( __ARM_FEATURE_DSP ) && ( __ARM_FEATURE_DSP == 1 )
+    uint32_t result;
+    __asm ( "uxtah %0, %1, %2, ror #16" : "=r" (result) : "r" (acc), "r" (val) );
+    return result;
+#else
+    return acc + (val >> 16U);
+#endif
+}
+
+/*******************************************************************************
+ * @brief   Divide the sum of a bin by the number of accumulated frames
+ * @param   sum, uint64_t: Sum of the accumulators of the pixels in the bin
+ * @param   div, TCD_DSP_DIVIDER_t: Divider from TCD_DSP_DividerInit()
+ * @retval  sum / divisor, saturated to 16 bit
+ *
+ * The reciprocal of the divider is only exact for the sum of one pixel, so
+ * a bin uses a shift for powers of two and a true division otherwise. The
+ * 32 bit hardware division is used whenever the sum fits.
+ ******************************************************************************/
+static inline uint16_t TCD_DSP_DivideBin(uint64_t sum, const TCD_DSP_DIVIDER_t *div)
+{
+    uint64_t quotient;
+
+    if ( (div->mult == 0U) && ((div->divisor >> div->shift) == 1U) )
+    {
+        quotient = sum >> div->shift;
+    }
+    else if ( (sum >> 32U) == 0U )
+    {
+        quotient = (uint32_t) sum / div->divisor;
+    }
+    else
+    {
+        quotient = sum / div->divisor;
+    }
+
+    return (quotient > 0xFFFFU) ? 0xFFFFU : (uint16_t) quotient;
+}
+
+/****************************** END OF FILE ***********************************/
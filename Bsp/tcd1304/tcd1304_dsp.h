@@ -0,0 +1,102 @@
+/**
+ *******************************************************************************
+ * @file    : tcd1304_dsp.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Signal processing kernels for the TCD1304 CCD sensor driver
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef TCD1304_DSP_H_
+#define TCD1304_DSP_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported typedefs ---------------------------------------------------------*/
+
+/**
+ * Precomputed divider for the averaging. Division by the divisor is done as
+ * a shift when it is a power of two, otherwise as a multiplication with a
+ * fixed-point reciprocal. mult and shift are both 0 when neither is exact
+ * and a true division is used.
+ */
+typedef struct
+{
+    uint32_t divisor;
+    uint32_t mult;
+    uint32_t shift;
+} TCD_DSP_DIVIDER_t;
+/* Exported defines ----------------------------------------------------------*/
+
+/* EMA smoothing factor of 1.0 in Q16 fixed-point */
+#define TCD_DSP_EMA_ALPHA_ONE           (65536U)
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+void TCD_DSP_Accumulate(uint32_t *accu, const uint16_t *data, uint32_t len);
+void TCD_DSP_AccumulateRef(uint32_t *accu, const uint16_t *data, uint32_t len);
+
+void TCD_DSP_Load(uint32_t *accu, const uint16_t *data, uint32_t len);
+
+void TCD_DSP_DividerInit(TCD_DSP_DIVIDER_t *div, uint32_t divisor);
+void TCD_DSP_AccumulateAverage(uint16_t *avg, const uint32_t *accu, const uint16_t *data,
+                               uint32_t len, const TCD_DSP_DIVIDER_t *div);
+void TCD_DSP_AccumulateAverageRef(uint16_t *avg, const uint32_t *accu, const uint16_t *data,
+                                  uint32_t len, uint32_t divisor);
+
+void TCD_DSP_BoxcarUpdate(uint16_t *avg, uint32_t *sum, uint16_t *history, const uint16_t *data,
+                          uint32_t len, const TCD_DSP_DIVIDER_t *div);
+void TCD_DSP_EmaUpdate(uint16_t *avg, uint32_t *state, const uint16_t *data,
+                       uint32_t len, uint32_t alpha);
+
+void TCD_DSP_AccumulateBin(uint16_t *bin, const uint32_t *accu, const uint16_t *data,
+                           const uint16_t *edge, uint32_t width, uint32_t bins,
+                           const TCD_DSP_DIVIDER_t *div);
+void TCD_DSP_AccumulateBinRef(uint16_t *bin, const uint32_t *accu, const uint16_t *data,
+                              const uint16_t *edge, uint32_t width, uint32_t bins,
+                              uint32_t divisor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCD1304_DSP_H_ */
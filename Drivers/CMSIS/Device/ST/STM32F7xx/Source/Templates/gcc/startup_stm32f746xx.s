@@ -105,6 +105,34 @@ LoopFillZerobss:
   cmp  r2, r3
   bcc  FillZerobss
 
+/* Copy the time critical code from flash to ITCM RAM */
+  movs  r1, #0
+  b  LoopCopyItcm
+
+CopyItcm:
+  ldr  r3, =_siitcm
+  ldr  r3, [r3, r1]
+  str  r3, [r0, r1]
+  adds  r1, r1, #4
+
+LoopCopyItcm:
+  ldr  r0, =_sitcm
+  ldr  r3, =_eitcm
+  adds  r2, r0, r1
+  cmp  r2, r3
+  bcc  CopyItcm
+  ldr  r2, =_sdtcm_bss
+  b  LoopFillZeroDtcm
+/* Zero fill the DTCM bss segment. */
+FillZeroDtcm:
+  movs  r3, #0
+  str  r3, [r2], #4
+
+LoopFillZeroDtcm:
+  ldr  r3, =_edtcm_bss
+  cmp  r2, r3
+  bcc  FillZeroDtcm
+
 /* Call the clock system initialization function.*/
   bl  SystemInit   
 /* Call static constructors */
@@ -0,0 +1,300 @@
+/**
+ *******************************************************************************
+ * @file    : stm32f7xx_hal.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host shim of the STM32F7 HAL subset used by the application
+ *
+ * Lets main.c and cli.c build and run on Linux. USART1 is emulated by a
+ * pseudo-terminal, the UART DMA by threads, and the clock, power, cache and
+ * MPU configuration functions do nothing. Only the types, constants and
+ * functions used by the application are provided.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef STM32F7XX_HAL_H_
+#define STM32F7XX_HAL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+/**
+ * Emulated registers. NDTR of the RX DMA stream counts down from the buffer
+ * size and is reloaded in circular mode, as on the hardware.
+ */
+typedef struct
+{
+    volatile uint32_t NDTR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t CR3;
+    volatile uint32_t BRR;
+    volatile uint32_t ISR;          /* TC is always set */
+    volatile uint32_t ICR;
+} USART_TypeDef;
+
+typedef struct
+{
+    DMA_Stream_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+    uint32_t OneBitSampling;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    uint32_t AdvFeatureInit;
+} UART_AdvFeatureInitTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    UART_AdvFeatureInitTypeDef AdvancedInit;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    volatile HAL_UART_StateTypeDef gState;
+    volatile HAL_UART_StateTypeDef RxState;
+    void *host;                     /* Host emulation state */
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLM;
+    uint32_t PLLN;
+    uint32_t PLLP;
+    uint32_t PLLQ;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct
+{
+    uint32_t PeriphClockSelection;
+    uint32_t Usart1ClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+typedef struct
+{
+    uint8_t Enable;
+    uint8_t Number;
+    uint32_t BaseAddress;
+    uint8_t Size;
+    uint8_t SubRegionDisable;
+    uint8_t TypeExtField;
+    uint8_t AccessPermission;
+    uint8_t DisableExec;
+    uint8_t IsShareable;
+    uint8_t IsCacheable;
+    uint8_t IsBufferable;
+} MPU_Region_InitTypeDef;
+
+typedef enum
+{
+    SysTick_IRQn = -1
+} IRQn_Type;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+} SCB_Type;
+
+/* Exported defines ----------------------------------------------------------*/
+#define USART1                              ((USART_TypeDef *) &HOST_USART1)
+#define SCB                                 (&HOST_SCB)
+#define SCB_CCR_DC_Msk                      (1UL << 16U)
+
+#define UART_WORDLENGTH_8B                  (0U)
+#define UART_STOPBITS_1                     (0U)
+#define UART_PARITY_NONE                    (0U)
+#define UART_MODE_TX_RX                     (0x0CU)
+#define UART_HWCONTROL_NONE                 (0U)
+#define UART_OVERSAMPLING_16                (0U)
+#define UART_OVERSAMPLING_8                 (0x8000U)
+#define UART_ONE_BIT_SAMPLE_DISABLE         (0U)
+#define UART_ADVFEATURE_NO_INIT             (0U)
+
+#define RCC_OSCILLATORTYPE_HSE              (0x01U)
+#define RCC_HSE_ON                          (0x01U)
+#define RCC_PLL_ON                          (0x02U)
+#define RCC_PLLSOURCE_HSE                   (0x01U)
+#define RCC_PLLP_DIV2                       (0x02U)
+#define RCC_CLOCKTYPE_SYSCLK                (0x01U)
+#define RCC_CLOCKTYPE_HCLK                  (0x02U)
+#define RCC_CLOCKTYPE_PCLK1                 (0x04U)
+#define RCC_CLOCKTYPE_PCLK2                 (0x08U)
+#define RCC_SYSCLKSOURCE_PLLCLK             (0x02U)
+#define RCC_SYSCLK_DIV1                     (0U)
+#define RCC_HCLK_DIV2                       (4U)
+#define RCC_HCLK_DIV4                       (5U)
+#define RCC_PERIPHCLK_USART1                (0x40U)
+#define RCC_USART1CLKSOURCE_PCLK2           (0U)
+#define RCC_USART1CLKSOURCE_SYSCLK          (1U)
+
+#define USART_CR1_UE                        (0x0001U)
+#define USART_CR1_IDLEIE                    (0x0010U)
+#define USART_CR1_PEIE                      (0x0100U)
+#define USART_CR1_OVER8                     (0x8000U)
+#define USART_CR3_EIE                       (0x0001U)
+#define USART_ISR_TC                        (0x0040U)
+#define USART_ICR_PECF                      (0x0001U)
+#define USART_ICR_FECF                      (0x0002U)
+#define USART_ICR_NCF                       (0x0004U)
+#define USART_ICR_ORECF                     (0x0008U)
+#define USART_ICR_IDLECF                    (0x0010U)
+#define UART_IT_IDLE                        (0x0424U)
+#define FLASH_LATENCY_7                     (7U)
+#define PWR_REGULATOR_VOLTAGE_SCALE1        (3U)
+#define SYSTICK_CLKSOURCE_HCLK              (4U)
+
+#define MPU_REGION_ENABLE                   (1U)
+#define MPU_REGION_NUMBER0                  (0U)
+#define MPU_REGION_SIZE_64KB                (0x0FU)
+#define MPU_TEX_LEVEL1                      (1U)
+#define MPU_REGION_FULL_ACCESS              (3U)
+#define MPU_INSTRUCTION_ACCESS_DISABLE      (1U)
+#define MPU_ACCESS_SHAREABLE                (1U)
+#define MPU_ACCESS_NOT_CACHEABLE            (0U)
+#define MPU_ACCESS_NOT_BUFFERABLE           (0U)
+#define MPU_PRIVILEGED_DEFAULT              (4U)
+
+/* Exported macros -----------------------------------------------------------*/
+#define __HAL_RCC_PWR_CLK_ENABLE()          do { } while ( 0 )
+#define __HAL_PWR_VOLTAGESCALING_CONFIG(x)  do { (void) (x); } while ( 0 )
+#define __BKPT(x)                           HOST_Breakpoint( x )
+#define SET_BIT(REG, BIT)                   ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)                 ((REG) &= ~(BIT))
+#define __HAL_UART_ENABLE_IT(h, it)         ((h)->Instance->CR1 |= (1U << ((it) & 0x1FU)))
+#define __HAL_UART_CLEAR_IDLEFLAG(h)        ((h)->Instance->ICR = USART_ICR_IDLECF)
+
+/* Exported variables --------------------------------------------------------*/
+extern USART_TypeDef HOST_USART1;
+extern SCB_Type HOST_SCB;
+
+/* Exported functions --------------------------------------------------------*/
+HAL_StatusTypeDef HAL_Init(void);
+uint32_t HAL_GetTick(void);
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+HAL_StatusTypeDef HAL_PWREx_EnableOverDrive(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetSysClockFreq(void);
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb);
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+
+void HAL_MPU_Disable(void);
+void HAL_MPU_Enable(uint32_t MPU_Control);
+void HAL_MPU_ConfigRegion(MPU_Region_InitTypeDef *MPU_Init);
+void SCB_EnableICache(void);
+void SCB_EnableDCache(void);
+void SCB_DisableDCache(void);
+void SCB_CleanDCache_by_Addr(uint32_t *addr, int32_t dsize);
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+
+void HOST_Breakpoint(uint32_t value);
+
+/* The interrupts are threads, disabling them takes a global lock */
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F7XX_HAL_H_ */
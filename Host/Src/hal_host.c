@@ -0,0 +1,677 @@
+/**
+ *******************************************************************************
+ * @file    : hal_host.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host shim of the STM32F7 HAL subset used by the application
+ *
+ * USART1 is a Linux pseudo-terminal. Host tools open the slave device printed
+ * at start-up, /dev/pts/N, like the ST-Link virtual COM port. The UART DMA is
+ * emulated with one receive thread, which writes the circular buffer and
+ * counts down NDTR, and one transmit thread. Both directions are paced to the
+ * configured baud rate, so throughput is the same as on the board.
+ *
+ * Environment variables:
+ * TCD_HOST_SPEED     0 = as fast as possible, 1 = real time (default), N = N x
+ * TCD_HOST_SPECTRUM  flat, ramp or lines (default)
+ * TCD_HOST_NOISE     Peak-to-peak noise in ADC counts (default 8)
+ * TCD_HOST_LINK      Create a symbolic link with this name to the PTY
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+/* Before <termios.h>, which defines CR1 and other register names as macros */
+#include "stm32f7xx_hal.h"
+#include "tcd1304_port.h"
+#include "cli.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    int fd;                         /* PTY master                             */
+
+    /* Receive DMA in circular mode */
+    DMA_Stream_TypeDef rxStream;
+    DMA_HandleTypeDef hdmarx;
+    uint8_t *rxBuffer;
+    uint16_t rxSize;
+    uint16_t rxPos;
+    pthread_t rxThread;
+
+    /* Transmit DMA */
+    DMA_Stream_TypeDef txStream;
+    DMA_HandleTypeDef hdmatx;
+    const uint8_t *txData;
+    uint16_t txSize;
+    pthread_t txThread;
+    pthread_mutex_t txLock;
+    pthread_cond_t txStart;
+} HOST_UART_t;
+
+/* Private define ------------------------------------------------------------*/
+#define HOST_HCLK_FREQ_HZ               (216000000U)
+#define HOST_UART_CHUNK_SIZE            (64U)
+#define HOST_UART_WRITE_TIMEOUT_MS      (100)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+USART_TypeDef HOST_USART1 = { .ISR = USART_ISR_TC };
+SCB_Type HOST_SCB;
+
+static HOST_UART_t host_uart =
+{
+    .fd = -1,
+    .txLock = PTHREAD_MUTEX_INITIALIZER,
+    .txStart = PTHREAD_COND_INITIALIZER,
+};
+static struct timespec host_start;
+static pthread_mutex_t host_irqLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_irqWake = PTHREAD_COND_INITIALIZER;
+
+/* Private function prototypes -----------------------------------------------*/
+static void *HOST_UART_RxThread(void *arg);
+static void *HOST_UART_TxThread(void *arg);
+static void HOST_UART_Write(UART_HandleTypeDef *huart, const uint8_t *pData, uint32_t size);
+static void HOST_SleepNs(uint64_t ns);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the HAL and configure the sensor simulation
+ * @param   None
+ * @retval  HAL_OK
+ *
+ ******************************************************************************/
+HAL_StatusTypeDef HAL_Init(void)
+{
+    TCD_HOST_CONFIG_t sim =
+    {
+        .speed = 1U,
+        .spectrum = TCD_HOST_SPECTRUM_LINES,
+        .darkLevel = 3600U,
+        .amplitude = 3000U,
+        .refIntTimeUs = 3800U,
+        .noise = 8U,
+        .seed = 1U,
+    };
+    const char *env;
+
+    clock_gettime( CLOCK_MONOTONIC, &host_start );
+
+    env = getenv( "TCD_HOST_SPEED" );
+    if ( env != NULL )
+    {
+        sim.speed = (uint32_t) strtoul( env, NULL, 0 );
+    }
+
+    env = getenv( "TCD_HOST_SPECTRUM" );
+    if ( env != NULL )
+    {
+        if ( strcmp( env, "flat" ) == 0 )
+        {
+            sim.spectrum = TCD_HOST_SPECTRUM_FLAT;
+        }
+        else if ( strcmp( env, "ramp" ) == 0 )
+        {
+            sim.spectrum = TCD_HOST_SPECTRUM_RAMP;
+        }
+    }
+
+    env = getenv( "TCD_HOST_NOISE" );
+    if ( env != NULL )
+    {
+        sim.noise = (uint16_t) strtoul( env, NULL, 0 );
+    }
+
+    TCD_PORT_HOST_Configure( &sim );
+
+    return HAL_OK;
+}
+
+/*******************************************************************************
+ * @brief   Get the milliseconds since HAL_Init()
+ * @param   None
+ * @retval  Tick in milliseconds
+ *
+ ******************************************************************************/
+uint32_t HAL_GetTick(void)
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return (uint32_t) ((now.tv_sec - host_start.tv_sec) * 1000
+                       + (now.tv_nsec - host_start.tv_nsec) / 1000000);
+}
+
+/**
+ * Clock, power, interrupt, cache and MPU configuration have no effect on the
+ * host.
+ */
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    (void) RCC_OscInitStruct;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+    (void) RCC_ClkInitStruct;
+    (void) FLatency;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+    (void) PeriphClkInit;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_PWREx_EnableOverDrive(void)
+{
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return HOST_HCLK_FREQ_HZ;
+}
+
+uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+    return HOST_HCLK_FREQ_HZ;
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb)
+{
+    (void) TicksNumb;
+    return 0U;
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource)
+{
+    (void) CLKSource;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void) IRQn;
+    (void) PreemptPriority;
+    (void) SubPriority;
+}
+
+void HAL_MPU_Disable(void)
+{
+}
+
+void HAL_MPU_Enable(uint32_t MPU_Control)
+{
+    (void) MPU_Control;
+}
+
+void HAL_MPU_ConfigRegion(MPU_Region_InitTypeDef *MPU_Init)
+{
+    (void) MPU_Init;
+}
+
+void SCB_EnableICache(void)
+{
+}
+
+void SCB_EnableDCache(void)
+{
+    SCB->CCR |= SCB_CCR_DC_Msk;
+}
+
+void SCB_DisableDCache(void)
+{
+    SCB->CCR &= ~SCB_CCR_DC_Msk;
+}
+
+void SCB_CleanDCache_by_Addr(uint32_t *addr, int32_t dsize)
+{
+    (void) addr;
+    (void) dsize;
+}
+
+/*******************************************************************************
+ * @brief   Open the pseudo-terminal that emulates the UART
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  HAL_OK on success, HAL_ERROR otherwise
+ *
+ ******************************************************************************/
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    struct termios tio;
+    const char *name;
+    const char *link;
+    int slave;
+
+    host_uart.fd = posix_openpt( O_RDWR | O_NOCTTY );
+    if ( (host_uart.fd < 0) || (grantpt( host_uart.fd ) != 0) || (unlockpt( host_uart.fd ) != 0) )
+    {
+        return HAL_ERROR;
+    }
+    name = ptsname( host_uart.fd );
+
+    /* Raw mode, the host tools see the same bytes as from the VCP */
+    slave = open( name, O_RDWR | O_NOCTTY );
+    if ( slave >= 0 )
+    {
+        if ( tcgetattr( slave, &tio ) == 0 )
+        {
+            cfmakeraw( &tio );
+            tcsetattr( slave, TCSANOW, &tio );
+        }
+        close( slave );
+    }
+
+    link = getenv( "TCD_HOST_LINK" );
+    if ( link != NULL )
+    {
+        unlink( link );
+        if ( symlink( name, link ) != 0 )
+        {
+            perror( link );
+        }
+    }
+
+    fprintf( stderr, "USART1 on %s, %u baud\n", name, (unsigned int) huart->Init.BaudRate );
+
+    host_uart.hdmarx.Instance = &host_uart.rxStream;
+    host_uart.hdmatx.Instance = &host_uart.txStream;
+    huart->hdmarx = &host_uart.hdmarx;
+    huart->hdmatx = &host_uart.hdmatx;
+    huart->host = &host_uart;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+
+    if ( pthread_create( &host_uart.txThread, NULL, HOST_UART_TxThread, huart ) != 0 )
+    {
+        return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+/*******************************************************************************
+ * @brief   Send data in blocking mode
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @param   pData, uint8_t: Data to send
+ * @param   Size, uint16_t: Number of bytes
+ * @param   Timeout, uint32_t: Not used, the emulated UART never stalls
+ * @retval  HAL_OK, or HAL_BUSY while a DMA transfer is ongoing
+ *
+ ******************************************************************************/
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void) Timeout;
+
+    if ( huart->gState != HAL_UART_STATE_READY )
+    {
+        return HAL_BUSY;
+    }
+
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    HOST_UART_Write( huart, pData, Size );
+    huart->gState = HAL_UART_STATE_READY;
+
+    return HAL_OK;
+}
+
+/*******************************************************************************
+ * @brief   Start sending data with the emulated DMA
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @param   pData, uint8_t: Data to send
+ * @param   Size, uint16_t: Number of bytes
+ * @retval  HAL_OK, or HAL_BUSY while a transfer is ongoing
+ *
+ ******************************************************************************/
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if ( huart->gState != HAL_UART_STATE_READY )
+    {
+        return HAL_BUSY;
+    }
+
+    pthread_mutex_lock( &host_uart.txLock );
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    host_uart.txData = pData;
+    host_uart.txSize = Size;
+    host_uart.txStream.NDTR = Size;
+    pthread_cond_signal( &host_uart.txStart );
+    pthread_mutex_unlock( &host_uart.txLock );
+
+    return HAL_OK;
+}
+
+/*******************************************************************************
+ * @brief   Start receiving data with the emulated DMA in circular mode
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @param   pData, uint8_t: Circular receive buffer
+ * @param   Size, uint16_t: Size of the buffer
+ * @retval  HAL_OK on success, HAL_ERROR otherwise
+ *
+ ******************************************************************************/
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    host_uart.rxBuffer = pData;
+    host_uart.rxSize = Size;
+    host_uart.rxPos = 0U;
+    host_uart.rxStream.NDTR = Size;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    if ( pthread_create( &host_uart.rxThread, NULL, HOST_UART_RxThread, huart ) != 0 )
+    {
+        return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+/*******************************************************************************
+ * @brief   Transmit complete callback, called from the emulated DMA
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ ******************************************************************************/
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void) huart;
+}
+
+/*******************************************************************************
+ * @brief   Receive half complete callback, called from the emulated DMA
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ ******************************************************************************/
+__attribute__((weak)) void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void) huart;
+}
+
+/*******************************************************************************
+ * @brief   Receive complete callback, called from the emulated DMA
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ ******************************************************************************/
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void) huart;
+}
+
+/*******************************************************************************
+ * @brief   Emulate disabling the interrupts
+ * @param   None
+ * @retval  None
+ *
+ * The emulated interrupts run in their own threads and are not held off by
+ * this. It only makes the sections of the firmware that disable the
+ * interrupts mutually exclusive, which is what the firmware relies on.
+ * Leaving such a section wakes __WFI(), the firmware only changes what the
+ * main loop waits for inside them.
+ ******************************************************************************/
+void __disable_irq(void)
+{
+    pthread_mutex_lock( &host_irqLock );
+}
+
+/*******************************************************************************
+ * @brief   Emulate enabling the interrupts
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void __enable_irq(void)
+{
+    pthread_cond_broadcast( &host_irqWake );
+    pthread_mutex_unlock( &host_irqLock );
+}
+
+/*******************************************************************************
+ * @brief   Emulate waiting for an interrupt
+ * @param   None
+ * @retval  None
+ *
+ * Must be called with the interrupts disabled, as EVENT_Wait() does. Returns
+ * after the next emulated interrupt, or after 1 ms like on the SysTick.
+ ******************************************************************************/
+void __WFI(void)
+{
+    struct timespec deadline;
+
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_nsec += 1000000L;
+    if ( deadline.tv_nsec >= 1000000000L )
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    (void) pthread_cond_timedwait( &host_irqWake, &host_irqLock, &deadline );
+}
+
+/*******************************************************************************
+ * @brief   Emulate a breakpoint instruction
+ * @param   value, uint32_t: Breakpoint number
+ * @retval  None
+ *
+ ******************************************************************************/
+void HOST_Breakpoint(uint32_t value)
+{
+    fprintf( stderr, "Breakpoint %u\n", (unsigned int) value );
+    abort();
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   The emulated receive DMA
+ * @param   arg, UART_HandleTypeDef: UART handle
+ * @retval  NULL
+ *
+ * Reading the master fails with EIO while no host tool has the slave open.
+ ******************************************************************************/
+static void *HOST_UART_RxThread(void *arg)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *) arg;
+    uint8_t data[ HOST_UART_CHUNK_SIZE ];
+
+    while ( 1 )
+    {
+        ssize_t n = read( host_uart.fd, data, sizeof(data) );
+        ssize_t i;
+
+        if ( n <= 0 )
+        {
+            HOST_SleepNs( 10000000U );
+            continue;
+        }
+
+        for ( i = 0; i < n; i++ )
+        {
+            host_uart.rxBuffer[ host_uart.rxPos ] = data[ i ];
+            host_uart.rxPos++;
+            if ( host_uart.rxPos >= host_uart.rxSize )
+            {
+                host_uart.rxPos = 0U;
+            }
+
+            /* The data is in RAM before the counter moves */
+            __sync_synchronize();
+            host_uart.rxStream.NDTR = host_uart.rxSize - host_uart.rxPos;
+
+            if ( host_uart.rxPos == (host_uart.rxSize / 2U) )
+            {
+                HAL_UART_RxHalfCpltCallback( huart );
+            }
+            else if ( host_uart.rxPos == 0U )
+            {
+                HAL_UART_RxCpltCallback( huart );
+            }
+        }
+
+        /**
+         * A short read means the line has gone quiet: the emulated USART1
+         * idle-line interrupt, see USART1_IRQHandler(). The CLI enables it
+         * right after it starts the reception.
+         */
+        if ( (size_t) n < sizeof(data) )
+        {
+            CLI_RxIdleCallback();
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * @brief   The emulated transmit DMA
+ * @param   arg, UART_HandleTypeDef: UART handle
+ * @retval  NULL
+ *
+ ******************************************************************************/
+static void *HOST_UART_TxThread(void *arg)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *) arg;
+
+    while ( 1 )
+    {
+        const uint8_t *data;
+        uint16_t size;
+
+        pthread_mutex_lock( &host_uart.txLock );
+        while ( host_uart.txData == NULL )
+        {
+            pthread_cond_wait( &host_uart.txStart, &host_uart.txLock );
+        }
+        data = host_uart.txData;
+        size = host_uart.txSize;
+        pthread_mutex_unlock( &host_uart.txLock );
+
+        HOST_UART_Write( huart, data, size );
+
+        pthread_mutex_lock( &host_uart.txLock );
+        host_uart.txData = NULL;
+        host_uart.txStream.NDTR = 0U;
+        huart->gState = HAL_UART_STATE_READY;
+        pthread_mutex_unlock( &host_uart.txLock );
+
+        HAL_UART_TxCpltCallback( huart );
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * @brief   Write to the pseudo-terminal at the configured baud rate
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @param   pData, uint8_t: Data to send
+ * @param   size, uint32_t: Number of bytes
+ * @retval  None
+ *
+ * Like a real UART, the data is lost when nobody reads it: a write that can
+ * not complete within HOST_UART_WRITE_TIMEOUT_MS is dropped.
+ ******************************************************************************/
+static void HOST_UART_Write(UART_HandleTypeDef *huart, const uint8_t *pData, uint32_t size)
+{
+    /* 8N1: 10 bits per byte */
+    uint64_t nsPerByte = (huart->Init.BaudRate > 0U) ? (10000000000ULL / huart->Init.BaudRate) : 0U;
+
+    while ( size > 0U )
+    {
+        uint32_t chunk = (size > HOST_UART_CHUNK_SIZE) ? HOST_UART_CHUNK_SIZE : size;
+        struct pollfd pfd = { .fd = host_uart.fd, .events = POLLOUT };
+        ssize_t n = chunk;
+
+        if ( poll( &pfd, 1, HOST_UART_WRITE_TIMEOUT_MS ) == 1 )
+        {
+            n = write( host_uart.fd, pData, chunk );
+            if ( n <= 0 )
+            {
+                n = chunk;
+            }
+        }
+
+        HOST_SleepNs( nsPerByte * (uint64_t) n );
+        pData += n;
+        size -= (uint32_t) n;
+        if ( huart->hdmatx != NULL )
+        {
+            huart->hdmatx->Instance->NDTR = size;
+        }
+    }
+}
+
+/*******************************************************************************
+ * @brief   Sleep
+ * @param   ns, uint64_t: Time to sleep in nanoseconds
+ * @retval  None
+ *
+ ******************************************************************************/
+static void HOST_SleepNs(uint64_t ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t) (ns / 1000000000ULL);
+    ts.tv_nsec = (long) (ns % 1000000000ULL);
+
+    while ( (nanosleep( &ts, &ts ) != 0) && (errno == EINTR) )
+    {
+    }
+}
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,288 @@
+/**
+ *******************************************************************************
+ * @file    : codecbench.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Benchmark of the spectrum codec on the host
+ *
+ * Round trip, compression ratio and throughput of the spectrum codec, see
+ * codec.h, on synthetic spectra: a baseline with Gaussian peaks of up to
+ * CODEC_BENCH_FULL_SCALE counts and white noise of a given standard deviation,
+ * which stands for the averaging (the noise of one frame divided by sqrt(avg)).
+ * The last case is uniform 12 bit noise, which does not compress and must fall
+ * back to the raw values.
+ * The delta column codes the spectrum against a previous one with the same
+ * peaks and other noise, as sent between the keyframes of a steady process.
+ * The round trip also covers the 12 bit packing, and the last line gives the
+ * largest error of the 8 bit log preview over the 16 bit range.
+ *
+ * Usage: codecbench [-n pixels] [-r repetitions]
+ * Exit status 0 if every spectrum decodes to the original values.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "codec.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define CODEC_BENCH_MAX_PIXELS          (65536U)
+#define CODEC_BENCH_FULL_SCALE          (4095.0)
+#define CODEC_BENCH_UNIFORM             (-1.0)
+
+/* Private typedefs ----------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static uint16_t spectrum[ CODEC_BENCH_MAX_PIXELS ];
+static uint16_t previous[ CODEC_BENCH_MAX_PIXELS ];
+static uint16_t decoded[ CODEC_BENCH_MAX_PIXELS ];
+static uint8_t coded[ 2U * CODEC_BENCH_MAX_PIXELS ];
+
+/* Noise standard deviations of the cases in counts */
+static const double noiseCases[] = { 0.0, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, CODEC_BENCH_UNIFORM };
+
+/* Private function prototypes -----------------------------------------------*/
+static void MakeSpectrum(uint16_t *data, uint32_t pixels, double sigma);
+static double Gauss(void);
+static double Seconds(void);
+static double Log8Error(void);
+
+/*******************************************************************************
+ * @brief   Run the benchmark cases
+ * @param   argc, int: Number of arguments
+ * @param   argv, char: Arguments
+ * @retval  0 if all round trips were exact, 1 otherwise
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    uint32_t pixels = 3694U;
+    uint32_t reps = 200U;
+    int failed = 0;
+    int opt;
+
+    while ( (opt = getopt( argc, argv, "n:r:" )) != -1 )
+    {
+        switch ( opt )
+        {
+            case 'n':
+                pixels = (uint32_t) strtoul( optarg, NULL, 0 );
+                break;
+
+            case 'r':
+                reps = (uint32_t) strtoul( optarg, NULL, 0 );
+                break;
+
+            default:
+                fprintf( stderr, "Usage: %s [-n pixels] [-r repetitions]\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+
+    if ( (pixels == 0U) || (pixels > CODEC_BENCH_MAX_PIXELS) || (reps == 0U) )
+    {
+        fprintf( stderr, "pixels 1 .. %u, repetitions > 0\n", (unsigned int) CODEC_BENCH_MAX_PIXELS );
+        return 2;
+    }
+
+    srand( 1U );
+    printf( "%u pixels, %u repetitions\n", (unsigned int) pixels, (unsigned int) reps );
+    printf( "   noise    bytes   ratio  encode MB/s  decode MB/s    delta   ratio  round trip\n" );
+
+    for ( uint32_t c = 0U; c < sizeof(noiseCases) / sizeof(noiseCases[ 0 ]); c++ )
+    {
+        uint32_t size = 0U;
+        uint32_t deltaSize;
+        double t0;
+        double t1;
+        double t2;
+        int exact;
+
+        MakeSpectrum( previous, pixels, noiseCases[ c ] );
+        MakeSpectrum( spectrum, pixels, noiseCases[ c ] );
+
+        /* The device codes into the raw size - 1 and sends raw otherwise */
+        t0 = Seconds();
+        for ( uint32_t r = 0U; r < reps; r++ )
+        {
+            size = CODEC_RiceEncode( coded, 2U * pixels - 1U, spectrum, pixels );
+        }
+        t1 = Seconds();
+
+        if ( size == 0U )
+        {
+            /* Does not pay off, measure the decoder on the full code anyway */
+            size = CODEC_RiceEncode( coded, sizeof(coded), spectrum, pixels );
+        }
+
+        memset( decoded, 0, pixels * sizeof(uint16_t) );
+        t2 = Seconds();
+        for ( uint32_t r = 0U; r < reps; r++ )
+        {
+            exact = (CODEC_RiceDecode( decoded, pixels, coded, size ) == CODEC_OK);
+        }
+        t2 = Seconds() - t2;
+
+        exact = exact && (memcmp( decoded, spectrum, pixels * sizeof(uint16_t) ) == 0);
+
+        /* The decoder overwrites the reference with the new values */
+        deltaSize = CODEC_RiceEncodeDelta( coded, sizeof(coded), spectrum, previous, pixels );
+        exact = exact && (CODEC_RiceDecodeDelta( previous, pixels, coded, deltaSize, previous ) == CODEC_OK) &&
+                (memcmp( previous, spectrum, pixels * sizeof(uint16_t) ) == 0);
+
+        /* The synthetic spectra are within 12 bit */
+        exact = exact && (CODEC_Unpack12( decoded, pixels, coded,
+                                          CODEC_Pack12( coded, sizeof(coded), spectrum, pixels ) ) == CODEC_OK) &&
+                (memcmp( decoded, spectrum, pixels * sizeof(uint16_t) ) == 0);
+        failed |= !exact;
+
+        if ( noiseCases[ c ] == CODEC_BENCH_UNIFORM )
+        {
+            printf( " uniform" );
+        }
+        else
+        {
+            printf( " %7.1f", noiseCases[ c ] );
+        }
+        printf( " %8u %6.2f:1 %12.1f %12.1f %8u %6.2f:1  %s%s\n", (unsigned int) size,
+                (2.0 * pixels) / size,
+                (2.0 * pixels * reps) / (t1 - t0) / 1e6,
+                (2.0 * pixels * reps) / t2 / 1e6,
+                (unsigned int) deltaSize, (2.0 * pixels) / deltaSize,
+                exact ? "exact" : "MISMATCH",
+                (size >= 2U * pixels) ? ", sent raw" : "" );
+    }
+
+    printf( "log8 largest error %.2f %% of the value\n", Log8Error() * 100.0 );
+
+    return failed;
+}
+
+/*******************************************************************************
+ * @brief   Make a synthetic spectrum
+ * @param   data, uint16_t: Destination
+ * @param   pixels, uint32_t: Number of pixels
+ * @param   sigma, double: Standard deviation of the noise in counts, or
+ *          CODEC_BENCH_UNIFORM for uniform noise over 12 bit
+ * @retval  None
+ *
+ ******************************************************************************/
+static void MakeSpectrum(uint16_t *data, uint32_t pixels, double sigma)
+{
+    static const double peaks[][ 3 ] =
+    {
+        /* position, height, width as fractions of the sensor and full scale */
+        { 0.12, 0.35, 0.004 },
+        { 0.31, 0.90, 0.002 },
+        { 0.33, 0.40, 0.010 },
+        { 0.58, 0.70, 0.003 },
+        { 0.74, 0.20, 0.030 },
+        { 0.91, 0.55, 0.001 }
+    };
+
+    for ( uint32_t i = 0U; i < pixels; i++ )
+    {
+        double x = (double) i / pixels;
+        double v = 300.0 + 200.0 * x;
+
+        if ( sigma == CODEC_BENCH_UNIFORM )
+        {
+            data[ i ] = (uint16_t) (rand() & 0x0FFF);
+            continue;
+        }
+
+        for ( uint32_t p = 0U; p < sizeof(peaks) / sizeof(peaks[ 0 ]); p++ )
+        {
+            double d = (x - peaks[ p ][ 0 ]) / peaks[ p ][ 2 ];
+            v += peaks[ p ][ 1 ] * (CODEC_BENCH_FULL_SCALE - 600.0) * exp( -0.5 * d * d );
+        }
+
+        v += sigma * Gauss();
+        v = (v < 0.0) ? 0.0 : ((v > CODEC_BENCH_FULL_SCALE) ? CODEC_BENCH_FULL_SCALE : v);
+        data[ i ] = (uint16_t) lround( v );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Normal distributed random number (Box-Muller)
+ * @param   None
+ * @retval  Mean 0, standard deviation 1
+ *
+ ******************************************************************************/
+static double Gauss(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt( -2.0 * log( u1 ) ) * cos( 2.0 * M_PI * u2 );
+}
+
+static double Seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+/*******************************************************************************
+ * @brief   Largest relative error of the 8 bit log codes
+ * @param   None
+ * @retval  Largest |decoded - value| / value over the values 1 .. 65535
+ *
+ ******************************************************************************/
+static double Log8Error(void)
+{
+    double worst = 0.0;
+
+    for ( uint32_t v = 1U; v <= 0xFFFFU; v++ )
+    {
+        uint16_t value = (uint16_t) v;
+        uint16_t back;
+        uint8_t code;
+
+        (void) CODEC_Log8Encode( &code, 1U, &value, 1U );
+        (void) CODEC_Log8Decode( &back, 1U, &code, 1U );
+        worst = fmax( worst, fabs( (double) back - v ) / v );
+    }
+
+    return worst;
+}
+/****************************** END OF FILE ***********************************/
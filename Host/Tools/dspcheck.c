@@ -0,0 +1,359 @@
+/**
+ *******************************************************************************
+ * @file    : dspcheck.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host check of the DSP kernels against their references
+ *
+ * Compares the optimized kernels of tcd1304_dsp.c bit for bit with the
+ * scalar reference implementations on random data: TCD_DSP_Accumulate(),
+ * TCD_DSP_Load() and TCD_DSP_AccumulateAverage() for every tail length of
+ * the unrolled loops and the divisors 1 .. CFG_BOXCAR_MAX_FRAMES plus some
+ * large ones, and TCD_DSP_AccumulateBin() for bin widths and edge tables.
+ *
+ * On the host the kernels use the portable fallback of the packed halfword
+ * add, build the check for the target to cover the UXTAH path.
+ *
+ * Usage: dspcheck [-s seed]
+ * Exit status 0 if every kernel matches its reference.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tcd1304_conf.h"
+#include "tcd1304_dsp.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define DSPCHECK_BLOCK                  (64U)   /* Pixels before the tail    */
+#define DSPCHECK_MAX_PIXELS             (DSPCHECK_BLOCK + 8U)
+#define DSPCHECK_BIN_PIXELS             (CFG_CCD_NUM_PIXELS)
+#define DSPCHECK_BIN_ROUNDS             (20U)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+    uint32_t cases;
+    uint32_t mismatches;
+} RESULT_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t state = 1U;
+
+/* One spare element in front, to also run the kernels on odd addresses */
+static uint16_t data[ DSPCHECK_BIN_PIXELS + 1U ];
+static uint32_t accu[ DSPCHECK_BIN_PIXELS ];
+static uint32_t accuRef[ DSPCHECK_BIN_PIXELS ];
+static uint16_t out[ DSPCHECK_BIN_PIXELS ];
+static uint16_t outRef[ DSPCHECK_BIN_PIXELS ];
+static uint16_t edge[ DSPCHECK_BIN_PIXELS + 1U ];
+
+/* Divisors of the average besides 1 .. CFG_BOXCAR_MAX_FRAMES */
+static const uint32_t largeDivisors[] = { 100U, 255U, 1000U, 4097U, 32767U, 32768U, 40000U, 65535U, 65536U };
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Random(void);
+static void Fill(uint32_t len, uint32_t divisor);
+static void CheckAccumulate(RESULT_t *result);
+static void CheckLoad(RESULT_t *result);
+static void CheckAverage(RESULT_t *result, uint32_t divisor);
+static void CheckBin(RESULT_t *result, uint32_t divisor);
+static void Compare(RESULT_t *result, const char *name, const void *a, const void *b, size_t size, uint32_t len);
+static int Report(const char *name, const RESULT_t *result);
+
+/*******************************************************************************
+ * @brief   Run the checks of all kernels
+ * @param   argc, int: Number of arguments
+ * @param   argv, char: Arguments
+ * @retval  0 if every kernel matches its reference, 1 otherwise
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    RESULT_t accumulate = { 0U, 0U };
+    RESULT_t load = { 0U, 0U };
+    RESULT_t average = { 0U, 0U };
+    RESULT_t bin = { 0U, 0U };
+    int failed = 0;
+    int opt;
+
+    while ( (opt = getopt( argc, argv, "s:" )) != -1 )
+    {
+        switch ( opt )
+        {
+            case 's':
+                state = (uint32_t) strtoul( optarg, NULL, 0 );
+                break;
+
+            default:
+                fprintf( stderr, "Usage: %s [-s seed]\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+
+    /* Xorshift gets stuck at 0 */
+    if ( state == 0U )
+    {
+        state = 1U;
+    }
+
+    CheckAccumulate( &accumulate );
+    CheckLoad( &load );
+
+    for ( uint32_t d = 1U; d <= CFG_BOXCAR_MAX_FRAMES; d++ )
+    {
+        CheckAverage( &average, d );
+        CheckBin( &bin, d );
+    }
+
+    for ( uint32_t d = 0U; d < sizeof(largeDivisors) / sizeof(largeDivisors[ 0 ]); d++ )
+    {
+        CheckAverage( &average, largeDivisors[ d ] );
+        CheckBin( &bin, largeDivisors[ d ] );
+    }
+
+    failed |= Report( "TCD_DSP_Accumulate", &accumulate );
+    failed |= Report( "TCD_DSP_Load", &load );
+    failed |= Report( "TCD_DSP_AccumulateAverage", &average );
+    failed |= Report( "TCD_DSP_AccumulateBin", &bin );
+
+    return failed;
+}
+
+/*******************************************************************************
+ * @brief   Xorshift pseudo random numbers, repeatable for a seed
+ * @param   None
+ * @retval  Next number
+ *
+ ******************************************************************************/
+static uint32_t Random(void)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+/*******************************************************************************
+ * @brief   Fill the data with 16 bit values and the accumulators with sums
+ * @param   len, uint32_t: Number of pixels
+ * @param   divisor, uint32_t: Frames of the average, the accumulators hold the
+ *          sum of divisor - 1 frames
+ * @retval  None
+ *
+ ******************************************************************************/
+static void Fill(uint32_t len, uint32_t divisor)
+{
+    uint64_t range = 0xFFFFULL * (divisor - 1U) + 1U;
+
+    for ( uint32_t i = 0U; i < len + 1U; i++ )
+    {
+        data[ i ] = (uint16_t) Random();
+    }
+
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        /* Mostly anywhere in the range, sometimes at the top */
+        accu[ i ] = ((Random() & 7U) == 0U) ? (uint32_t) (range - 1U)
+                                            : (uint32_t) ((((uint64_t) Random() << 32) | Random()) % range);
+        accuRef[ i ] = accu[ i ];
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check TCD_DSP_Accumulate() for every tail length
+ * @param   result, RESULT_t: Counters to update
+ * @retval  None
+ *
+ ******************************************************************************/
+static void CheckAccumulate(RESULT_t *result)
+{
+    for ( uint32_t len = 0U; len < DSPCHECK_MAX_PIXELS; len++ )
+    {
+        for ( uint32_t offset = 0U; offset < 2U; offset++ )
+        {
+            Fill( len, CFG_BOXCAR_MAX_FRAMES );
+
+            TCD_DSP_Accumulate( accu, data + offset, len );
+            TCD_DSP_AccumulateRef( accuRef, data + offset, len );
+            Compare( result, "TCD_DSP_Accumulate", accu, accuRef, sizeof(accu[ 0 ]), len );
+        }
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check TCD_DSP_Load() for every tail length
+ * @param   result, RESULT_t: Counters to update
+ * @retval  None
+ *
+ * The reference of a load is an accumulation into cleared accumulators.
+ ******************************************************************************/
+static void CheckLoad(RESULT_t *result)
+{
+    for ( uint32_t len = 0U; len < DSPCHECK_MAX_PIXELS; len++ )
+    {
+        for ( uint32_t offset = 0U; offset < 2U; offset++ )
+        {
+            Fill( len, CFG_BOXCAR_MAX_FRAMES );
+            memset( accuRef, 0, sizeof(accuRef) );
+
+            TCD_DSP_Load( accu, data + offset, len );
+            TCD_DSP_AccumulateRef( accuRef, data + offset, len );
+            Compare( result, "TCD_DSP_Load", accu, accuRef, sizeof(accu[ 0 ]), len );
+        }
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check TCD_DSP_AccumulateAverage() for every tail length
+ * @param   result, RESULT_t: Counters to update
+ * @param   divisor, uint32_t: Frames of the average
+ * @retval  None
+ *
+ ******************************************************************************/
+static void CheckAverage(RESULT_t *result, uint32_t divisor)
+{
+    TCD_DSP_DIVIDER_t div;
+
+    TCD_DSP_DividerInit( &div, divisor );
+
+    for ( uint32_t len = 0U; len < DSPCHECK_MAX_PIXELS; len++ )
+    {
+        Fill( len, divisor );
+
+        TCD_DSP_AccumulateAverage( out, accu, data, len, &div );
+        TCD_DSP_AccumulateAverageRef( outRef, accu, data, len, divisor );
+        Compare( result, "TCD_DSP_AccumulateAverage", out, outRef, sizeof(out[ 0 ]), len );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check TCD_DSP_AccumulateBin() with fixed widths and edge tables
+ * @param   result, RESULT_t: Counters to update
+ * @param   divisor, uint32_t: Frames of the average
+ * @retval  None
+ *
+ * Every case runs with the last frame added on the fly and without. The sums
+ * of full scale pixels also cover the saturation of the bins.
+ ******************************************************************************/
+static void CheckBin(RESULT_t *result, uint32_t divisor)
+{
+    TCD_DSP_DIVIDER_t div;
+
+    TCD_DSP_DividerInit( &div, divisor );
+
+    for ( uint32_t width = 1U; width <= CFG_BIN_MAX_WIDTH; width++ )
+    {
+        uint32_t bins = DSPCHECK_BIN_PIXELS / width;
+
+        Fill( DSPCHECK_BIN_PIXELS, divisor );
+
+        TCD_DSP_AccumulateBin( out, accu, data, NULL, width, bins, &div );
+        TCD_DSP_AccumulateBinRef( outRef, accu, data, NULL, width, bins, divisor );
+        Compare( result, "TCD_DSP_AccumulateBin", out, outRef, sizeof(out[ 0 ]), bins );
+
+        TCD_DSP_AccumulateBin( out, accu, NULL, NULL, width, bins, &div );
+        TCD_DSP_AccumulateBinRef( outRef, accu, NULL, NULL, width, bins, divisor );
+        Compare( result, "TCD_DSP_AccumulateBin", out, outRef, sizeof(out[ 0 ]), bins );
+    }
+
+    for ( uint32_t round = 0U; round < DSPCHECK_BIN_ROUNDS; round++ )
+    {
+        uint32_t edges = 0U;
+
+        /* Ascending edges from a random start, widths 1 .. CFG_BIN_MAX_WIDTH */
+        edge[ 0 ] = (uint16_t) (Random() % 64U);
+        while ( (edges + 2U < CFG_MAX_BIN_EDGES) &&
+                (edge[ edges ] + CFG_BIN_MAX_WIDTH <= DSPCHECK_BIN_PIXELS) )
+        {
+            edge[ edges + 1U ] = (uint16_t) (edge[ edges ] + 1U + Random() % CFG_BIN_MAX_WIDTH);
+            edges++;
+        }
+
+        Fill( DSPCHECK_BIN_PIXELS, divisor );
+
+        TCD_DSP_AccumulateBin( out, accu, data, edge, 0U, edges, &div );
+        TCD_DSP_AccumulateBinRef( outRef, accu, data, edge, 0U, edges, divisor );
+        Compare( result, "TCD_DSP_AccumulateBin", out, outRef, sizeof(out[ 0 ]), edges );
+
+        TCD_DSP_AccumulateBin( out, accu, NULL, edge, 0U, edges, &div );
+        TCD_DSP_AccumulateBinRef( outRef, accu, NULL, edge, 0U, edges, divisor );
+        Compare( result, "TCD_DSP_AccumulateBin", out, outRef, sizeof(out[ 0 ]), edges );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Compare a kernel output with its reference and count the case
+ * @param   result, RESULT_t: Counters to update
+ * @param   name, char: Kernel, printed with the first differing element
+ * @param   a, void: Kernel output
+ * @param   b, void: Reference output
+ * @param   size, size_t: Bytes per element
+ * @param   len, uint32_t: Number of elements
+ * @retval  None
+ *
+ ******************************************************************************/
+static void Compare(RESULT_t *result, const char *name, const void *a, const void *b, size_t size, uint32_t len)
+{
+    result->cases++;
+
+    for ( uint32_t i = 0U; i < len; i++ )
+    {
+        if ( memcmp( (const uint8_t *) a + i * size, (const uint8_t *) b + i * size, size ) != 0 )
+        {
+            if ( result->mismatches == 0U )
+            {
+                fprintf( stderr, "%s: length %u differs at %u\n", name, (unsigned int) len, (unsigned int) i );
+            }
+            result->mismatches++;
+            return;
+        }
+    }
+}
+
+static int Report(const char *name, const RESULT_t *result)
+{
+    printf( "%-26s %6u cases %6u mismatches\n", name,
+            (unsigned int) result->cases, (unsigned int) result->mismatches );
+
+    return (result->mismatches != 0U) ? 1 : 0;
+}
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,418 @@
+/**
+ *******************************************************************************
+ * @file    : framecheck.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Host reference check of the spectrum frames
+ *
+ * Reads the frame stream from a file, a serial port or stdin, finds the frames
+ * as described in frame.h and checks each CRC with a bitwise reference
+ * implementation of CRC-32. The firmware calculates the CRC with the CRC
+ * unit of the MCU, so every good frame also verifies the hardware CRC.
+ * Coded frames are decoded with the codec of the firmware, see codec.h.
+ * Delta frames are decoded against the previous frame, a delta frame after a
+ * sequence gap is counted as a lost reference.
+ *
+ * Usage: framecheck [-r] [-k] [-n frames] [file]
+ *   -r  Request the frames: send "DATA;" at the start and after each frame
+ *   -k  Send "KEY;" for a keyframe when the reference of a delta frame is lost
+ *   -n  Stop after this many frames
+ * Exit status 0 if all frames found have a correct CRC and decode.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "codec.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* Wire format, see Inc/frame.h */
+#define FRAME_SYNC                      (0x46444354U)
+#define FRAME_VERSION                   (4U)
+#define FRAME_HEADER_SIZE               (44U)
+#define FRAME_CRC_SIZE                  (4U)
+#define FRAME_MAX_PAYLOAD_SIZE          (65536U)
+#define FRAME_ENCODING_RAW              (0U)
+#define FRAME_ENCODING_RICE             (1U)
+#define FRAME_ENCODING_DELTA            (2U)
+#define FRAME_ENCODING_PACK12           (3U)
+#define FRAME_ENCODING_LOG8             (4U)
+
+#define CRC32_POLYNOMIAL_REFLECTED      (0xEDB88320U)
+#define BUFFER_SIZE                     (2U * (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD_SIZE + FRAME_CRC_SIZE))
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t sequenceGaps;
+    uint32_t bytesSkipped;
+    uint32_t decodeErrors;
+    uint32_t lostReferences;
+} STATS_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t buffer[ BUFFER_SIZE ];
+/* Values of the last decoded frame, the reference of a delta frame */
+static uint16_t values[ FRAME_MAX_PAYLOAD_SIZE / 2U ];
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Crc32Reference(const uint8_t *data, uint32_t size);
+static uint32_t GetU32(const uint8_t *p);
+static uint16_t GetU16(const uint8_t *p);
+static void SetRaw(int fd);
+static int DecodeValues(const uint8_t *f, uint32_t valuesSize, int reference);
+
+/*******************************************************************************
+ * @brief   Read, parse and check the frames
+ * @param   argc, int: Number of arguments
+ * @param   argv, char: Arguments
+ * @retval  0 if all CRC were correct, 1 otherwise
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    STATS_t stats = { 0U, 0U, 0U, 0U, 0U, 0U };
+    uint32_t maxFrames = 0U;
+    uint32_t lastSequence = 0U;
+    int reference = 0;
+    int request = 0;
+    int key = 0;
+    size_t fill = 0U;
+    int fd = STDIN_FILENO;
+    int opt;
+
+    while ( (opt = getopt( argc, argv, "rkn:" )) != -1 )
+    {
+        switch ( opt )
+        {
+            case 'r':
+                request = 1;
+                break;
+
+            case 'k':
+                key = 1;
+                break;
+
+            case 'n':
+                maxFrames = (uint32_t) strtoul( optarg, NULL, 0 );
+                break;
+
+            default:
+                fprintf( stderr, "Usage: %s [-r] [-k] [-n frames] [file]\n", argv[ 0 ] );
+                return 2;
+        }
+    }
+
+    if ( optind < argc )
+    {
+        fd = open( argv[ optind ], ((request != 0) || (key != 0)) ? O_RDWR | O_NOCTTY : O_RDONLY );
+        if ( fd < 0 )
+        {
+            perror( argv[ optind ] );
+            return 2;
+        }
+        SetRaw( fd );
+    }
+
+    if ( request != 0 )
+    {
+        (void) write( fd, "DATA;", 5 );
+    }
+
+    while ( (maxFrames == 0U) || (stats.frames < maxFrames) )
+    {
+        ssize_t n = read( fd, buffer + fill, sizeof(buffer) - fill );
+        size_t pos = 0U;
+
+        if ( n <= 0 )
+        {
+            break;
+        }
+        fill += (size_t) n;
+
+        /* Consume all complete frames in the buffer */
+        while ( fill - pos >= FRAME_HEADER_SIZE )
+        {
+            const uint8_t *f = buffer + pos;
+            uint32_t payloadSize;
+            uint32_t size;
+            uint32_t tablesSize;
+            const uint8_t *tables;
+            int result;
+
+            if ( (GetU32( f ) != FRAME_SYNC) || (f[ 4 ] != FRAME_VERSION) ||
+                 (f[ 5 ] != FRAME_HEADER_SIZE) || (GetU32( f + 36 ) > FRAME_MAX_PAYLOAD_SIZE) )
+            {
+                pos++;
+                stats.bytesSkipped++;
+                continue;
+            }
+
+            payloadSize = GetU32( f + 36 );
+            size = FRAME_HEADER_SIZE + payloadSize;
+            if ( fill - pos < size + FRAME_CRC_SIZE )
+            {
+                break;
+            }
+
+            if ( Crc32Reference( f, size ) != GetU32( f + size ) )
+            {
+                /* Not a frame or corrupted, search from the next byte */
+                stats.crcErrors++;
+                pos++;
+                stats.bytesSkipped++;
+                continue;
+            }
+
+            if ( (stats.frames > 0U) && (GetU32( f + 8 ) != lastSequence + 1U) )
+            {
+                stats.sequenceGaps++;
+                reference = 0;
+            }
+            lastSequence = GetU32( f + 8 );
+            stats.frames++;
+
+            printf( "seq %u acq %u t %u ms t_int %u us t_icg %u us avg %u mode %u pixels %u bytes %u crc %08x",
+                    (unsigned int) GetU32( f + 8 ), (unsigned int) GetU32( f + 12 ),
+                    (unsigned int) GetU32( f + 16 ), (unsigned int) GetU32( f + 20 ),
+                    (unsigned int) GetU32( f + 24 ), (unsigned int) GetU32( f + 28 ),
+                    (unsigned int) f[ 6 ], (unsigned int) GetU16( f + 32 ),
+                    (unsigned int) payloadSize, (unsigned int) GetU32( f + size ) );
+
+            /* The window and bin edge tables end the payload, see frame.h */
+            tablesSize = 4U * GetU16( f + 34 ) + 2U * GetU16( f + 42 );
+            if ( tablesSize > payloadSize )
+            {
+                result = -1;
+            }
+            else
+            {
+                result = DecodeValues( f, payloadSize - tablesSize, reference );
+            }
+
+            /* Only a decoded frame is the reference of the next one */
+            reference = (result == 0);
+            if ( result != 0 )
+            {
+                if ( result > 0 )
+                {
+                    printf( " no reference\n" );
+                    stats.lostReferences++;
+                    if ( key != 0 )
+                    {
+                        (void) write( fd, "KEY;", 4 );
+                    }
+                }
+                else
+                {
+                    printf( " decode error\n" );
+                    stats.decodeErrors++;
+                }
+                pos += size + FRAME_CRC_SIZE;
+                continue;
+            }
+            tables = f + size - tablesSize;
+
+            for ( uint32_t w = 0U; w < GetU16( f + 34 ); w++ )
+            {
+                printf( " window %u:%u", (unsigned int) GetU16( tables + 4U * w ),
+                        (unsigned int) GetU16( tables + 4U * w + 2U ) );
+            }
+
+            if ( GetU16( f + 40 ) != 1U )
+            {
+                const uint8_t *edges = tables + 4U * GetU16( f + 34 );
+
+                printf( " bin %u edges %u", (unsigned int) GetU16( f + 40 ),
+                        (unsigned int) GetU16( f + 42 ) );
+                if ( GetU16( f + 42 ) > 0U )
+                {
+                    printf( " %u..%u", (unsigned int) GetU16( edges ),
+                            (unsigned int) GetU16( edges + 2U * (GetU16( f + 42 ) - 1U) ) );
+                }
+            }
+            printf( "\n" );
+            fflush( stdout );
+
+            pos += size + FRAME_CRC_SIZE;
+
+            if ( (request != 0) && ((maxFrames == 0U) || (stats.frames < maxFrames)) )
+            {
+                (void) write( fd, "DATA;", 5 );
+            }
+        }
+
+        memmove( buffer, buffer + pos, fill - pos );
+        fill -= pos;
+    }
+
+    fprintf( stderr, "%u frames, %u CRC errors, %u sequence gaps, %u bytes skipped, %u decode errors, "
+             "%u lost references\n",
+             (unsigned int) stats.frames, (unsigned int) stats.crcErrors,
+             (unsigned int) stats.sequenceGaps, (unsigned int) stats.bytesSkipped,
+             (unsigned int) stats.decodeErrors, (unsigned int) stats.lostReferences );
+
+    return ((stats.crcErrors == 0U) && (stats.decodeErrors == 0U)) ? 0 : 1;
+}
+
+/*******************************************************************************
+ * @brief   Bit by bit CRC-32 (IEEE 802.3), independent of any table
+ * @param   data, uint8_t: Data block
+ * @param   size, uint32_t: Bytes in the data block
+ * @retval  CRC-32
+ *
+ ******************************************************************************/
+static uint32_t Crc32Reference(const uint8_t *data, uint32_t size)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    uint32_t bit;
+
+    while ( size-- > 0U )
+    {
+        crc ^= *data++;
+        for ( bit = 0U; bit < 8U; bit++ )
+        {
+            crc = ((crc & 1U) != 0U) ? ((crc >> 1) ^ CRC32_POLYNOMIAL_REFLECTED) : (crc >> 1);
+        }
+    }
+
+    return ~crc;
+}
+
+static uint32_t GetU32(const uint8_t *p)
+{
+    return (uint32_t) p[ 0 ] | ((uint32_t) p[ 1 ] << 8) | ((uint32_t) p[ 2 ] << 16) | ((uint32_t) p[ 3 ] << 24);
+}
+
+static uint16_t GetU16(const uint8_t *p)
+{
+    return (uint16_t) (p[ 0 ] | (p[ 1 ] << 8));
+}
+
+/*******************************************************************************
+ * @brief   Decode the pixel values of a frame and print the coding
+ * @param   f, uint8_t: Frame with a correct CRC
+ * @param   valuesSize, uint32_t: Bytes of the payload before the tables
+ * @param   reference, int: 1 if values holds the frame before this one
+ * @retval  0 on success, -1 if the values do not decode to pixelCount values,
+ *          1 for a delta frame without its reference
+ *
+ ******************************************************************************/
+static int DecodeValues(const uint8_t *f, uint32_t valuesSize, int reference)
+{
+    uint32_t pixels = GetU16( f + 32 );
+
+    switch ( f[ 7 ] )
+    {
+        case FRAME_ENCODING_RAW:
+            if ( valuesSize != 2U * pixels )
+            {
+                return -1;
+            }
+            for ( uint32_t i = 0U; i < pixels; i++ )
+            {
+                values[ i ] = GetU16( f + FRAME_HEADER_SIZE + 2U * i );
+            }
+            return 0;
+
+        case FRAME_ENCODING_RICE:
+            if ( CODEC_RiceDecode( values, pixels, f + FRAME_HEADER_SIZE, valuesSize ) != CODEC_OK )
+            {
+                return -1;
+            }
+            printf( " rice %.2f:1", (valuesSize > 0U) ? (2.0 * pixels) / valuesSize : 0.0 );
+            return 0;
+
+        case FRAME_ENCODING_DELTA:
+            /* The values of the previous frame are decoded in place */
+            if ( reference == 0 )
+            {
+                return 1;
+            }
+            if ( CODEC_RiceDecodeDelta( values, pixels, f + FRAME_HEADER_SIZE, valuesSize, values ) != CODEC_OK )
+            {
+                return -1;
+            }
+            printf( " delta %.2f:1", (valuesSize > 0U) ? (2.0 * pixels) / valuesSize : 0.0 );
+            return 0;
+
+        case FRAME_ENCODING_PACK12:
+            if ( CODEC_Unpack12( values, pixels, f + FRAME_HEADER_SIZE, valuesSize ) != CODEC_OK )
+            {
+                return -1;
+            }
+            printf( " pack12" );
+            return 0;
+
+        case FRAME_ENCODING_LOG8:
+            /* Lossy, the values are the middle of the ranges of the codes */
+            if ( CODEC_Log8Decode( values, pixels, f + FRAME_HEADER_SIZE, valuesSize ) != CODEC_OK )
+            {
+                return -1;
+            }
+            printf( " log8" );
+            return 0;
+
+        default:
+            return -1;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Put a terminal into raw mode, ignored for other files
+ * @param   fd, int: File descriptor
+ * @retval  None
+ *
+ ******************************************************************************/
+static void SetRaw(int fd)
+{
+    struct termios tio;
+
+    if ( tcgetattr( fd, &tio ) == 0 )
+    {
+        cfmakeraw( &tio );
+        tcsetattr( fd, TCSANOW, &tio );
+    }
+}
+/****************************** END OF FILE ***********************************/
@@ -68,6 +68,10 @@ CLI_ERR_t CLI_Init(UART_HandleTypeDef *puart);
 
 void CLI_CheckInputBuffer(void);
 
+void CLI_Process(void);
+
+void CLI_RxIdleCallback(void);
+
 #ifdef __cplusplus
 }
 #endif
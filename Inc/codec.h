@@ -0,0 +1,135 @@
+/**
+ *******************************************************************************
+ * @file    : codec.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Lossless coding of the spectrum payload
+ *
+ * The spectrum values are coded without loss for the link:
+ *
+ *  - The first value is sent as it is, every following value as the difference
+ *    to its left neighbour. Averaged spectra are smooth, so the differences
+ *    are small.
+ *  - The differences are mapped to unsigned numbers, 0, -1, 1, -2, 2 ... ->
+ *    0, 1, 2, 3, 4 ..., and Rice coded in blocks of CODEC_RICE_BLOCK values.
+ *    Each block starts with its Rice parameter k in CODEC_RICE_K_BITS bits,
+ *    chosen from the mean of the block, so the code follows the noise level
+ *    along the spectrum.
+ *  - A value u is sent as u >> k in unary (ones ended by a zero) followed by
+ *    the k low bits of u. A quotient of CODEC_RICE_ESCAPE or more is sent as
+ *    CODEC_RICE_ESCAPE ones followed by u in CODEC_RICE_RAW_BITS bits, which
+ *    bounds the cost of a spike.
+ *  - With a reference, e.g. the previous spectrum, every value including the
+ *    first is sent as the difference to the same pixel of the reference,
+ *    see CODEC_RiceEncodeDelta(). The reference must be the values the
+ *    decoder holds, so the differences of the quantized values never drift.
+ *
+ * All fields are written MSB first, the last byte is padded with zero bits.
+ *
+ * Two fixed size codes are for other needs:
+ *
+ *  - CODEC_Pack12() packs two values of up to 12 bit, the ADC resolution,
+ *    into 3 bytes: value a in the first byte and the low nibble of the
+ *    second, value b in the high nibble of the second and the third byte.
+ *    An odd last value takes 2 bytes.
+ *  - CODEC_Log8Encode() sends every value as an 8 bit code on a log scale,
+ *    a lossy preview of the full 16 bit range. Codes up to
+ *    CODEC_LOG8_LINEAR are the values, above each code covers a range about
+ *    3.5 % wide that CODEC_Log8Decode() returns the middle of.
+ *
+ * The module has no hardware dependencies and is also built for the host,
+ * where CODEC_RiceDecode() is the decoder of the frames, see frame.h.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    CODEC_OK = 0,
+    CODEC_ERROR,
+
+    /* Error codes for parameter inputs */
+    CODEC_ERR_PARAM_OUT_OF_RANGE,
+    CODEC_ERR_NULL_POINTER,
+
+    /* The coded data is truncated or not a valid code */
+    CODEC_ERR_CORRUPT
+} CODEC_ERR_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#define CODEC_RICE_BLOCK                (16U)   /* Values per Rice parameter */
+#define CODEC_RICE_K_BITS               (5U)
+#define CODEC_RICE_MAX_K                (16U)
+#define CODEC_RICE_ESCAPE               (32U)   /* Unary length of the escape */
+#define CODEC_RICE_RAW_BITS             (17U)   /* Mapped 16 bit difference  */
+
+#define CODEC_PACK12_MAX                (0x0FFFU)
+#define CODEC_PACK12_SIZE(count)        ((3U * (count) + 1U) / 2U)
+#define CODEC_LOG8_LINEAR               (32U)
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+uint32_t    CODEC_RiceEncode(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count);
+CODEC_ERR_t CODEC_RiceDecode(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize);
+
+uint32_t    CODEC_RiceEncodeDelta(uint8_t *dst, uint32_t dstSize, const uint16_t *src,
+                                  const uint16_t *ref, uint32_t count);
+CODEC_ERR_t CODEC_RiceDecodeDelta(uint16_t *dst, uint32_t count, const uint8_t *src,
+                                  uint32_t srcSize, const uint16_t *ref);
+
+uint32_t    CODEC_Pack12(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count);
+CODEC_ERR_t CODEC_Unpack12(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize);
+
+uint32_t    CODEC_Log8Encode(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count);
+CODEC_ERR_t CODEC_Log8Decode(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CODEC_H_ */
@@ -0,0 +1,111 @@
+/**
+ *******************************************************************************
+ * @file    : crc32.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : CRC-32 with the hardware CRC unit fed by DMA
+ *
+ * The CRC unit of the STM32F7 is fed with 32-bit words by a memory-to-memory
+ * DMA transfer, so the CPU only starts the transfer and collects the result.
+ * The unit is configured for the reflected CRC-32 model with CRC32_POLYNOMIAL:
+ * initial value 0xFFFFFFFF, reflected input and output, final XOR 0xFFFFFFFF.
+ * With the default polynomial this is the CRC-32 of zlib and IEEE 802.3.
+ *
+ * CRC32_Software() is the table-driven reference. It is used instead of the
+ * hardware for unaligned data and in builds without HAL_CRC_MODULE_ENABLED,
+ * e.g. the host build.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f7xx_hal.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    CRC32_OK = 0,
+    CRC32_ERROR,
+
+    /* Error codes for parameter inputs */
+    CRC32_ERR_PARAM_OUT_OF_RANGE,
+    CRC32_ERR_NULL_POINTER,
+
+    /* Serious errors */
+    CRC32_ERR_BUSY,
+    CRC32_ERR_INIT
+} CRC32_ERR_t;
+
+/* Exported defines ----------------------------------------------------------*/
+/**
+ * Generator polynomial in normal (MSB-first) notation. The default gives the
+ * standard CRC-32, 0x1EDC6F41 gives CRC-32C (Castagnoli).
+ */
+#ifndef CRC32_POLYNOMIAL
+    #define CRC32_POLYNOMIAL                (0x04C11DB7U)
+#endif
+
+#if defined( HAL_CRC_MODULE_ENABLED )
+    #define CRC32_HARDWARE                  (1U)
+#else
+    #define CRC32_HARDWARE                  (0U)
+#endif
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+CRC32_ERR_t CRC32_Init(void);
+
+CRC32_ERR_t CRC32_Start(const uint8_t *data, uint32_t size);
+uint8_t     CRC32_IsBusy(void);
+uint32_t    CRC32_GetResult(void);
+
+uint32_t    CRC32_Calculate(const uint8_t *data, uint32_t size);
+uint32_t    CRC32_Software(uint32_t crc, const uint8_t *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H_ */
@@ -0,0 +1,110 @@
+/**
+ *******************************************************************************
+ * @file    : event.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Events that wake the main loop
+ *
+ * Interrupts raise events with EVENT_Set(). The main loop waits for them with
+ * EVENT_Wait(), and the core sleeps in WFI while no event is pending. In
+ * EVENT_LOOP_POLL the wait returns at once with all events set. That is the
+ * free-running loop, kept to compare the response latency and the CPU load.
+ *
+ * The command latency is measured from the USART idle-line interrupt at the
+ * end of a command to the end of its processing by the CLI. The idle line is
+ * detected one character time after the last stop bit. The polling loop can
+ * finish before that, so the latency is signed. All times are in cycles of
+ * TCD_PORT_CycleCounter_Get().
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef EVENT_H_
+#define EVENT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    EVENT_LOOP_POLL = 0,            /* Never sleep, run everything each pass */
+    EVENT_LOOP_SLEEP                /* Sleep in WFI until an event           */
+} EVENT_LOOP_t;
+
+typedef struct
+{
+    int32_t latency;                /* Cycles, last command                  */
+    int32_t maxLatency;             /* Cycles, slowest command               */
+    uint32_t commands;              /* Commands measured                     */
+    uint32_t sleepPermille;         /* Share of the time spent in WFI        */
+} EVENT_STATS_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#define EVENT_RX                        (0x01U)     /* CLI bytes received        */
+#define EVENT_DATA                      (0x02U)     /* New average, frame work   */
+#define EVENT_TX                        (0x04U)     /* A transmission completed  */
+#define EVENT_TICK                      (0x08U)     /* EVENT_TICK_MS elapsed     */
+#define EVENT_ALL                       (0xFFFFFFFFU)
+
+/* Period of the tick event for timeouts and retries */
+#ifndef EVENT_TICK_MS
+    #define EVENT_TICK_MS                   (10U)
+#endif
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+void         EVENT_Init(void);
+void         EVENT_Set(uint32_t events);
+uint32_t     EVENT_Wait(void);
+
+void         EVENT_SetLoop(EVENT_LOOP_t loop);
+EVENT_LOOP_t EVENT_GetLoop(void);
+
+void         EVENT_RxIdle(void);
+void         EVENT_CommandDone(void);
+void         EVENT_GetStats(EVENT_STATS_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_H_ */
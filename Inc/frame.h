@@ -0,0 +1,171 @@
+/**
+ *******************************************************************************
+ * @file    : frame.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Framed binary output of the spectrum data
+ *
+ * Every spectrum is sent as one frame, all fields little-endian:
+ *
+ *  Offset Size Field
+ *       0    4 sync         FRAME_SYNC, the bytes 'T' 'C' 'D' 'F'
+ *       4    1 version      FRAME_VERSION
+ *       5    1 headerSize   FRAME_HEADER_SIZE, offset of the payload
+ *       6    1 avgMode      TCD_AVG_MODE_t of the average
+ *       7    1 encoding     FRAME_ENCODING_t of the pixel values
+ *       8    4 sequence     Frame counter, +1 for every frame sent
+ *      12    4 acquisitions Spectrums acquired since start (modulo 2^32)
+ *      16    4 timestamp    Milliseconds since start when the data was read
+ *      20    4 t_int_us     Integration time
+ *      24    4 t_icg_us     Readout period
+ *      28    4 avg          Frames in the average, ema_alpha (Q16) in EMA mode
+ *      32    2 pixelCount   Number of pixels (or bins) in the payload
+ *      34    2 windows      Number of pixel windows, 0 for all pixels
+ *      36    4 payloadSize  Bytes of payload
+ *      40    2 bin          Pixels per bin, 1 without binning, 0 for edges
+ *      42    2 binEdges     Number of bin edges, 0 unless bin is 0
+ *      44    n payload      pixelCount values, then windows x
+ *                           { uint16_t first, uint16_t count }, then
+ *                           binEdges x uint16_t
+ *    44+n    4 crc          CRC-32 of header and payload, see crc32.h
+ *
+ * With pixel windows the payload holds the pixels of each window in turn,
+ * followed by the window table that gives the sensor index of the first
+ * pixel and the number of pixels of each window.
+ *
+ * With binning every value is the sum of bin neighbouring pixels, starting
+ * at the first pixel of each window; pixels at the end of a window that do
+ * not fill a bin are not sent. With bin edges, bin k is the sum of the
+ * pixels edge[ k ] .. edge[ k + 1 ] - 1 of the edge table at the end of the
+ * payload, and there are no windows.
+ *
+ * The values are pixelCount x uint16_t with FRAME_ENCODING_RAW. With
+ * FRAME_ENCODING_RICE they are coded by CODEC_RiceEncode(), see codec.h, and
+ * take the payload up to the window table, payloadSize - 4 x windows -
+ * 2 x binEdges bytes. The device falls back to raw for a frame that does
+ * not get smaller.
+ *
+ * With FRAME_ENCODING_DELTA the values are coded by CODEC_RiceEncodeDelta()
+ * as differences to the values of the frame with the previous sequence
+ * number, the reference. Frames with another encoding are keyframes. A
+ * receiver that has not got the reference, seen as a gap in the sequence
+ * numbers, cannot decode the frame and waits for the next keyframe, or asks
+ * for one, see STREAM_RequestKeyframe().
+ *
+ * FRAME_ENCODING_PACK12 packs the values into 3 bytes per 2 values with
+ * CODEC_Pack12(). The device sends raw values instead when a binned value
+ * does not fit 12 bit. FRAME_ENCODING_LOG8 is a lossy preview with one byte
+ * per value, see CODEC_Log8Encode().
+ *
+ * To synchronize, the receiver searches for the sync word, checks version,
+ * headerSize and payloadSize, and accepts the frame when the CRC matches.
+ * Otherwise it continues the search from the byte after the sync word, so a
+ * lost or corrupted byte costs at most the frame it is in.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "tcd1304_conf.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+/**
+ * Matches the wire format above. All fields are naturally aligned, so the
+ * struct has no padding.
+ */
+typedef struct
+{
+    uint32_t sync;
+    uint8_t  version;
+    uint8_t  headerSize;
+    uint8_t  avgMode;
+    uint8_t  encoding;
+    uint32_t sequence;
+    uint32_t acquisitions;
+    uint32_t timestamp;
+    uint32_t t_int_us;
+    uint32_t t_icg_us;
+    uint32_t avg;
+    uint16_t pixelCount;
+    uint16_t windows;
+    uint32_t payloadSize;
+    uint16_t bin;
+    uint16_t binEdges;
+} FRAME_HEADER_t;
+
+typedef enum
+{
+    FRAME_ENCODING_RAW = 0,         /* uint16_t per value                    */
+    FRAME_ENCODING_RICE,            /* Differences, Rice coded, see codec.h  */
+    FRAME_ENCODING_DELTA,           /* Rice coded against the previous frame */
+    FRAME_ENCODING_PACK12,          /* 12 bit values, 3 bytes per 2 values   */
+    FRAME_ENCODING_LOG8             /* 8 bit log codes, lossy preview        */
+} FRAME_ENCODING_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#define FRAME_SYNC                      (0x46444354U)   /* "TCDF" */
+#define FRAME_VERSION                   (4U)
+#define FRAME_HEADER_SIZE               (44U)
+#define FRAME_CRC_SIZE                  (4U)
+#define FRAME_WINDOW_SIZE               (4U)
+#define FRAME_EDGE_SIZE                 (2U)
+#define FRAME_MAX_PAYLOAD_SIZE          (2U * CFG_CCD_NUM_PIXELS + \
+                                         FRAME_WINDOW_SIZE * CFG_MAX_WINDOWS + \
+                                         FRAME_EDGE_SIZE * CFG_MAX_BIN_EDGES)
+#define FRAME_MAX_SIZE                  (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD_SIZE + FRAME_CRC_SIZE)
+
+/* Exported macros -----------------------------------------------------------*/
+/* Payload of a frame buffer. The buffer must be 32-bit aligned */
+#define FRAME_PAYLOAD(frame)            ((uint8_t *) (frame) + FRAME_HEADER_SIZE)
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+uint32_t FRAME_Prepare(uint8_t *frame, FRAME_HEADER_t *header);
+uint32_t FRAME_Finish(uint8_t *frame, uint32_t size, uint32_t crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_H_ */
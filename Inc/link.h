@@ -0,0 +1,130 @@
+/**
+ *******************************************************************************
+ * @file    : link.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Serial link to the host: baud rate negotiation and throughput
+ *
+ * USART1 runs from SYSCLK (216 MHz), so the baud rate goes up to 27 Mbit/s
+ * with 8x oversampling. The ST-Link virtual COM port of the Discovery board is
+ * slower than that; use a USB-serial adapter on the Arduino header for the
+ * highest rates.
+ *
+ * Baud rate switch handshake:
+ * 1. Host sends             "BAUD=<rate>;"  at the current rate
+ * 2. Firmware replies       "BAUD = <rate>" at the current rate and switches.
+ *                           A rate that can not be set within
+ *                           LINK_MAX_BAUD_ERROR_PERMILLE is answered with the
+ *                           current rate and nothing changes.
+ * 3. Host switches and sends ";BAUDOK;" at the new rate. The leading ';'
+ *                           flushes any bytes garbled by the switch.
+ * 4. Firmware replies       "BAUDOK = <rate>" at the new rate.
+ * If the confirmation does not arrive within LINK_CONFIRM_TIMEOUT_MS, the
+ * firmware returns to the previous rate and sends "BAUD = <previous rate>".
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f7xx_hal.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    LINK_OK = 0,
+    LINK_ERROR,
+
+    /* Error codes for parameter inputs */
+    LINK_ERR_PARAM_OUT_OF_RANGE,
+    LINK_ERR_NULL_POINTER,
+
+    /* Serious errors */
+    LINK_ERR_BUSY,
+    LINK_ERR_NOT_INITIALIZED
+} LINK_ERR_t;
+
+typedef struct
+{
+    uint32_t baud;                  /* Current baud rate                    */
+    uint32_t bytesPerSecond;        /* Average since the last report        */
+    uint32_t lastBytesPerSecond;    /* During the last frame transfer       */
+    uint32_t frames;                /* Frames sent since the last report    */
+} LINK_THROUGHPUT_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef LINK_DEFAULT_BAUD
+    #define LINK_DEFAULT_BAUD               (115200U)
+#endif
+
+#ifndef LINK_CONFIRM_TIMEOUT_MS
+    #define LINK_CONFIRM_TIMEOUT_MS         (2000U)
+#endif
+
+/* Largest accepted difference between the requested and the real baud rate */
+#ifndef LINK_MAX_BAUD_ERROR_PERMILLE
+    #define LINK_MAX_BAUD_ERROR_PERMILLE    (15U)
+#endif
+
+#define LINK_MIN_BAUD                       (4800U)
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+LINK_ERR_t LINK_Init(UART_HandleTypeDef *huart);
+void       LINK_Process(void);
+
+LINK_ERR_t LINK_RequestBaud(uint32_t baud);
+LINK_ERR_t LINK_ConfirmBaud(void);
+uint32_t   LINK_GetBaud(void);
+uint8_t    LINK_IsTxAllowed(void);
+
+void       LINK_TxStarted(uint32_t size);
+void       LINK_TxCompleted(void);
+void       LINK_GetThroughput(LINK_THROUGHPUT_t *tput);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_H_ */
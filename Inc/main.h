@@ -380,7 +380,19 @@
 /* #define USE_FULL_ASSERT    1U */
 
 /* USER CODE BEGIN Private defines */
+/**
+ * Places a buffer accessed by a DMA in the non-cacheable DMA RAM. The section
+ * is mapped by TrueStudio/STM32F746NGHx_FLASH.ld and
+ * MDK-ARM/TCD-Spectrometer-DISCO.sct, the MPU setup is in MPU_Config().
+ * The host build has no DMA and no such section.
+ */
+#define DMA_BUFFER_SECTION              ".dma_buffer"
 
+#if defined ( __arm__ )
+  #define DMA_BUFFER                    __attribute__((section(DMA_BUFFER_SECTION)))
+#else
+  #define DMA_BUFFER
+#endif
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
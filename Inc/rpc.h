@@ -0,0 +1,202 @@
+/**
+ *******************************************************************************
+ * @file    : rpc.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Binary request/response protocol for the configuration
+ *
+ * Binary requests share the UART with the ASCII commands of cli.c. A request
+ * starts with RPC_SYNC, which never occurs in the ASCII commands, all fields
+ * little-endian:
+ *
+ *  Offset Size Field
+ *       0    1 sync         RPC_SYNC
+ *       1    1 length       n, bytes of id, opcode and arguments
+ *       2    2 id           Chosen by the host, copied to the response
+ *       4    1 opcode       RPC_OP_t
+ *       5  n-3 arguments    See RPC_OP_t
+ *     2+n    4 crc          CRC-32 of length .. arguments, see crc32.h
+ *
+ * The response has the same layout with a status byte after the opcode:
+ *
+ *       0    1 sync         RPC_SYNC
+ *       1    1 length       n, bytes of id, opcode, status and result
+ *       2    2 id           id of the request
+ *       4    1 opcode       opcode of the request
+ *       5    1 status       RPC_STATUS_t, the result is empty if not RPC_STATUS_OK
+ *       6  n-4 result       See RPC_OP_t
+ *     2+n    4 crc          CRC-32 of length .. result
+ *
+ * A request with a bad length or CRC is dropped without a response, the host
+ * retries it after a timeout. Requests are executed in order, but the
+ * responses of one pass of the main loop are sent together after it, so they
+ * can overtake the acks of ASCII commands. Match them by id.
+ *
+ * While the transmit queue cannot take more responses, the CLI leaves the
+ * received bytes in its ring buffer, so the host can have up to about 1 KB of
+ * requests in flight without losing a response.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef RPC_H_
+#define RPC_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    RPC_OK = 0,
+    RPC_ERROR,
+
+    /* Run-time states of RPC_ProcessByte() */
+    RPC_BUSY,                       /* Byte taken, the request is incomplete */
+    RPC_ERR_FRAME                   /* Bad length or CRC, request dropped    */
+} RPC_ERR_t;
+
+/**
+ * Arguments and result of the opcodes, param is RPC_PARAM_t, value uint32_t.
+ */
+typedef enum
+{
+    RPC_OP_PING = 0x01,             /* -                  -> RPC_VERSION     */
+    RPC_OP_GET = 0x02,              /* param              -> value           */
+    RPC_OP_SET = 0x03,              /* param, value       -> value applied   */
+    RPC_OP_GET_BLOCK = 0x04,        /* param, count       -> count x value   */
+    RPC_OP_RUN = 0x05,              /* -                  -> -               */
+    RPC_OP_STOP = 0x06,             /* -                  -> -               */
+    RPC_OP_DATA = 0x07,             /* -                  -> -, one frame    */
+    RPC_OP_KEYFRAME = 0x08          /* -                  -> -, next is key  */
+} RPC_OP_t;
+
+typedef enum
+{
+    RPC_STATUS_OK = 0,
+    RPC_STATUS_UNKNOWN_OPCODE,
+    RPC_STATUS_BAD_LENGTH,          /* Arguments do not match the opcode     */
+    RPC_STATUS_UNKNOWN_PARAM,
+    RPC_STATUS_READ_ONLY,
+    RPC_STATUS_OUT_OF_RANGE,
+    RPC_STATUS_FAILED               /* Accepted but could not be applied     */
+} RPC_STATUS_t;
+
+/**
+ * Parameters of GET and SET. 0x00 .. 0x0F are the fields of TCD_CONFIG_t,
+ * 0x10 .. 0x1F other settings and 0x20 .. 0x3F read-only status counters.
+ * 0x40 .. 0xFF are the elements of the arrays of TCD_CONFIG_t, one id per
+ * element. GET_BLOCK reads consecutive ids, an unused id reads as 0.
+ *
+ * Every SET is checked against the whole configuration. Elements beyond
+ * WINDOWS, and the bin edges while BIN is not 0, are not in use and take any
+ * value. A new table is written there first and taken into use with WINDOWS
+ * or with BIN_EDGES and BIN=0.
+ */
+typedef enum
+{
+    RPC_PARAM_AVG = 0x00,
+    RPC_PARAM_F_MASTER = 0x01,      /* Read-only                             */
+    RPC_PARAM_T_ICG_US = 0x02,      /* May round T_INT_US up, as SH=         */
+    RPC_PARAM_T_INT_US = 0x03,      /* Rounded by TCD_SetIntTime()           */
+    RPC_PARAM_AVG_MODE = 0x04,      /* TCD_AVG_MODE_t                        */
+    RPC_PARAM_EMA_ALPHA = 0x05,     /* Q16, 1 .. TCD_EMA_ALPHA_ONE           */
+    RPC_PARAM_BIN = 0x06,           /* Pixels per bin, 0 for the edge table  */
+    RPC_PARAM_WINDOWS = 0x07,       /* Windows in use, 0 for all pixels      */
+    RPC_PARAM_BIN_EDGES = 0x08,     /* Edges in the table, bins + 1          */
+
+    RPC_PARAM_STREAM_MODE = 0x10,   /* STREAM_MODE_t                         */
+    RPC_PARAM_LOOP = 0x11,          /* EVENT_LOOP_t                          */
+    RPC_PARAM_ENCODING = 0x12,      /* FRAME_ENCODING_t of the frames        */
+
+    RPC_PARAM_SPECTRUMS = 0x20,     /* Modulo 2^32                           */
+    RPC_PARAM_QUEUE_DEPTH = 0x21,
+    RPC_PARAM_QUEUE_HIGH_WATER = 0x22,
+    RPC_PARAM_FRAMES_DROPPED = 0x23,
+    RPC_PARAM_STREAM_SENT = 0x24,
+    RPC_PARAM_STREAM_DROPPED = 0x25,
+    RPC_PARAM_STREAM_SKIPPED = 0x26,
+    RPC_PARAM_TX_OVERFLOWS = 0x27,
+    RPC_PARAM_BAUD = 0x28,
+    RPC_PARAM_RPC_REQUESTS = 0x29,
+    RPC_PARAM_RPC_ERRORS = 0x2A,    /* Requests dropped for length or CRC    */
+    RPC_PARAM_CONFIG_PENDING = 0x2B,    /* 1 until a SET reaches the averaging */
+    RPC_PARAM_F_MASTER_ERR_HZ = 0x2C,   /* int32_t, see TCD_GetTiming()        */
+    RPC_PARAM_T_INT_ERR_NS = 0x2D,      /* int32_t                             */
+    RPC_PARAM_T_ICG_ERR_NS = 0x2E,      /* int32_t                             */
+    RPC_PARAM_STREAM_KEYFRAMES = 0x2F,
+    RPC_PARAM_READ_ERRORS = 0x30,   /* Readouts lost to an ADC DMA error     */
+
+    RPC_PARAM_WINDOW = 0x40,        /* first of window 0, then count, ...    */
+    RPC_PARAM_BIN_EDGE = 0x50       /* Edge 0, edge 1, ...                   */
+} RPC_PARAM_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#define RPC_SYNC                            (0xA5U)
+#define RPC_VERSION                         (1U)
+
+#define RPC_HEADER_SIZE                     (2U)    /* sync, length         */
+#define RPC_CRC_SIZE                        (4U)
+#define RPC_REQUEST_MIN_LENGTH              (3U)    /* id, opcode           */
+#define RPC_RESPONSE_MIN_LENGTH             (4U)    /* id, opcode, status   */
+
+#ifndef RPC_MAX_LENGTH
+    #define RPC_MAX_LENGTH                  (64U)
+#endif
+
+/* A request is abandoned when the line pauses longer inside it */
+#ifndef RPC_BYTE_TIMEOUT_MS
+    #define RPC_BYTE_TIMEOUT_MS             (20U)
+#endif
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+void      RPC_Init(void);
+RPC_ERR_t RPC_ProcessByte(uint8_t byte);
+uint8_t   RPC_IsReceiving(void);
+uint8_t   RPC_IsStalled(void);
+void      RPC_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPC_H_ */
@@ -50,6 +50,7 @@
 void SysTick_Handler(void);
 void DMA2_Stream2_IRQHandler(void);
 void DMA2_Stream7_IRQHandler(void);
+void USART1_IRQHandler(void);
 
 #ifdef __cplusplus
 }
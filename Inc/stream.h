@@ -0,0 +1,117 @@
+/**
+ *******************************************************************************
+ * @file    : stream.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Output of the averaged spectra to the host
+ *
+ * In polled mode one frame is sent for each DATA request. In stream mode every
+ * new average is sent without a request, as fast as the link allows.
+ *
+ * Two frame buffers are used: one being sent and one waiting. When a new
+ * average arrives while both are in use, STREAM_MODE_DROP_OLDEST replaces the
+ * waiting frame with the new one and STREAM_MODE_SKIP discards the new one.
+ * Both are counted in STREAM_STATS_t.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "frame.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    STREAM_OK = 0,
+    STREAM_ERROR,
+
+    /* Error codes for parameter inputs */
+    STREAM_ERR_PARAM_OUT_OF_RANGE
+} STREAM_ERR_t;
+
+typedef enum
+{
+    STREAM_MODE_POLLED = 0,         /* One frame per STREAM_Request()        */
+    STREAM_MODE_DROP_OLDEST,        /* Every average, the newest one wins    */
+    STREAM_MODE_SKIP                /* Every average, the waiting one wins   */
+} STREAM_MODE_t;
+
+typedef struct
+{
+    uint32_t sent;                  /* Frames handed to the UART             */
+    uint32_t dropped;               /* Waiting frames replaced by newer ones */
+    uint32_t skipped;               /* New averages not sent                 */
+    uint32_t keyframes;             /* Frames sent without a reference       */
+} STREAM_STATS_t;
+
+/* Exported defines ----------------------------------------------------------*/
+/**
+ * With FRAME_ENCODING_DELTA every STREAM_KEYFRAME_INTERVAL frames is a
+ * keyframe, so a receiver that lost a frame recovers without asking.
+ */
+#ifndef STREAM_KEYFRAME_INTERVAL
+    #define STREAM_KEYFRAME_INTERVAL    (32U)
+#endif
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+STREAM_ERR_t  STREAM_Init(void);
+void          STREAM_Process(void);
+
+void          STREAM_Request(void);
+STREAM_ERR_t  STREAM_SetMode(STREAM_MODE_t mode);
+STREAM_MODE_t STREAM_GetMode(void);
+STREAM_ERR_t  STREAM_SetEncoding(FRAME_ENCODING_t encoding);
+FRAME_ENCODING_t STREAM_GetEncoding(void);
+void          STREAM_RequestKeyframe(void);
+
+void          STREAM_GetStats(STREAM_STATS_t *stats);
+void          STREAM_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_H_ */
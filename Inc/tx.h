@@ -0,0 +1,119 @@
+/**
+ *******************************************************************************
+ * @file    : tx.h
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Prioritized non-blocking transmit queue of the host UART
+ *
+ * All output to the host goes through this queue: the CLI replies, the link
+ * messages and the spectrum frames. A transfer is started by the UART TX DMA,
+ * and the transmit complete interrupt starts the next one, so no caller waits
+ * for the UART.
+ *
+ * The highest priority entry is sent first, and entries of equal priority go
+ * in order. A transfer that is running is never interrupted, so an ack waits
+ * for at most one spectrum frame.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+#ifndef TX_H_
+#define TX_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f7xx_hal.h"
+
+/* Exported typedefs ---------------------------------------------------------*/
+typedef enum
+{
+    TX_OK = 0,
+    TX_ERROR,
+
+    /* Error codes for parameter inputs */
+    TX_ERR_PARAM_OUT_OF_RANGE,
+    TX_ERR_NULL_POINTER,
+
+    /* Run-time errors */
+    TX_ERR_QUEUE_FULL,
+
+    /* Serious errors */
+    TX_ERR_NOT_INITIALIZED
+} TX_ERR_t;
+
+typedef enum
+{
+    TX_PRIO_ACK = 0,                /* Replies to commands, sent first       */
+    TX_PRIO_TELEMETRY,              /* Unrequested status messages           */
+    TX_PRIO_DATA,                   /* Spectrum frames                       */
+    TX_NUM_PRIO
+} TX_PRIO_t;
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* Number of transfers that can be queued, including the one being sent */
+#ifndef TX_QUEUE_SIZE
+    #define TX_QUEUE_SIZE                   (8U)
+#endif
+
+/* Largest message copied by TX_Send(), the size of the CLI reply buffer */
+#ifndef TX_MSG_SIZE
+    #define TX_MSG_SIZE                     (96U)
+#endif
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Exported function prototypes ----------------------------------------------*/
+TX_ERR_t TX_Init(UART_HandleTypeDef *huart);
+void     TX_Process(void);
+
+TX_ERR_t TX_Send(TX_PRIO_t prio, const void *data, uint32_t size);
+TX_ERR_t TX_SendBuffer(TX_PRIO_t prio, const void *data, uint32_t size);
+
+uint8_t  TX_IsPending(const void *data);
+uint8_t  TX_IsIdle(void);
+uint32_t TX_GetFree(void);
+uint32_t TX_GetOverflows(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TX_H_ */
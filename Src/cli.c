@@ -41,15 +41,24 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include "main.h"
 #include "cli.h"
 #include "tcd1304.h"
+#include "crc32.h"
+#include "link.h"
+#include "stream.h"
+#include "tx.h"
+#include "event.h"
+#include "rpc.h"
 
 /* Private defines -----------------------------------------------------------*/
-#define RING_BUFFER_SIZE                ((uint32_t) 256U)
+/* Holds a window of pipelined binary requests, see rpc.h */
+#define RING_BUFFER_SIZE                ((uint32_t) 1024U)
 #define CMD_BUFFER_SIZE                 ((uint32_t) 10U)
-#define PARAM_BUFFER_SIZE               ((uint32_t) 20U)
+#define PARAM_BUFFER_SIZE               ((uint32_t) 48U)
 #define COMMAND_BUFFER_SIZE             ((uint32_t) CMD_BUFFER_SIZE + PARAM_BUFFER_SIZE + 2U)
 
 /* Private typedefs ----------------------------------------------------------*/
@@ -68,20 +77,44 @@ typedef struct
     char cmd[ CMD_BUFFER_SIZE ];
     char param[ PARAM_BUFFER_SIZE ];
     uint8_t pos;
+    uint8_t timed;                  /* A command of this pass was timed      */
 } CLI_PCB_t;
 
+typedef struct
+{
+    uint8_t pending;                /* Waiting for the CRC unit              */
+    uint32_t size;                  /* Bytes in CLI_crcData                  */
+    uint32_t t0;                    /* Cycle counter at the start            */
+    uint32_t cpuCycles;             /* CPU cycles spent on the CRC unit      */
+} CLI_CRC_BENCH_t;
+
 /* Private macros ------------------------------------------------------------*/
 /* External variables --------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-static CLI_RING_BUFFER_t ringBuffer;
+/* Written by the UART RX DMA, placed in the non-cacheable DMA RAM */
+static CLI_RING_BUFFER_t ringBuffer DMA_BUFFER;
 static UART_HandleTypeDef *CLI_uart;
 static CLI_PCB_t pcb;
 
+/* Bin edge table being entered with EDGES=, taken into use with BIN=0 */
+static uint16_t CLI_binEdge[ CFG_MAX_BIN_EDGES ];
+static uint32_t CLI_binEdges;
+
+/**
+ * Snapshot of the average for the CRC command, the driver can update
+ * SensorDataAvg while the CRC unit reads it. Words keep it aligned for the DMA.
+ */
+static uint32_t CLI_crcData[ (CFG_CCD_NUM_PIXELS + 1U) / 2U ];
+static CLI_CRC_BENCH_t CLI_crc;
+
 /* Private function prototypes -----------------------------------------------*/
 static void CLI_ClearCommand(void);
 static CLI_ERR_t CLI_GetCommand(void);
 static CLI_ERR_t CLI_ProcessCommand(char byte);
+static void CLI_CommandDone(void);
 static CLI_ERR_t CLI_IF_Init(void);
+static CLI_ERR_t CLI_ParseWindows(const char *param, TCD_CONFIG_t *config);
+static CLI_ERR_t CLI_ParseEdges(const char *param);
 
 extern void _Error_Handler(char *, int);
 
@@ -105,6 +138,7 @@ CLI_ERR_t CLI_Init(UART_HandleTypeDef *puart)
 
     CLI_uart = puart;
     CLI_ClearCommand();
+    RPC_Init();
 
     return CLI_IF_Init();
 }
@@ -114,41 +148,113 @@ CLI_ERR_t CLI_Init(UART_HandleTypeDef *puart)
  * @param   None
  * @retval  None
  * The DMA transfers data from RS485 interface to a RAM ring buffer.
- * This function makes sure the tail is equal the head.
+ * This function makes sure the tail is equal the head, unless the binary
+ * responses have to wait for the transmit queue, see RPC_IsStalled().
  *
  ******************************************************************************/
 void CLI_CheckInputBuffer(void)
 {
     char byte;
     ringBuffer.head = RING_BUFFER_SIZE - CLI_uart->hdmarx->Instance->NDTR;
+    pcb.timed = 0U;
 
-    if ( ringBuffer.tail < ringBuffer.head )
+    /* head == tail means no new data */
+    while ( ringBuffer.tail != ringBuffer.head )
     {
-        while ( ringBuffer.tail < ringBuffer.head )
+        /* Continued by the next transmit complete event */
+        if ( RPC_IsStalled() == 1U )
         {
-            byte = ringBuffer.serialDataBuffer[ ringBuffer.tail++ ];
-            CLI_ProcessCommand( byte );
+            break;
         }
+
+        byte = ringBuffer.serialDataBuffer[ ringBuffer.tail ];
+        ringBuffer.tail = (ringBuffer.tail + 1U) % RING_BUFFER_SIZE;
+        CLI_ProcessCommand( byte );
     }
-    else if ( ringBuffer.tail > ringBuffer.head )
+
+    RPC_Flush();
+}
+
+/*******************************************************************************
+ * @brief   Finish the CRC command once the CRC unit is done
+ * @param   None
+ * @retval  None
+ *
+ * Called from the main loop. The CRC DMA has no interrupt, the main loop is
+ * kept polling with EVENT_DATA until the result is in.
+ ******************************************************************************/
+void CLI_Process(void)
+{
+    char ack[ 64 ];
+
+    if ( CLI_crc.pending == 0U )
     {
-        while ( ringBuffer.tail < sizeof(ringBuffer.serialDataBuffer) )
-        {
-            byte = ringBuffer.serialDataBuffer[ ringBuffer.tail++ ];
-            CLI_ProcessCommand( byte );
-        }
-        ringBuffer.tail = 0U;
+        return;
+    }
 
-        /* Catch up the head that has wrapped around zero */
-        while ( ringBuffer.tail < ringBuffer.head )
-        {
-            byte = ringBuffer.serialDataBuffer[ ringBuffer.tail++ ];
-            CLI_ProcessCommand( byte );
-        }
+    if ( CRC32_IsBusy() == 1U )
+    {
+        EVENT_Set( EVENT_DATA );
+        return;
     }
-    else
+
+    uint32_t t2 = TCD_PORT_CycleCounter_Get();
+    uint32_t hw = CRC32_GetResult();
+    uint32_t t3 = TCD_PORT_CycleCounter_Get();
+
+    uint32_t sw = CRC32_Software( 0U, (const uint8_t *) CLI_crcData, CLI_crc.size );
+    uint32_t t4 = TCD_PORT_CycleCounter_Get();
+
+    CLI_crc.pending = 0U;
+
+    /* Cycles until done, CPU cycles of the CRC unit, software cycles, match */
+    sprintf( ack, "CRC = %u,%u,%u,%u\r\n",
+             (unsigned int) (t3 - CLI_crc.t0),
+             (unsigned int) (CLI_crc.cpuCycles + (t3 - t2)),
+             (unsigned int) (t4 - t3),
+             (hw == sw) ? 1U : 0U );
+    (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+}
+
+/*******************************************************************************
+ * @brief   The line has been idle for one character after received data
+ * @param   None
+ * @retval  None
+ *
+ * Called from the USART interrupt, the end of a command burst.
+ ******************************************************************************/
+void CLI_RxIdleCallback(void)
+{
+    EVENT_RxIdle();
+    EVENT_Set( EVENT_RX );
+}
+
+/*******************************************************************************
+ * @brief   The receive DMA has filled the first half of the ring buffer
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ * A long burst without a pause is processed before the DMA overwrites it.
+ ******************************************************************************/
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    if ( huart == CLI_uart )
     {
-        /* head == tail = 0 means no new data */
+        EVENT_Set( EVENT_RX );
+    }
+}
+
+/*******************************************************************************
+ * @brief   The receive DMA has filled the ring buffer and wraps around
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ ******************************************************************************/
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if ( huart == CLI_uart )
+    {
+        EVENT_Set( EVENT_RX );
     }
 }
 
@@ -170,10 +276,25 @@ static CLI_ERR_t CLI_IF_Init(void)
     uint16_t TxSize = (uint16_t) sizeof(ringBuffer.serialDataBuffer);
     uint8_t *RxBufAddr = (uint8_t *) ringBuffer.serialDataBuffer;
 
+    /* The DMA RAM is not initialized by the startup code */
+    memset( &ringBuffer, 0, sizeof(ringBuffer) );
+
     if ( HAL_UART_Receive_DMA( CLI_uart, RxBufAddr, TxSize ) != HAL_OK )
     {
         status = CLI_ERR_NOT_INITIALIZED;
     }
+
+    /**
+     * The USART interrupt is enabled for the end of the transmissions. A line
+     * error would make the HAL abort the reception, so the error interrupts
+     * are disabled and the circular DMA simply goes on.
+     */
+    CLEAR_BIT( CLI_uart->Instance->CR1, USART_CR1_PEIE );
+    CLEAR_BIT( CLI_uart->Instance->CR3, USART_CR3_EIE );
+
+    /* A pause on the line ends a command, see CLI_RxIdleCallback() */
+    __HAL_UART_CLEAR_IDLEFLAG( CLI_uart );
+    __HAL_UART_ENABLE_IT( CLI_uart, UART_IT_IDLE );
     return status;
 }
 
@@ -187,6 +308,22 @@ static CLI_ERR_t CLI_IF_Init(void)
  ******************************************************************************/
 static CLI_ERR_t CLI_ProcessCommand(char byte)
 {
+    /* Binary requests start with a byte that is never part of a command */
+    if ( ((uint8_t) byte == RPC_SYNC) || (RPC_IsReceiving() == 1U) )
+    {
+        RPC_ERR_t status = RPC_ProcessByte( (uint8_t) byte );
+
+        if ( status == RPC_OK )
+        {
+            CLI_CommandDone();
+        }
+
+        if ( status != RPC_ERROR )
+        {
+            return CLI_OK;
+        }
+    }
+
     if ( (byte != ';') && (byte != ' ') && (byte != '\r') && (byte != '\n') )
     {
         if ( pcb.pos < sizeof(pcb.buffer) )
@@ -215,60 +352,404 @@ static CLI_ERR_t CLI_ProcessCommand(char byte)
 
         char *cmd = pcb.cmd;
         char *param = pcb.param;
-        char ack[ 32 ];
+        char ack[ 96 ];
 
         /**
          * Process the command with correct actions.
          */
+        /**
+         * The configuration commands change a copy of the configuration and
+         * apply it at the next ICG pulse, see TCD_Reconfigure(). The acks
+         * show the value in use, which is unchanged if it was rejected.
+         */
         if ( strcmp( cmd, "SH=" ) == 0 )
         {
-            uint32_t t_sh_us = atoi( param );
             extern TCD_CONFIG_t sensor_config;
-            sensor_config.t_int_us = t_sh_us;
-            TCD_SetIntTime( &sensor_config );
+            TCD_CONFIG_t config = sensor_config;
+            config.t_int_us = atoi( param );
+
+            /* Rounded up to the next divisor of the ICG period */
+            if ( TCD_SetIntTime( &config ) == TCD_OK )
+            {
+                sensor_config = config;
+            }
 
-            sprintf( ack, "SH = %u\r\n", (unsigned int) t_sh_us );
-            HAL_UART_Transmit( CLI_uart, (uint8_t *) ack, strlen( ack ), 1000U );
+            sprintf( ack, "SH = %u\r\n", (unsigned int) sensor_config.t_int_us );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
         }
 
         else if ( strcmp( cmd, "ICG=" ) == 0 )
         {
-            uint32_t t_icg_us = atoi( param );
             extern TCD_CONFIG_t sensor_config;
-            sensor_config.t_icg_us = t_icg_us;
+            TCD_CONFIG_t config = sensor_config;
+            config.t_icg_us = atoi( param );
 
-            sprintf( ack, "ICG = %u\r\n", (unsigned int) t_icg_us );
-            HAL_UART_Transmit( CLI_uart, (uint8_t *) ack, strlen( ack ), 1000U );
+            /* The SH period is rounded up to a divisor of the new period */
+            if ( TCD_SetIntTime( &config ) == TCD_OK )
+            {
+                sensor_config = config;
+            }
+
+            sprintf( ack, "ICG = %u\r\n", (unsigned int) sensor_config.t_icg_us );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
         }
 
         else if ( strcmp( cmd, "AVG=" ) == 0 )
         {
-            uint32_t avg = atoi( param );
             extern TCD_CONFIG_t sensor_config;
-            sensor_config.avg = avg;
+            TCD_CONFIG_t config = sensor_config;
+            config.avg = atoi( param );
+
+            if ( TCD_Reconfigure( &config ) == TCD_OK )
+            {
+                sensor_config = config;
+            }
+
+            sprintf( ack, "AVG = %u\r\n", (unsigned int) sensor_config.avg );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "MODE=" ) == 0 )
+        {
+            uint32_t mode = atoi( param );
+            extern TCD_CONFIG_t sensor_config;
+            TCD_CONFIG_t config = sensor_config;
+
+            /* 0 = block, 1 = boxcar, 2 = EMA */
+            if ( mode <= (uint32_t) TCD_AVG_EMA )
+            {
+                config.avg_mode = (TCD_AVG_MODE_t) mode;
+
+                if ( TCD_Reconfigure( &config ) == TCD_OK )
+                {
+                    sensor_config = config;
+                }
+            }
+
+            sprintf( ack, "MODE = %u\r\n", (unsigned int) sensor_config.avg_mode );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "ALPHA=" ) == 0 )
+        {
+            extern TCD_CONFIG_t sensor_config;
+            TCD_CONFIG_t config = sensor_config;
+
+            /* Q16 smoothing factor of the EMA, 1 .. 65536 */
+            config.ema_alpha = atoi( param );
+
+            if ( TCD_Reconfigure( &config ) == TCD_OK )
+            {
+                sensor_config = config;
+            }
 
-            sprintf( ack, "AVG = %u\r\n", (unsigned int) avg );
-            HAL_UART_Transmit( CLI_uart, (uint8_t *) ack, strlen( ack ), 1000U );
+            sprintf( ack, "ALPHA = %u\r\n", (unsigned int) sensor_config.ema_alpha );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "ROI=" ) == 0 )
+        {
+            extern TCD_CONFIG_t sensor_config;
+            TCD_CONFIG_t config = sensor_config;
+            uint32_t len;
+
+            /* first:count,first:count ... in sensor pixels, 0 for all pixels */
+            if ( CLI_ParseWindows( param, &config ) == CLI_OK )
+            {
+                if ( TCD_Reconfigure( &config ) == TCD_OK )
+                {
+                    sensor_config = config;
+                }
+            }
+
+            if ( sensor_config.windows == 0U )
+            {
+                sprintf( ack, "ROI = 0:%u\r\n", (unsigned int) CFG_CCD_NUM_PIXELS );
+            }
+            else
+            {
+                len = sprintf( ack, "ROI = " );
+                for ( uint32_t w = 0U; w < sensor_config.windows; w++ )
+                {
+                    len += sprintf( &ack[ len ], "%s%u:%u", (w > 0U) ? "," : "",
+                                    (unsigned int) sensor_config.window[ w ].first,
+                                    (unsigned int) sensor_config.window[ w ].count );
+                }
+                sprintf( &ack[ len ], "\r\n" );
+            }
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "BIN=" ) == 0 )
+        {
+            extern TCD_CONFIG_t sensor_config;
+            TCD_CONFIG_t config = sensor_config;
+
+            /* Pixels per bin 1, 2, 4, 8, 16; 0 for the table entered with EDGES= */
+            config.bin = atoi( param );
+
+            if ( config.bin == TCD_BIN_EDGES )
+            {
+                config.binEdges = CLI_binEdges;
+                memcpy( config.binEdge, CLI_binEdge, sizeof(config.binEdge) );
+            }
+
+            if ( TCD_Reconfigure( &config ) == TCD_OK )
+            {
+                sensor_config = config;
+            }
+
+            sprintf( ack, "BIN = %u\r\n", (unsigned int) sensor_config.bin );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "EDGES=" ) == 0 )
+        {
+            /* e,e,... starts a new bin edge table, +e,e,... appends to it */
+            if ( CLI_ParseEdges( param ) != CLI_OK )
+            {
+                CLI_binEdges = 0U;
+            }
+
+            sprintf( ack, "EDGES = %u\r\n", (unsigned int) CLI_binEdges );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "TIMING" ) == 0 )
+        {
+            extern TCD_CONFIG_t sensor_config;
+            TCD_TIMING_t timing;
+
+            /* Achieved f_master and its error in Hz, then t_int and t_icg in us
+               with the error of the generated periods in ns */
+            if ( TCD_GetTiming( &sensor_config, &timing ) == TCD_OK )
+            {
+                sprintf( ack, "TIMING = %u,%d,%u,%d,%u,%d\r\n",
+                         (unsigned int) timing.f_master,
+                         (int) timing.f_master_err_hz,
+                         (unsigned int) timing.t_int_us,
+                         (int) timing.t_int_err_ns,
+                         (unsigned int) timing.t_icg_us,
+                         (int) timing.t_icg_err_ns );
+                (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+            }
         }
 
         else if ( strcmp( cmd, "DATA" ) == 0 )
         {
-            extern volatile uint8_t requestToSendFlag;
-            requestToSendFlag = 1U;
+            STREAM_Request();
+        }
+
+        else if ( strcmp( cmd, "STAT" ) == 0 )
+        {
+            TCD_QUEUE_STATS_t stats;
+            TCD_GetQueueStats( &stats );
+
+            /* Frame queue depth, high-water mark, dropped frames and DMA errors */
+            sprintf( ack, "STAT = %u,%u,%u,%u\r\n",
+                     (unsigned int) stats.queueDepth,
+                     (unsigned int) stats.queueHighWater,
+                     (unsigned int) stats.framesDropped,
+                     (unsigned int) stats.readErrors );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "PROF" ) == 0 )
+        {
+            TCD_PROFILE_t profile;
+            TCD_GetProfile( &profile );
+
+            /* CPU cycles of the last and slowest accumulate, average and ADC IRQ */
+            sprintf( ack, "PROF = %u,%u,%u,%u,%u,%u\r\n",
+                     (unsigned int) profile.accumulateCycles,
+                     (unsigned int) profile.accumulateMaxCycles,
+                     (unsigned int) profile.averageCycles,
+                     (unsigned int) profile.averageMaxCycles,
+                     (unsigned int) profile.irqCycles,
+                     (unsigned int) profile.irqMaxCycles );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "CRC" ) == 0 )
+        {
+            /* Benchmark the CRC unit against the software CRC on one spectrum */
+            TCD_DATA_INFO_t info;
+
+            if ( CLI_crc.pending == 1U )
+            {
+                sprintf( ack, "CRC = BUSY\r\n" );
+                (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+            }
+            else if ( TCD_ReadSensorDataAvg( (uint16_t *) CLI_crcData, &info ) != TCD_OK )
+            {
+                sprintf( ack, "CRC = ERROR\r\n" );
+                (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+            }
+            else
+            {
+                CLI_crc.size = 2U * info.pixelCount;
+                CLI_crc.t0 = TCD_PORT_CycleCounter_Get();
+
+                if ( CRC32_Start( (const uint8_t *) CLI_crcData, CLI_crc.size ) == CRC32_OK )
+                {
+                    /* Finished by CLI_Process() */
+                    CLI_crc.cpuCycles = TCD_PORT_CycleCounter_Get() - CLI_crc.t0;
+                    CLI_crc.pending = 1U;
+                    EVENT_Set( EVENT_DATA );
+                }
+                else
+                {
+                    /* A frame checksum is pending */
+                    sprintf( ack, "CRC = BUSY\r\n" );
+                    (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+                }
+            }
+        }
+
+        else if ( strcmp( cmd, "BAUD=" ) == 0 )
+        {
+            uint32_t baud = atoi( param );
+
+            /* On success the link acknowledges and switches, see link.h */
+            if ( LINK_RequestBaud( baud ) != LINK_OK )
+            {
+                sprintf( ack, "BAUD = %u\r\n", (unsigned int) LINK_GetBaud() );
+                (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+            }
+        }
+
+        else if ( strcmp( cmd, "BAUDOK" ) == 0 )
+        {
+            (void) LINK_ConfirmBaud();
+
+            sprintf( ack, "BAUDOK = %u\r\n", (unsigned int) LINK_GetBaud() );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "TPUT" ) == 0 )
+        {
+            LINK_THROUGHPUT_t tput;
+            LINK_GetThroughput( &tput );
+
+            /* Bytes/s since the last TPUT, bytes/s of the last frame, frames, baud */
+            sprintf( ack, "TPUT = %u,%u,%u,%u\r\n",
+                     (unsigned int) tput.bytesPerSecond,
+                     (unsigned int) tput.lastBytesPerSecond,
+                     (unsigned int) tput.frames,
+                     (unsigned int) tput.baud );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "STREAM=" ) == 0 )
+        {
+            uint32_t mode = atoi( param );
+
+            /* 0 = polled by DATA, 1 = stream and drop oldest, 2 = stream and skip */
+            if ( (STREAM_SetMode( (STREAM_MODE_t) mode ) == STREAM_OK) &&
+                 (mode != STREAM_MODE_POLLED) )
+            {
+                STREAM_ResetStats();
+            }
+
+            sprintf( ack, "STREAM = %u\r\n", (unsigned int) STREAM_GetMode() );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "ENC=" ) == 0 )
+        {
+            /* 0 = raw uint16_t, 1 = differences and Rice codes,
+               2 = keyframes and Rice coded differences to the previous frame,
+               3 = 12 bit packed, 4 = 8 bit log preview */
+            (void) STREAM_SetEncoding( (FRAME_ENCODING_t) atoi( param ) );
+
+            sprintf( ack, "ENC = %u\r\n", (unsigned int) STREAM_GetEncoding() );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "KEY" ) == 0 )
+        {
+            /* The receiver lost the reference of the delta frames */
+            STREAM_RequestKeyframe();
+        }
+
+        else if ( strcmp( cmd, "SSTAT" ) == 0 )
+        {
+            STREAM_STATS_t stats;
+            STREAM_GetStats( &stats );
+
+            /* Frames sent, dropped, skipped and keyframes since streaming was started */
+            sprintf( ack, "SSTAT = %u,%u,%u,%u\r\n",
+                     (unsigned int) stats.sent,
+                     (unsigned int) stats.dropped,
+                     (unsigned int) stats.skipped,
+                     (unsigned int) stats.keyframes );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "LOOP=" ) == 0 )
+        {
+            uint32_t loop = atoi( param );
+
+            /* 0 = poll without sleeping, 1 = sleep in WFI between events */
+            EVENT_SetLoop( (loop != 0U) ? EVENT_LOOP_SLEEP : EVENT_LOOP_POLL );
+
+            sprintf( ack, "LOOP = %u\r\n", (unsigned int) EVENT_GetLoop() );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "LAT" ) == 0 )
+        {
+            EVENT_STATS_t stats;
+            EVENT_GetStats( &stats );
+
+            /* Cycles from the idle line to the command done, last and max,
+               commands measured, permille of the time asleep since last LAT */
+            sprintf( ack, "LAT = %d,%d,%u,%u\r\n",
+                     (int) stats.latency,
+                     (int) stats.maxLatency,
+                     (unsigned int) stats.commands,
+                     (unsigned int) stats.sleepPermille );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+        }
+
+        else if ( strcmp( cmd, "DCACHE=" ) == 0 )
+        {
+            uint32_t enable = atoi( param );
+
+            /**
+             * Switch the D-cache to compare the cycle counts with and without.
+             * SCB_EnableDCache() invalidates without cleaning, it must not run
+             * on an enabled cache or the dirty lines are lost.
+             */
+            if ( (SCB->CCR & SCB_CCR_DC_Msk) == 0U )
+            {
+                if ( enable != 0U )
+                {
+                    SCB_EnableDCache();
+                }
+            }
+            else if ( enable == 0U )
+            {
+                SCB_DisableDCache();
+            }
+            TCD_ResetProfile();
+
+            sprintf( ack, "DCACHE = %u\r\n", ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) ? 1U : 0U );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
         }
 
         else if ( strcmp( cmd, "RUN" ) == 0 )
         {
             TCD_Start();
             sprintf( ack, "RUN()\r\n" );
-            HAL_UART_Transmit( CLI_uart, (uint8_t *) ack, strlen( ack ), 1000U );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
         }
 
         else if ( strcmp( cmd, "STOP" ) == 0 )
         {
             TCD_Stop();
             sprintf( ack, "STOP()\r\n" );
-            HAL_UART_Transmit( CLI_uart, (uint8_t *) ack, strlen( ack ), 1000U );
+            (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
         }
 
         else
@@ -276,12 +757,30 @@ static CLI_ERR_t CLI_ProcessCommand(char byte)
             /* No command found */
         }
 
+        CLI_CommandDone();
         CLI_ClearCommand();
     }
 
     return CLI_OK;
 }
 
+/*******************************************************************************
+ * @brief   A command or binary request has been executed
+ * @param   None
+ * @retval  None
+ *
+ * Later commands of the same burst queue behind the first one, only the first
+ * one is timed.
+ ******************************************************************************/
+static void CLI_CommandDone(void)
+{
+    if ( pcb.timed == 0U )
+    {
+        EVENT_CommandDone();
+        pcb.timed = 1U;
+    }
+}
+
 /*******************************************************************************
  * @brief   Iterate through the buffer and find the command and parameter string.
  * @param   None
@@ -309,6 +808,99 @@ static CLI_ERR_t CLI_GetCommand(void)
     return CLI_OK;
 }
 
+/*******************************************************************************
+ * @brief   Parse a list of pixel windows into a sensor configuration
+ * @param   param, const char *: first:count pairs separated by ','; "0" or
+ *          an empty string selects all pixels
+ * @param   config, TCD_CONFIG_t *: receives the windows
+ * @retval  CLI_OK, or CLI_ERR_PARAM_OUT_OF_RANGE on a malformed list. The
+ *          driver checks the windows themselves in TCD_Reconfigure().
+ *
+ ******************************************************************************/
+static CLI_ERR_t CLI_ParseWindows(const char *param, TCD_CONFIG_t *config)
+{
+    const char *pos = param;
+    char *end;
+    unsigned long first;
+    unsigned long count;
+    uint32_t windows = 0U;
+
+    if ( (param[ 0 ] == 0) || (strcmp( param, "0" ) == 0) )
+    {
+        config->windows = 0U;
+        return CLI_OK;
+    }
+
+    while ( *pos != 0 )
+    {
+        if ( windows >= CFG_MAX_WINDOWS )
+        {
+            return CLI_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        first = strtoul( pos, &end, 10 );
+        if ( (end == pos) || (*end != ':') || (first > CFG_CCD_NUM_PIXELS) )
+        {
+            return CLI_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        pos = end + 1;
+        count = strtoul( pos, &end, 10 );
+        if ( (end == pos) || ((*end != ',') && (*end != 0)) || (count > CFG_CCD_NUM_PIXELS) )
+        {
+            return CLI_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        config->window[ windows ].first = (uint16_t) first;
+        config->window[ windows ].count = (uint16_t) count;
+
+        windows++;
+        pos = (*end == ',') ? (end + 1) : end;
+    }
+
+    config->windows = windows;
+    return CLI_OK;
+}
+
+/*******************************************************************************
+ * @brief   Parse a list of bin edges into the bin edge table of the CLI
+ * @param   param, const char *: Pixel indices separated by ','; a leading
+ *          '+' appends them to the table instead of starting a new one
+ * @retval  CLI_OK, or CLI_ERR_PARAM_OUT_OF_RANGE on a malformed list or a
+ *          full table. The driver checks the edges when BIN=0 uses them.
+ *
+ ******************************************************************************/
+static CLI_ERR_t CLI_ParseEdges(const char *param)
+{
+    const char *pos = param;
+    char *end;
+    unsigned long edge;
+
+    if ( *pos == '+' )
+    {
+        pos++;
+    }
+    else
+    {
+        CLI_binEdges = 0U;
+    }
+
+    while ( *pos != 0 )
+    {
+        edge = strtoul( pos, &end, 10 );
+        if ( (end == pos) || ((*end != ',') && (*end != 0)) || (edge > CFG_CCD_NUM_PIXELS) ||
+             (CLI_binEdges >= CFG_MAX_BIN_EDGES) )
+        {
+            return CLI_ERR_PARAM_OUT_OF_RANGE;
+        }
+
+        CLI_binEdge[ CLI_binEdges++ ] = (uint16_t) edge;
+        pos = (*end == ',') ? (end + 1) : end;
+    }
+
+    return CLI_OK;
+}
+
 /*******************************************************************************
  * @brief   Clear the command buffers
  * @param   None
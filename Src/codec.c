@@ -0,0 +1,684 @@
+/**
+ *******************************************************************************
+ * @file    : codec.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Lossless coding of the spectrum payload
+ *
+ * Delta and adaptive Rice coding, see codec.h
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "codec.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* Private typedefs ----------------------------------------------------------*/
+
+/**
+ * MSB first bit stream. Up to 7 bits wait in bits until a byte is complete,
+ * so a field of up to 56 bits can be added at once.
+ */
+typedef struct
+{
+    uint8_t *pos;
+    uint8_t *end;
+    uint64_t bits;
+    uint32_t count;                 /* Bits waiting in bits                  */
+    uint32_t overflow;              /* Set when the buffer is too small      */
+} CODEC_WRITER_t;
+
+typedef struct
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint64_t bits;
+    uint32_t count;                 /* Valid low bits of bits                */
+} CODEC_READER_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+
+/**
+ * Smallest value of each 8 bit log code. The first CODEC_LOG8_LINEAR + 1
+ * codes are the values, then the bounds grow by a factor of
+ * (65536 / 32) ^ (1 / 224) = 1.0346 per code, so code 256 would start at
+ * 65536.
+ */
+static const uint16_t CODEC_log8Bound[ 256 ] =
+{
+        0U,     1U,     2U,     3U,     4U,     5U,     6U,     7U,
+        8U,     9U,    10U,    11U,    12U,    13U,    14U,    15U,
+       16U,    17U,    18U,    19U,    20U,    21U,    22U,    23U,
+       24U,    25U,    26U,    27U,    28U,    29U,    30U,    31U,
+       32U,    33U,    34U,    35U,    37U,    38U,    39U,    41U,
+       42U,    43U,    45U,    47U,    48U,    50U,    52U,    53U,
+       55U,    57U,    59U,    61U,    63U,    65U,    68U,    70U,
+       72U,    75U,    78U,    80U,    83U,    86U,    89U,    92U,
+       95U,    98U,   102U,   105U,   109U,   113U,   117U,   121U,
+      125U,   129U,   134U,   138U,   143U,   148U,   153U,   158U,
+      164U,   170U,   176U,   182U,   188U,   194U,   201U,   208U,
+      215U,   223U,   230U,   238U,   247U,   255U,   264U,   273U,
+      283U,   292U,   303U,   313U,   324U,   335U,   347U,   359U,
+      371U,   384U,   397U,   411U,   425U,   440U,   455U,   471U,
+      487U,   504U,   522U,   540U,   558U,   578U,   598U,   618U,
+      640U,   662U,   685U,   709U,   733U,   758U,   785U,   812U,
+      840U,   869U,   899U,   930U,   963U,   996U,  1030U,  1066U,
+     1103U,  1141U,  1181U,  1222U,  1264U,  1308U,  1353U,  1400U,
+     1448U,  1498U,  1550U,  1604U,  1659U,  1717U,  1776U,  1838U,
+     1901U,  1967U,  2035U,  2106U,  2179U,  2254U,  2332U,  2413U,
+     2497U,  2583U,  2672U,  2765U,  2861U,  2960U,  3062U,  3168U,
+     3278U,  3391U,  3509U,  3630U,  3756U,  3886U,  4021U,  4160U,
+     4304U,  4453U,  4607U,  4767U,  4932U,  5102U,  5279U,  5462U,
+     5651U,  5847U,  6049U,  6259U,  6475U,  6699U,  6931U,  7171U,
+     7420U,  7677U,  7942U,  8217U,  8502U,  8796U,  9101U,  9416U,
+     9742U, 10079U, 10428U, 10789U, 11163U, 11549U, 11949U, 12363U,
+    12791U, 13234U, 13692U, 14166U, 14657U, 15164U, 15689U, 16233U,
+    16795U, 17376U, 17978U, 18600U, 19244U, 19911U, 20600U, 21313U,
+    22051U, 22815U, 23605U, 24422U, 25268U, 26142U, 27048U, 27984U,
+    28953U, 29956U, 30993U, 32066U, 33176U, 34325U, 35513U, 36743U,
+    38015U, 39331U, 40693U, 42102U, 43560U, 45068U, 46629U, 48243U,
+    49914U, 51642U, 53430U, 55280U, 57194U, 59174U, 61223U, 63343U
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static inline void CODEC_Put(CODEC_WRITER_t *wr, uint32_t value, uint32_t len);
+static inline uint32_t CODEC_Get(CODEC_READER_t *rd, uint32_t len, uint32_t *value);
+static uint32_t CODEC_RiceParameter(const uint32_t *u, uint32_t n);
+static inline uint32_t CODEC_Log8Code(uint16_t value);
+static uint32_t CODEC_Encode(uint8_t *dst, uint32_t dstSize, const uint16_t *src,
+                             const uint16_t *ref, uint32_t count);
+static CODEC_ERR_t CODEC_Decode(uint16_t *dst, uint32_t count, const uint8_t *src,
+                                uint32_t srcSize, const uint16_t *ref);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Code a vector of values with first differences and Rice codes
+ * @param   dst, uint8_t: Destination buffer
+ * @param   dstSize, uint32_t: Size of the destination buffer in bytes
+ * @param   src, uint16_t: Values to code
+ * @param   count, uint32_t: Number of values
+ * @retval  Bytes written, 0 if the code does not fit into dstSize bytes.
+ *          With dstSize = 2 x count the caller can fall back to the raw
+ *          values whenever coding does not pay off.
+ *
+ ******************************************************************************/
+uint32_t CODEC_RiceEncode(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count)
+{
+    return CODEC_Encode( dst, dstSize, src, NULL, count );
+}
+
+/*******************************************************************************
+ * @brief   Decode a vector coded by CODEC_RiceEncode()
+ * @param   dst, uint16_t: Destination for count values
+ * @param   count, uint32_t: Number of values, the pixel count of the frame
+ * @param   src, uint8_t: Coded data
+ * @param   srcSize, uint32_t: Bytes of coded data
+ * @retval  CODEC_OK, or CODEC_ERR_CORRUPT if the data ends early or decodes
+ *          to values outside 16 bit
+ *
+ ******************************************************************************/
+CODEC_ERR_t CODEC_RiceDecode(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize)
+{
+    return CODEC_Decode( dst, count, src, srcSize, NULL );
+}
+
+/*******************************************************************************
+ * @brief   Code a vector of values as Rice coded differences to a reference
+ * @param   dst, uint8_t: Destination buffer
+ * @param   dstSize, uint32_t: Size of the destination buffer in bytes
+ * @param   src, uint16_t: Values to code
+ * @param   ref, uint16_t: Reference values, as the decoder holds them
+ * @param   count, uint32_t: Number of values of src and ref
+ * @retval  Bytes written, 0 if the code does not fit into dstSize bytes
+ *
+ ******************************************************************************/
+uint32_t CODEC_RiceEncodeDelta(uint8_t *dst, uint32_t dstSize, const uint16_t *src,
+                               const uint16_t *ref, uint32_t count)
+{
+    if ( ref == NULL )
+    {
+        return 0U;
+    }
+
+    return CODEC_Encode( dst, dstSize, src, ref, count );
+}
+
+/*******************************************************************************
+ * @brief   Decode a vector coded by CODEC_RiceEncodeDelta()
+ * @param   dst, uint16_t: Destination for count values, may be ref itself
+ * @param   count, uint32_t: Number of values
+ * @param   src, uint8_t: Coded data
+ * @param   srcSize, uint32_t: Bytes of coded data
+ * @param   ref, uint16_t: The reference the data was coded with
+ * @retval  CODEC_OK, or CODEC_ERR_t code
+ *
+ ******************************************************************************/
+CODEC_ERR_t CODEC_RiceDecodeDelta(uint16_t *dst, uint32_t count, const uint8_t *src,
+                                  uint32_t srcSize, const uint16_t *ref)
+{
+    if ( ref == NULL )
+    {
+        return CODEC_ERR_NULL_POINTER;
+    }
+
+    return CODEC_Decode( dst, count, src, srcSize, ref );
+}
+
+/*******************************************************************************
+ * @brief   Pack values of up to 12 bit into 3 bytes per 2 values
+ * @param   dst, uint8_t: Destination buffer
+ * @param   dstSize, uint32_t: Size of the destination buffer in bytes
+ * @param   src, uint16_t: Values to pack
+ * @param   count, uint32_t: Number of values
+ * @retval  Bytes written, CODEC_PACK12_SIZE( count ), or 0 if they do not fit
+ *          into dstSize bytes or a value is above CODEC_PACK12_MAX, e.g. the
+ *          sum of binned pixels
+ *
+ ******************************************************************************/
+uint32_t CODEC_Pack12(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count)
+{
+    uint8_t *p = dst;
+    uint32_t i;
+
+    if ( (dst == NULL) || (src == NULL) || (count == 0U) || (CODEC_PACK12_SIZE( count ) > dstSize) )
+    {
+        return 0U;
+    }
+
+    for ( i = 0U; i + 1U < count; i += 2U )
+    {
+        uint32_t a = src[ i ];
+        uint32_t b = src[ i + 1U ];
+
+        if ( (a | b) > CODEC_PACK12_MAX )
+        {
+            return 0U;
+        }
+
+        p[ 0 ] = (uint8_t) a;
+        p[ 1 ] = (uint8_t) ((a >> 8) | (b << 4));
+        p[ 2 ] = (uint8_t) (b >> 4);
+        p += 3;
+    }
+
+    if ( i < count )
+    {
+        if ( src[ i ] > CODEC_PACK12_MAX )
+        {
+            return 0U;
+        }
+
+        p[ 0 ] = (uint8_t) src[ i ];
+        p[ 1 ] = (uint8_t) (src[ i ] >> 8);
+        p += 2;
+    }
+
+    return (uint32_t) (p - dst);
+}
+
+/*******************************************************************************
+ * @brief   Unpack values packed by CODEC_Pack12()
+ * @param   dst, uint16_t: Destination for count values
+ * @param   count, uint32_t: Number of values
+ * @param   src, uint8_t: Packed data
+ * @param   srcSize, uint32_t: Bytes of packed data
+ * @retval  CODEC_OK, or CODEC_ERR_CORRUPT if srcSize does not match count
+ *
+ ******************************************************************************/
+CODEC_ERR_t CODEC_Unpack12(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize)
+{
+    uint32_t i;
+
+    if ( (dst == NULL) || (src == NULL) )
+    {
+        return CODEC_ERR_NULL_POINTER;
+    }
+
+    if ( srcSize != CODEC_PACK12_SIZE( count ) )
+    {
+        return CODEC_ERR_CORRUPT;
+    }
+
+    for ( i = 0U; i + 1U < count; i += 2U )
+    {
+        dst[ i ] = (uint16_t) (src[ 0 ] | ((src[ 1 ] & 0x0FU) << 8));
+        dst[ i + 1U ] = (uint16_t) ((src[ 1 ] >> 4) | (src[ 2 ] << 4));
+        src += 3;
+    }
+
+    if ( i < count )
+    {
+        dst[ i ] = (uint16_t) (src[ 0 ] | ((src[ 1 ] & 0x0FU) << 8));
+    }
+
+    return CODEC_OK;
+}
+
+/*******************************************************************************
+ * @brief   Code values as 8 bit codes on a log scale
+ * @param   dst, uint8_t: Destination buffer
+ * @param   dstSize, uint32_t: Size of the destination buffer in bytes
+ * @param   src, uint16_t: Values to code
+ * @param   count, uint32_t: Number of values
+ * @retval  Bytes written, count, or 0 if they do not fit into dstSize bytes
+ *
+ ******************************************************************************/
+uint32_t CODEC_Log8Encode(uint8_t *dst, uint32_t dstSize, const uint16_t *src, uint32_t count)
+{
+    if ( (dst == NULL) || (src == NULL) || (count == 0U) || (count > dstSize) )
+    {
+        return 0U;
+    }
+
+    for ( uint32_t i = 0U; i < count; i++ )
+    {
+        dst[ i ] = (uint8_t) CODEC_Log8Code( src[ i ] );
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * @brief   Decode 8 bit log codes to the middle of their ranges
+ * @param   dst, uint16_t: Destination for count values
+ * @param   count, uint32_t: Number of values
+ * @param   src, uint8_t: Codes
+ * @param   srcSize, uint32_t: Bytes of codes
+ * @retval  CODEC_OK, or CODEC_ERR_CORRUPT if srcSize does not match count
+ *
+ ******************************************************************************/
+CODEC_ERR_t CODEC_Log8Decode(uint16_t *dst, uint32_t count, const uint8_t *src, uint32_t srcSize)
+{
+    if ( (dst == NULL) || (src == NULL) )
+    {
+        return CODEC_ERR_NULL_POINTER;
+    }
+
+    if ( srcSize != count )
+    {
+        return CODEC_ERR_CORRUPT;
+    }
+
+    for ( uint32_t i = 0U; i < count; i++ )
+    {
+        uint32_t c = src[ i ];
+        uint32_t end = (c < 255U) ? CODEC_log8Bound[ c + 1U ] : 0x10000U;
+
+        dst[ i ] = (uint16_t) ((CODEC_log8Bound[ c ] + end - 1U) / 2U);
+    }
+
+    return CODEC_OK;
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Code a vector of values, see CODEC_RiceEncode()
+ * @param   dst, uint8_t: Destination buffer
+ * @param   dstSize, uint32_t: Size of the destination buffer in bytes
+ * @param   src, uint16_t: Values to code
+ * @param   ref, uint16_t: Reference values, NULL to predict every value from
+ *          its left neighbour
+ * @param   count, uint32_t: Number of values
+ * @retval  Bytes written, 0 if the code does not fit into dstSize bytes
+ *
+ * Every block is coded in two passes over at most CODEC_RICE_BLOCK values:
+ * the first maps the differences and picks k, the second writes them.
+ ******************************************************************************/
+static uint32_t CODEC_Encode(uint8_t *dst, uint32_t dstSize, const uint16_t *src,
+                             const uint16_t *ref, uint32_t count)
+{
+    CODEC_WRITER_t wr;
+    uint32_t u[ CODEC_RICE_BLOCK ];
+    uint32_t first = 0U;
+    uint32_t prev = 0U;
+
+    if ( (dst == NULL) || (src == NULL) || (count == 0U) )
+    {
+        return 0U;
+    }
+
+    wr.pos = dst;
+    wr.end = dst + dstSize;
+    wr.bits = 0U;
+    wr.count = 0U;
+    wr.overflow = 0U;
+
+    /* Without a reference the first value has no prediction and is sent raw */
+    if ( ref == NULL )
+    {
+        prev = src[ 0 ];
+        CODEC_Put( &wr, prev, 16U );
+        first = 1U;
+    }
+
+    for ( uint32_t i = first; (i < count) && (wr.overflow == 0U); i += CODEC_RICE_BLOCK )
+    {
+        uint32_t n = count - i;
+        uint32_t k;
+
+        if ( n > CODEC_RICE_BLOCK )
+        {
+            n = CODEC_RICE_BLOCK;
+        }
+
+        /* Map the differences to 0, -1, 1, -2, 2 ... -> 0, 1, 2, 3, 4 ... */
+        for ( uint32_t j = 0U; j < n; j++ )
+        {
+            int32_t d;
+
+            if ( ref != NULL )
+            {
+                prev = ref[ i + j ];
+            }
+            d = (int32_t) src[ i + j ] - (int32_t) prev;
+
+            u[ j ] = ((uint32_t) d << 1) ^ (uint32_t) (d >> 31);
+            prev = src[ i + j ];
+        }
+
+        k = CODEC_RiceParameter( u, n );
+        CODEC_Put( &wr, k, CODEC_RICE_K_BITS );
+
+        for ( uint32_t j = 0U; j < n; j++ )
+        {
+            uint32_t q = u[ j ] >> k;
+
+            if ( q < CODEC_RICE_ESCAPE )
+            {
+                /* q ones and the terminating zero, then the low bits */
+                CODEC_Put( &wr, ((1UL << q) - 1U) << 1, q + 1U );
+                CODEC_Put( &wr, u[ j ] & ((1UL << k) - 1U), k );
+            }
+            else
+            {
+                CODEC_Put( &wr, 0xFFFFFFFFUL, CODEC_RICE_ESCAPE );
+                CODEC_Put( &wr, u[ j ], CODEC_RICE_RAW_BITS );
+            }
+        }
+    }
+
+    /* Pad the last byte */
+    if ( wr.count > 0U )
+    {
+        CODEC_Put( &wr, 0U, 8U - wr.count );
+    }
+
+    if ( wr.overflow != 0U )
+    {
+        return 0U;
+    }
+
+    return (uint32_t) (wr.pos - dst);
+}
+
+/*******************************************************************************
+ * @brief   Decode a vector, see CODEC_RiceDecode()
+ * @param   dst, uint16_t: Destination for count values
+ * @param   count, uint32_t: Number of values
+ * @param   src, uint8_t: Coded data
+ * @param   srcSize, uint32_t: Bytes of coded data
+ * @param   ref, uint16_t: Reference values, NULL for left neighbours
+ * @retval  CODEC_OK, or CODEC_ERR_CORRUPT if the data ends early or decodes
+ *          to values outside 16 bit
+ *
+ ******************************************************************************/
+static CODEC_ERR_t CODEC_Decode(uint16_t *dst, uint32_t count, const uint8_t *src,
+                                uint32_t srcSize, const uint16_t *ref)
+{
+    CODEC_READER_t rd;
+    uint32_t value;
+    uint32_t first = 0U;
+    int32_t prev = 0;
+
+    if ( (dst == NULL) || (src == NULL) )
+    {
+        return CODEC_ERR_NULL_POINTER;
+    }
+
+    if ( count == 0U )
+    {
+        return CODEC_OK;
+    }
+
+    rd.pos = src;
+    rd.end = src + srcSize;
+    rd.bits = 0U;
+    rd.count = 0U;
+
+    if ( ref == NULL )
+    {
+        if ( CODEC_Get( &rd, 16U, &value ) == 0U )
+        {
+            return CODEC_ERR_CORRUPT;
+        }
+        prev = (int32_t) value;
+        dst[ 0 ] = (uint16_t) value;
+        first = 1U;
+    }
+
+    for ( uint32_t i = first; i < count; i += CODEC_RICE_BLOCK )
+    {
+        uint32_t n = count - i;
+        uint32_t k;
+
+        if ( n > CODEC_RICE_BLOCK )
+        {
+            n = CODEC_RICE_BLOCK;
+        }
+
+        if ( (CODEC_Get( &rd, CODEC_RICE_K_BITS, &k ) == 0U) || (k > CODEC_RICE_MAX_K) )
+        {
+            return CODEC_ERR_CORRUPT;
+        }
+
+        for ( uint32_t j = 0U; j < n; j++ )
+        {
+            uint32_t q = 0U;
+            uint32_t bit;
+            uint32_t u;
+
+            /* Unary quotient */
+            do
+            {
+                if ( CODEC_Get( &rd, 1U, &bit ) == 0U )
+                {
+                    return CODEC_ERR_CORRUPT;
+                }
+                q += bit;
+            }
+            while ( (bit == 1U) && (q < CODEC_RICE_ESCAPE) );
+
+            if ( q < CODEC_RICE_ESCAPE )
+            {
+                if ( CODEC_Get( &rd, k, &value ) == 0U )
+                {
+                    return CODEC_ERR_CORRUPT;
+                }
+                u = (q << k) | value;
+            }
+            else if ( CODEC_Get( &rd, CODEC_RICE_RAW_BITS, &u ) == 0U )
+            {
+                return CODEC_ERR_CORRUPT;
+            }
+
+            /* Undo the mapping and the difference, dst may alias ref */
+            if ( ref != NULL )
+            {
+                prev = (int32_t) ref[ i + j ];
+            }
+            prev += (int32_t) (u >> 1) ^ -(int32_t) (u & 1U);
+            if ( (prev < 0) || (prev > 0xFFFF) )
+            {
+                return CODEC_ERR_CORRUPT;
+            }
+            dst[ i + j ] = (uint16_t) prev;
+        }
+    }
+
+    return CODEC_OK;
+}
+
+/*******************************************************************************
+ * @brief   Append a field to the bit stream
+ * @param   wr, CODEC_WRITER_t: The bit stream
+ * @param   value, uint32_t: Field value, only the low len bits are used
+ * @param   len, uint32_t: Field length in bits, 0 .. 32
+ * @retval  None
+ *
+ ******************************************************************************/
+static inline void CODEC_Put(CODEC_WRITER_t *wr, uint32_t value, uint32_t len)
+{
+    if ( len == 0U )
+    {
+        return;
+    }
+
+    wr->bits = (wr->bits << len) | (value & (0xFFFFFFFFUL >> (32U - len)));
+    wr->count += len;
+
+    while ( wr->count >= 8U )
+    {
+        wr->count -= 8U;
+
+        if ( wr->pos < wr->end )
+        {
+            *wr->pos++ = (uint8_t) (wr->bits >> wr->count);
+        }
+        else
+        {
+            wr->overflow = 1U;
+        }
+    }
+}
+
+/*******************************************************************************
+ * @brief   Take a field from the bit stream
+ * @param   rd, CODEC_READER_t: The bit stream
+ * @param   len, uint32_t: Field length in bits, 0 .. 32
+ * @param   value, uint32_t: Field value
+ * @retval  1U on success, 0U if the stream ends before the field
+ *
+ ******************************************************************************/
+static inline uint32_t CODEC_Get(CODEC_READER_t *rd, uint32_t len, uint32_t *value)
+{
+    if ( len == 0U )
+    {
+        *value = 0U;
+        return 1U;
+    }
+
+    while ( rd->count < len )
+    {
+        if ( rd->pos >= rd->end )
+        {
+            return 0U;
+        }
+        rd->bits = (rd->bits << 8) | *rd->pos++;
+        rd->count += 8U;
+    }
+
+    rd->count -= len;
+    *value = (uint32_t) (rd->bits >> rd->count) & (0xFFFFFFFFUL >> (32U - len));
+
+    return 1U;
+}
+
+/*******************************************************************************
+ * @brief   Pick the Rice parameter of a block
+ * @param   u, uint32_t: Mapped differences of the block
+ * @param   n, uint32_t: Number of values in the block
+ * @retval  The smallest k with n x 2^k >= the sum of the block, which is
+ *          within one bit per value of the best k (the LOCO-I rule)
+ *
+ ******************************************************************************/
+static uint32_t CODEC_RiceParameter(const uint32_t *u, uint32_t n)
+{
+    uint32_t sum = 0U;
+    uint32_t k = 0U;
+
+    for ( uint32_t j = 0U; j < n; j++ )
+    {
+        sum += u[ j ];
+    }
+
+    while ( ((n << k) < sum) && (k < CODEC_RICE_MAX_K) )
+    {
+        k++;
+    }
+
+    return k;
+}
+
+/*******************************************************************************
+ * @brief   Find the 8 bit log code of a value
+ * @param   value, uint16_t: Value
+ * @retval  Largest code with CODEC_log8Bound[ code ] <= value
+ *
+ * Binary search in the 256 bounds, 8 steps for every value.
+ ******************************************************************************/
+static inline uint32_t CODEC_Log8Code(uint16_t value)
+{
+    uint32_t code = 0U;
+
+    if ( value <= CODEC_LOG8_LINEAR )
+    {
+        return value;
+    }
+
+    for ( uint32_t step = 128U; step > 0U; step >>= 1 )
+    {
+        if ( CODEC_log8Bound[ code + step ] <= value )
+        {
+            code += step;
+        }
+    }
+
+    return code;
+}
+/****************************** END OF FILE ***********************************/
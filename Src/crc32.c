@@ -0,0 +1,390 @@
+/**
+ *******************************************************************************
+ * @file    : crc32.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : CRC-32 with the hardware CRC unit fed by DMA
+ *
+ * The data is fed to CRC->DR in 32-bit words by DMA2, the only DMA controller
+ * of the STM32F7 that can do memory-to-memory transfers. Word input reversal
+ * makes the unit process the little-endian words byte by byte, LSB first,
+ * which is the reflected CRC-32. A trailing 1 to 3 bytes are written by the
+ * CPU with byte input reversal.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "crc32.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define CRC32_DMA_STREAM                (DMA2_Stream1)
+#define CRC32_DMA_CHANNEL               (DMA_CHANNEL_0)
+#define CRC32_DMA_MAX_WORDS             (0xFFFFU)   /* NDTR is 16 bits */
+#define CRC32_CACHE_LINE_SIZE           (32U)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+    uint8_t busy;                   /* DMA transfer to the CRC unit ongoing  */
+    uint8_t pending;                /* Started, result not collected yet     */
+    uint8_t hardware;               /* Result is in the CRC unit             */
+    const uint8_t *data;            /* Data block, for the software fallback */
+    uint32_t size;
+    const uint8_t *tail;            /* Bytes after the last whole word       */
+    uint32_t tailSize;
+    uint32_t result;                /* Result of a software calculation      */
+} CRC32_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static CRC32_PCB_t CRC32_pcb;
+static uint32_t CRC32_table[ 256 ];
+static uint8_t CRC32_tableReady;
+
+#if ( CRC32_HARDWARE == 1U )
+static CRC_HandleTypeDef hcrc;
+static DMA_HandleTypeDef hdma_crc;
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void CRC32_InitTable(void);
+#if ( CRC32_HARDWARE == 1U )
+static void CRC32_CleanDCache(const void *addr, uint32_t size);
+#endif
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Configure the CRC unit and the memory-to-memory DMA
+ * @param   None
+ * @retval  CRC32_OK on success or CRC32_ERR_t code
+ *
+ ******************************************************************************/
+CRC32_ERR_t CRC32_Init(void)
+{
+    memset( &CRC32_pcb, 0, sizeof(CRC32_pcb) );
+    CRC32_InitTable();
+
+#if ( CRC32_HARDWARE == 1U )
+    hcrc.Instance = CRC;
+    hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_DISABLE;
+    hcrc.Init.GeneratingPolynomial = CRC32_POLYNOMIAL;
+    hcrc.Init.CRCLength = CRC_POLYLENGTH_32B;
+    hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
+    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_WORD;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_WORDS;
+    if ( HAL_CRC_Init( &hcrc ) != HAL_OK )
+    {
+        return CRC32_ERR_INIT;
+    }
+
+    /**
+     * In memory-to-memory mode the peripheral port is the source and the
+     * memory port the destination, CRC->DR.
+     */
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    hdma_crc.Instance = CRC32_DMA_STREAM;
+    hdma_crc.Init.Channel = CRC32_DMA_CHANNEL;
+    hdma_crc.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    hdma_crc.Init.PeriphInc = DMA_PINC_ENABLE;
+    hdma_crc.Init.MemInc = DMA_MINC_DISABLE;
+    hdma_crc.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_crc.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_crc.Init.Mode = DMA_NORMAL;
+    hdma_crc.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_crc.Init.FIFOMode = DMA_FIFOMODE_ENABLE;   /* Required for memory-to-memory */
+    hdma_crc.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+    hdma_crc.Init.MemBurst = DMA_MBURST_SINGLE;
+    hdma_crc.Init.PeriphBurst = DMA_PBURST_SINGLE;
+    if ( HAL_DMA_Init( &hdma_crc ) != HAL_OK )
+    {
+        return CRC32_ERR_INIT;
+    }
+#endif
+
+    return CRC32_OK;
+}
+
+/*******************************************************************************
+ * @brief   Start the CRC-32 calculation of a data block
+ * @param   data, uint8_t: Data block. Must not change until the CRC is done.
+ * @param   size, uint32_t: Bytes in the data block
+ * @retval  CRC32_OK on success or CRC32_ERR_t code
+ *
+ * The result is available from CRC32_GetResult() when CRC32_IsBusy() returns
+ * 0. Unaligned data is calculated in software before returning. A new
+ * calculation can not start before the result of the last one is collected.
+ ******************************************************************************/
+CRC32_ERR_t CRC32_Start(const uint8_t *data, uint32_t size)
+{
+    if ( (data == NULL) && (size > 0U) )
+    {
+        return CRC32_ERR_NULL_POINTER;
+    }
+
+    if ( CRC32_pcb.pending == 1U )
+    {
+        return CRC32_ERR_BUSY;
+    }
+    CRC32_pcb.pending = 1U;
+    CRC32_pcb.data = data;
+    CRC32_pcb.size = size;
+
+#if ( CRC32_HARDWARE == 1U )
+    uint32_t words = size / 4U;
+
+    if ( (((uintptr_t) data & 3U) == 0U) && (words <= CRC32_DMA_MAX_WORDS) )
+    {
+        CRC32_pcb.hardware = 1U;
+        CRC32_pcb.tail = data + (4U * words);
+        CRC32_pcb.tailSize = size - (4U * words);
+
+        __HAL_CRC_DR_RESET( &hcrc );
+
+        if ( words > 0U )
+        {
+            /* The DMA reads RAM, not the D-cache */
+            CRC32_CleanDCache( data, 4U * words );
+
+            CRC32_pcb.busy = 1U;
+            if ( HAL_DMA_Start( &hdma_crc, (uint32_t) data, (uint32_t) &hcrc.Instance->DR, words ) != HAL_OK )
+            {
+                CRC32_pcb.busy = 0U;
+                CRC32_pcb.hardware = 0U;
+            }
+        }
+
+        if ( CRC32_pcb.hardware == 1U )
+        {
+            return CRC32_OK;
+        }
+    }
+#endif
+
+    CRC32_pcb.hardware = 0U;
+    CRC32_pcb.result = CRC32_Software( 0U, data, size );
+
+    return CRC32_OK;
+}
+
+/*******************************************************************************
+ * @brief   Check if the CRC calculation is ongoing
+ * @param   None
+ * @retval  1U while the DMA is feeding the CRC unit, 0U when done
+ *
+ * After a DMA transfer error the block is calculated in software instead.
+ ******************************************************************************/
+uint8_t CRC32_IsBusy(void)
+{
+#if ( CRC32_HARDWARE == 1U )
+    if ( CRC32_pcb.busy == 1U )
+    {
+        uint32_t flags = __HAL_DMA_GET_TC_FLAG_INDEX( &hdma_crc ) |
+                         __HAL_DMA_GET_TE_FLAG_INDEX( &hdma_crc );
+
+        if ( __HAL_DMA_GET_FLAG( &hdma_crc, flags ) == 0U )
+        {
+            return 1U;
+        }
+
+        /* Finished, clears the flags and releases the DMA handle */
+        if ( HAL_DMA_PollForTransfer( &hdma_crc, HAL_DMA_FULL_TRANSFER, 0U ) != HAL_OK )
+        {
+            /* Transfer error, the CRC unit did not see all data */
+            CRC32_pcb.hardware = 0U;
+            CRC32_pcb.result = CRC32_Software( 0U, CRC32_pcb.data, CRC32_pcb.size );
+        }
+        CRC32_pcb.busy = 0U;
+    }
+#endif
+
+    return 0U;
+}
+
+/*******************************************************************************
+ * @brief   Get the result of the last CRC32_Start()
+ * @param   None
+ * @retval  CRC-32 of the data block
+ *
+ * Must only be called when CRC32_IsBusy() returns 0.
+ ******************************************************************************/
+uint32_t CRC32_GetResult(void)
+{
+#if ( CRC32_HARDWARE == 1U )
+    if ( CRC32_pcb.hardware == 1U )
+    {
+        if ( CRC32_pcb.tailSize > 0U )
+        {
+            /* Bytes are reflected one by one */
+            MODIFY_REG( hcrc.Instance->CR, CRC_CR_REV_IN, CRC_INPUTDATA_INVERSION_BYTE );
+            while ( CRC32_pcb.tailSize > 0U )
+            {
+                *(__IO uint8_t *) &hcrc.Instance->DR = *CRC32_pcb.tail++;
+                CRC32_pcb.tailSize--;
+            }
+            MODIFY_REG( hcrc.Instance->CR, CRC_CR_REV_IN, CRC_INPUTDATA_INVERSION_WORD );
+        }
+
+        CRC32_pcb.hardware = 0U;
+        CRC32_pcb.result = ~hcrc.Instance->DR;
+    }
+#endif
+
+    CRC32_pcb.pending = 0U;
+    return CRC32_pcb.result;
+}
+
+/*******************************************************************************
+ * @brief   Calculate the CRC-32 of a data block and wait for the result
+ * @param   data, uint8_t: Data block
+ * @param   size, uint32_t: Bytes in the data block
+ * @retval  CRC-32 of the data block
+ *
+ * Falls back to software while another calculation is pending.
+ ******************************************************************************/
+uint32_t CRC32_Calculate(const uint8_t *data, uint32_t size)
+{
+    if ( CRC32_Start( data, size ) != CRC32_OK )
+    {
+        return CRC32_Software( 0U, data, size );
+    }
+
+    while ( CRC32_IsBusy() == 1U )
+    {
+    }
+
+    return CRC32_GetResult();
+}
+
+/*******************************************************************************
+ * @brief   Calculate the CRC-32 in software with a lookup table
+ * @param   crc, uint32_t: 0 to start, or the result of the previous block
+ * @param   data, uint8_t: Data block
+ * @param   size, uint32_t: Bytes in the data block
+ * @retval  CRC-32 of all data so far
+ *
+ ******************************************************************************/
+uint32_t CRC32_Software(uint32_t crc, const uint8_t *data, uint32_t size)
+{
+    if ( CRC32_tableReady == 0U )
+    {
+        CRC32_InitTable();
+    }
+
+    crc = ~crc;
+    while ( size-- > 0U )
+    {
+        crc = CRC32_table[ (crc ^ *data++) & 0xFFU ] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Build the byte-wise lookup table of the reflected polynomial
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+static void CRC32_InitTable(void)
+{
+    uint32_t poly = 0U;
+    uint32_t i;
+    uint32_t bit;
+
+    /* Reflect the polynomial */
+    for ( bit = 0U; bit < 32U; bit++ )
+    {
+        if ( (CRC32_POLYNOMIAL & (1UL << bit)) != 0U )
+        {
+            poly |= 1UL << (31U - bit);
+        }
+    }
+
+    for ( i = 0U; i < 256U; i++ )
+    {
+        uint32_t crc = i;
+
+        for ( bit = 0U; bit < 8U; bit++ )
+        {
+            crc = ((crc & 1U) != 0U) ? ((crc >> 1) ^ poly) : (crc >> 1);
+        }
+        CRC32_table[ i ] = crc;
+    }
+
+    CRC32_tableReady = 1U;
+}
+
+#if ( CRC32_HARDWARE == 1U )
+/*******************************************************************************
+ * @brief   Write back a buffer from the D-cache to RAM before the DMA reads it
+ * @param   addr: Start of the buffer
+ * @param   size: Size of the buffer in bytes
+ * @retval  None
+ *
+ * Nothing to do for buffers in the non-cacheable DMA RAM or the DTCM, but
+ * the cache maintenance is harmless there.
+ ******************************************************************************/
+static void CRC32_CleanDCache(const void *addr, uint32_t size)
+{
+    uintptr_t start;
+    uintptr_t end;
+
+    if ( (SCB->CCR & SCB_CCR_DC_Msk) == 0U )
+    {
+        return;
+    }
+
+    start = (uintptr_t) addr & ~(uintptr_t) (CRC32_CACHE_LINE_SIZE - 1U);
+    end = ((uintptr_t) addr + size + CRC32_CACHE_LINE_SIZE - 1U) & ~(uintptr_t) (CRC32_CACHE_LINE_SIZE - 1U);
+
+    SCB_CleanDCache_by_Addr( (uint32_t *) start, (int32_t) (end - start) );
+}
+#endif
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,326 @@
+/**
+ *******************************************************************************
+ * @file    : event.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Events that wake the main loop
+ *
+ * The pending events are changed with the interrupts disabled. The check for
+ * pending events and the WFI are done inside the same section: an interrupt
+ * that arrives in between is held pending and makes WFI return at once.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "event.h"
+#include "stm32f7xx_hal.h"
+#include "tcd1304_port.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+    EVENT_LOOP_t loop;
+    volatile uint32_t pending;
+    uint32_t tickStart;
+
+    /* Command latency */
+    volatile uint32_t idleStamp;    /* Written by the idle-line interrupt    */
+    volatile uint32_t idleCount;
+    uint32_t idleSeen;              /* Idle lines matched or passed over     */
+    uint32_t idleAtWake;            /* Idle lines seen by the last pass      */
+    uint32_t lastEvents;
+    uint32_t doneStamp;
+    uint8_t donePending;            /* Command done before its idle line     */
+    EVENT_STATS_t stats;
+
+    /* Sleep share */
+    uint32_t lastStamp;
+    uint64_t totalCycles;
+    uint64_t sleepCycles;
+} EVENT_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static EVENT_PCB_t EVENT_pcb;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t EVENT_TickDue(void);
+static void EVENT_AddLatency(int32_t latency);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the events, the main loop sleeps between them
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void EVENT_Init(void)
+{
+    memset( &EVENT_pcb, 0, sizeof(EVENT_pcb) );
+    EVENT_pcb.loop = EVENT_LOOP_SLEEP;
+    EVENT_pcb.tickStart = HAL_GetTick();
+    EVENT_pcb.lastStamp = TCD_PORT_CycleCounter_Get();
+
+    /* Run everything once at the start */
+    EVENT_pcb.pending = EVENT_ALL;
+}
+
+/*******************************************************************************
+ * @brief   Raise events
+ * @param   events, uint32_t: EVENT_ bits
+ * @retval  None
+ *
+ * Called from the interrupt handlers. Must not be called with the
+ * interrupts disabled.
+ ******************************************************************************/
+void EVENT_Set(uint32_t events)
+{
+    __disable_irq();
+    EVENT_pcb.pending |= events;
+    __enable_irq();
+}
+
+/*******************************************************************************
+ * @brief   Wait for events
+ * @param   None
+ * @retval  The events raised since the last call
+ *
+ ******************************************************************************/
+uint32_t EVENT_Wait(void)
+{
+    uint32_t events = 0U;
+    uint32_t idleCount = 0U;
+    uint32_t idleStamp = 0U;
+    uint32_t now;
+
+    /* An idle line the CLI has seen without a command in it is not matched */
+    if ( ((EVENT_pcb.lastEvents & EVENT_RX) != 0U) && (EVENT_pcb.donePending == 0U) &&
+         ((int32_t) (EVENT_pcb.idleAtWake - EVENT_pcb.idleSeen) > 0) )
+    {
+        EVENT_pcb.idleSeen = EVENT_pcb.idleAtWake;
+    }
+
+    while ( events == 0U )
+    {
+        __disable_irq();
+        events = EVENT_pcb.pending | EVENT_TickDue();
+        if ( EVENT_pcb.loop == EVENT_LOOP_POLL )
+        {
+            events = EVENT_ALL;
+        }
+        else if ( events == 0U )
+        {
+            uint32_t start = TCD_PORT_CycleCounter_Get();
+
+            /* Returns on any interrupt, even one raised before it */
+            __WFI();
+            EVENT_pcb.sleepCycles += TCD_PORT_CycleCounter_Get() - start;
+        }
+        else
+        {
+            EVENT_pcb.pending = 0U;
+        }
+        idleCount = EVENT_pcb.idleCount;
+        idleStamp = EVENT_pcb.idleStamp;
+        __enable_irq();
+
+        /* 64 bits, the cycle counter wraps around within seconds */
+        now = TCD_PORT_CycleCounter_Get();
+        EVENT_pcb.totalCycles += now - EVENT_pcb.lastStamp;
+        EVENT_pcb.lastStamp = now;
+    }
+
+    /* The idle line of a command that has already been done */
+    if ( (EVENT_pcb.donePending == 1U) && (idleCount != EVENT_pcb.idleSeen) )
+    {
+        EVENT_pcb.idleSeen = idleCount;
+        EVENT_pcb.donePending = 0U;
+        EVENT_AddLatency( (int32_t) (EVENT_pcb.doneStamp - idleStamp) );
+    }
+
+    EVENT_pcb.idleAtWake = idleCount;
+    EVENT_pcb.lastEvents = events;
+
+    return events;
+}
+
+/*******************************************************************************
+ * @brief   Select the main loop
+ * @param   loop, EVENT_LOOP_t: Sleep between events or poll
+ * @retval  None
+ *
+ * The latency and sleep statistics are reset.
+ ******************************************************************************/
+void EVENT_SetLoop(EVENT_LOOP_t loop)
+{
+    EVENT_pcb.loop = (loop == EVENT_LOOP_POLL) ? EVENT_LOOP_POLL : EVENT_LOOP_SLEEP;
+
+    memset( &EVENT_pcb.stats, 0, sizeof(EVENT_pcb.stats) );
+    EVENT_pcb.donePending = 0U;
+    EVENT_pcb.totalCycles = 0U;
+    EVENT_pcb.sleepCycles = 0U;
+}
+
+/*******************************************************************************
+ * @brief   Get the main loop
+ * @param   None
+ * @retval  EVENT_LOOP_t
+ *
+ ******************************************************************************/
+EVENT_LOOP_t EVENT_GetLoop(void)
+{
+    return EVENT_pcb.loop;
+}
+
+/*******************************************************************************
+ * @brief   Record the idle line after a command
+ * @param   None
+ * @retval  None
+ *
+ * Called from the USART interrupt.
+ ******************************************************************************/
+void EVENT_RxIdle(void)
+{
+    EVENT_pcb.idleStamp = TCD_PORT_CycleCounter_Get();
+    EVENT_pcb.idleCount++;
+}
+
+/*******************************************************************************
+ * @brief   Record the end of the processing of a command
+ * @param   None
+ * @retval  None
+ *
+ * Called by the CLI for the first command it finds in a pass of the main
+ * loop.
+ ******************************************************************************/
+void EVENT_CommandDone(void)
+{
+    uint32_t now = TCD_PORT_CycleCounter_Get();
+    uint32_t idleCount;
+    uint32_t idleStamp;
+
+    __disable_irq();
+    idleCount = EVENT_pcb.idleCount;
+    idleStamp = EVENT_pcb.idleStamp;
+    __enable_irq();
+
+    if ( idleCount != EVENT_pcb.idleSeen )
+    {
+        /* The idle line came first, the normal case in the sleeping loop */
+        EVENT_pcb.idleSeen = idleCount;
+        EVENT_pcb.donePending = 0U;
+        EVENT_AddLatency( (int32_t) (now - idleStamp) );
+    }
+    else if ( EVENT_pcb.donePending == 0U )
+    {
+        /* Measured when the idle line comes */
+        EVENT_pcb.doneStamp = now;
+        EVENT_pcb.donePending = 1U;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Get the latency and sleep statistics and start a new sleep window
+ * @param   stats, EVENT_STATS_t: Struct to fill with the statistics
+ * @retval  None
+ *
+ ******************************************************************************/
+void EVENT_GetStats(EVENT_STATS_t *stats)
+{
+    if ( stats == NULL )
+    {
+        return;
+    }
+
+    *stats = EVENT_pcb.stats;
+    stats->sleepPermille = (EVENT_pcb.totalCycles > 0U) ?
+        (uint32_t) ((EVENT_pcb.sleepCycles * 1000U) / EVENT_pcb.totalCycles) : 0U;
+
+    EVENT_pcb.totalCycles = 0U;
+    EVENT_pcb.sleepCycles = 0U;
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Check whether the tick event is due
+ * @param   None
+ * @retval  EVENT_TICK or 0
+ *
+ * SysTick wakes the core every millisecond, the tick event is only raised
+ * every EVENT_TICK_MS.
+ ******************************************************************************/
+static uint32_t EVENT_TickDue(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    if ( (now - EVENT_pcb.tickStart) < EVENT_TICK_MS )
+    {
+        return 0U;
+    }
+
+    EVENT_pcb.tickStart = now;
+    return EVENT_TICK;
+}
+
+/*******************************************************************************
+ * @brief   Add a command latency to the statistics
+ * @param   latency, int32_t: Cycles from the idle line to the end of the command
+ * @retval  None
+ *
+ ******************************************************************************/
+static void EVENT_AddLatency(int32_t latency)
+{
+    EVENT_pcb.stats.latency = latency;
+    if ( (EVENT_pcb.stats.commands == 0U) || (latency > EVENT_pcb.stats.maxLatency) )
+    {
+        EVENT_pcb.stats.maxLatency = latency;
+    }
+    EVENT_pcb.stats.commands++;
+}
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,108 @@
+/**
+ *******************************************************************************
+ * @file    : frame.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Framed binary output of the spectrum data
+ *
+ * Builds the frames described in frame.h around a payload that the caller
+ * has already written into the frame buffer, so the spectrum is copied only
+ * once.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "frame.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* Private typedefs ----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Write the header in front of the payload in the frame buffer
+ * @param   frame, uint8_t: 32-bit aligned buffer of FRAME_MAX_SIZE bytes with
+ *          the payload at FRAME_PAYLOAD(frame)
+ * @param   header, FRAME_HEADER_t: Header with the acquisition fields, the
+ *          sequence, the encoding and payloadSize filled in. The framing
+ *          fields are filled in here.
+ * @retval  Bytes of header and payload to calculate the CRC of, 0 if the
+ *          payload is too large
+ *
+ ******************************************************************************/
+uint32_t FRAME_Prepare(uint8_t *frame, FRAME_HEADER_t *header)
+{
+    if ( (frame == NULL) || (header == NULL) || (header->payloadSize > FRAME_MAX_PAYLOAD_SIZE) )
+    {
+        return 0U;
+    }
+
+    header->sync = FRAME_SYNC;
+    header->version = FRAME_VERSION;
+    header->headerSize = FRAME_HEADER_SIZE;
+    memcpy( frame, header, FRAME_HEADER_SIZE );
+
+    return FRAME_HEADER_SIZE + header->payloadSize;
+}
+
+/*******************************************************************************
+ * @brief   Append the CRC to the frame
+ * @param   frame, uint8_t: Frame buffer from FRAME_Prepare()
+ * @param   size, uint32_t: Return value of FRAME_Prepare()
+ * @param   crc, uint32_t: CRC-32 of the first size bytes of the frame
+ * @retval  Total size of the frame in bytes
+ *
+ ******************************************************************************/
+uint32_t FRAME_Finish(uint8_t *frame, uint32_t size, uint32_t crc)
+{
+    /* Little-endian, independent of the alignment of size */
+    frame[ size++ ] = (uint8_t) crc;
+    frame[ size++ ] = (uint8_t) (crc >> 8);
+    frame[ size++ ] = (uint8_t) (crc >> 16);
+    frame[ size++ ] = (uint8_t) (crc >> 24);
+
+    return size;
+}
+/****************************** END OF FILE ***********************************/
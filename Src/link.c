@@ -0,0 +1,442 @@
+/**
+ *******************************************************************************
+ * @file    : link.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Serial link to the host: baud rate negotiation and throughput
+ *
+ * The baud rate is switched from the main loop, once the transmit queue is
+ * empty, by writing BRR and OVER8 directly. HAL_UART_Init() would also reset the
+ * handle states, and its parameter check stops at 9 Mbit/s. The receive DMA
+ * keeps running through the switch.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "link.h"
+#include "tx.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* USART1 kernel clock, see SystemClock_Config() */
+#define LINK_UART_CLOCK_HZ()            HAL_RCC_GetSysClockFreq()
+
+#define LINK_BRR_MIN                    (16U)
+#define LINK_BRR_MAX                    (0xFFFFU)
+#define LINK_TC_TIMEOUT_MS              (10U)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef enum
+{
+    LINK_STATE_IDLE = 0,
+    LINK_STATE_SWITCH_REQUESTED,    /* Acknowledge not sent yet               */
+    LINK_STATE_SWITCH_ACKED,        /* Waiting for the transmitter to be free */
+    LINK_STATE_CONFIRM_WAIT         /* Switched, waiting for the host         */
+} LINK_STATE_t;
+
+typedef struct
+{
+    uint16_t brr;
+    uint8_t over8;
+} LINK_BAUD_CONFIG_t;
+
+typedef struct
+{
+    LINK_STATE_t state;
+    uint32_t baud;
+    uint32_t newBaud;
+    uint32_t previousBaud;
+    uint32_t switchTick;
+
+    /* Throughput of the frame transfers */
+    uint8_t txBusy;
+    uint32_t txSize;
+    uint32_t txStartTick;
+    uint32_t lastBytesPerSecond;
+    uint32_t windowBytes;
+    uint32_t windowFrames;
+    uint32_t windowStartTick;
+} LINK_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static UART_HandleTypeDef *LINK_uart;
+static LINK_PCB_t LINK_pcb;
+
+/* Private function prototypes -----------------------------------------------*/
+static LINK_ERR_t LINK_CalcBaudConfig(uint32_t baud, LINK_BAUD_CONFIG_t *config);
+static void LINK_SetBaud(uint32_t baud);
+static void LINK_Reply(const char *cmd, uint32_t baud);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the link with the UART configured by MX_USART1_UART_Init()
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  LINK_OK on success or LINK_ERR_t code
+ *
+ ******************************************************************************/
+LINK_ERR_t LINK_Init(UART_HandleTypeDef *huart)
+{
+    if ( huart == NULL )
+    {
+        return LINK_ERR_NULL_POINTER;
+    }
+
+    LINK_uart = huart;
+    memset( &LINK_pcb, 0, sizeof(LINK_pcb) );
+    LINK_pcb.baud = huart->Init.BaudRate;
+    LINK_pcb.windowStartTick = HAL_GetTick();
+
+    return LINK_OK;
+}
+
+/*******************************************************************************
+ * @brief   Run the baud rate switch and the throughput measurement
+ * @param   None
+ * @retval  None
+ *
+ * Called from the main loop.
+ ******************************************************************************/
+void LINK_Process(void)
+{
+    if ( LINK_uart == NULL )
+    {
+        return;
+    }
+
+    switch ( LINK_pcb.state )
+    {
+        case LINK_STATE_SWITCH_REQUESTED:
+            /* Acknowledge at the old rate, after the replies already queued */
+            LINK_Reply( "BAUD", LINK_pcb.newBaud );
+            LINK_pcb.state = LINK_STATE_SWITCH_ACKED;
+            break;
+
+        case LINK_STATE_SWITCH_ACKED:
+            if ( TX_IsIdle() == 1U )
+            {
+                LINK_pcb.previousBaud = LINK_pcb.baud;
+                LINK_SetBaud( LINK_pcb.newBaud );
+                LINK_pcb.switchTick = HAL_GetTick();
+                LINK_pcb.state = LINK_STATE_CONFIRM_WAIT;
+            }
+            break;
+
+        case LINK_STATE_CONFIRM_WAIT:
+            /* The host did not follow, go back to where it still is */
+            if ( ((HAL_GetTick() - LINK_pcb.switchTick) >= LINK_CONFIRM_TIMEOUT_MS) &&
+                 (TX_IsIdle() == 1U) )
+            {
+                LINK_SetBaud( LINK_pcb.previousBaud );
+                LINK_pcb.state = LINK_STATE_IDLE;
+
+                LINK_Reply( "BAUD", LINK_pcb.baud );
+            }
+            break;
+
+        case LINK_STATE_IDLE:
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+ * @brief   Request a new baud rate
+ * @param   baud, uint32_t: The new baud rate
+ * @retval  LINK_OK when the switch has been scheduled or LINK_ERR_t code
+ *
+ * The acknowledge and the switch follow in LINK_Process(). Rates that can
+ * not be generated from the USART clock within LINK_MAX_BAUD_ERROR_PERMILLE
+ * are rejected.
+ ******************************************************************************/
+LINK_ERR_t LINK_RequestBaud(uint32_t baud)
+{
+    LINK_BAUD_CONFIG_t config;
+
+    if ( LINK_uart == NULL )
+    {
+        return LINK_ERR_NOT_INITIALIZED;
+    }
+
+    if ( LINK_pcb.state != LINK_STATE_IDLE )
+    {
+        return LINK_ERR_BUSY;
+    }
+
+    if ( LINK_CalcBaudConfig( baud, &config ) != LINK_OK )
+    {
+        return LINK_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    LINK_pcb.newBaud = baud;
+    LINK_pcb.state = LINK_STATE_SWITCH_REQUESTED;
+
+    return LINK_OK;
+}
+
+/*******************************************************************************
+ * @brief   The host confirms that it receives at the new baud rate
+ * @param   None
+ * @retval  LINK_OK on success, LINK_ERROR if no switch was waiting
+ *
+ ******************************************************************************/
+LINK_ERR_t LINK_ConfirmBaud(void)
+{
+    if ( LINK_pcb.state != LINK_STATE_CONFIRM_WAIT )
+    {
+        return LINK_ERROR;
+    }
+
+    LINK_pcb.state = LINK_STATE_IDLE;
+
+    /* Restart the throughput window at the new rate */
+    LINK_pcb.windowBytes = 0U;
+    LINK_pcb.windowFrames = 0U;
+    LINK_pcb.windowStartTick = HAL_GetTick();
+
+    return LINK_OK;
+}
+
+/*******************************************************************************
+ * @brief   Get the current baud rate
+ * @param   None
+ * @retval  Baud rate
+ *
+ ******************************************************************************/
+uint32_t LINK_GetBaud(void)
+{
+    return LINK_pcb.baud;
+}
+
+/*******************************************************************************
+ * @brief   Check whether data frames may be sent
+ * @param   None
+ * @retval  1 if no baud rate switch is pending, 0 otherwise
+ *
+ * The switch waits for the transmit queue to be empty, so new frames are
+ * held back until the host has confirmed or the switch has been reverted.
+ ******************************************************************************/
+uint8_t LINK_IsTxAllowed(void)
+{
+    return (LINK_pcb.state == LINK_STATE_IDLE) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @brief   Register the start of a frame transfer for the throughput
+ * @param   size, uint32_t: Bytes in the transfer
+ * @retval  None
+ *
+ ******************************************************************************/
+void LINK_TxStarted(uint32_t size)
+{
+    LINK_pcb.txSize = size;
+    LINK_pcb.txStartTick = HAL_GetTick();
+    LINK_pcb.txBusy = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Register the end of the frame transfer started last
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void LINK_TxCompleted(void)
+{
+    uint32_t duration = HAL_GetTick() - LINK_pcb.txStartTick;
+
+    if ( LINK_pcb.txBusy == 0U )
+    {
+        return;
+    }
+
+    LINK_pcb.txBusy = 0U;
+    LINK_pcb.lastBytesPerSecond = (uint32_t) (((uint64_t) LINK_pcb.txSize * 1000U) /
+                                              ((duration > 0U) ? duration : 1U));
+    LINK_pcb.windowBytes += LINK_pcb.txSize;
+    LINK_pcb.windowFrames++;
+}
+
+/*******************************************************************************
+ * @brief   Get the throughput and start a new averaging window
+ * @param   tput, LINK_THROUGHPUT_t: Struct to fill with the throughput
+ * @retval  None
+ *
+ ******************************************************************************/
+void LINK_GetThroughput(LINK_THROUGHPUT_t *tput)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - LINK_pcb.windowStartTick;
+
+    if ( tput == NULL )
+    {
+        return;
+    }
+
+    tput->baud = LINK_pcb.baud;
+    tput->bytesPerSecond = (uint32_t) (((uint64_t) LINK_pcb.windowBytes * 1000U) /
+                                       ((elapsed > 0U) ? elapsed : 1U));
+    tput->lastBytesPerSecond = LINK_pcb.lastBytesPerSecond;
+    tput->frames = LINK_pcb.windowFrames;
+
+    LINK_pcb.windowBytes = 0U;
+    LINK_pcb.windowFrames = 0U;
+    LINK_pcb.windowStartTick = now;
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Calculate the BRR register value for a baud rate
+ * @param   baud, uint32_t: Requested baud rate
+ * @param   config, LINK_BAUD_CONFIG_t: BRR and oversampling to use
+ * @retval  LINK_OK on success or LINK_ERR_PARAM_OUT_OF_RANGE
+ *
+ * 16x oversampling is used as long as USARTDIV >= 16 for its better noise
+ * immunity, 8x oversampling above fck / 16.
+ ******************************************************************************/
+static LINK_ERR_t LINK_CalcBaudConfig(uint32_t baud, LINK_BAUD_CONFIG_t *config)
+{
+    uint32_t fck = LINK_UART_CLOCK_HZ();
+    uint32_t div;
+    uint32_t actual;
+    uint32_t error;
+
+    if ( baud < LINK_MIN_BAUD )
+    {
+        return LINK_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    div = (fck + (baud / 2U)) / baud;
+    if ( div >= LINK_BRR_MIN )
+    {
+        if ( div > LINK_BRR_MAX )
+        {
+            return LINK_ERR_PARAM_OUT_OF_RANGE;
+        }
+        config->over8 = 0U;
+        config->brr = (uint16_t) div;
+        actual = fck / div;
+    }
+    else
+    {
+        div = ((2U * fck) + (baud / 2U)) / baud;
+        if ( div < LINK_BRR_MIN )
+        {
+            return LINK_ERR_PARAM_OUT_OF_RANGE;
+        }
+        /* BRR[3] must be 0 with 8x oversampling, BRR[2:0] = USARTDIV[3:1] */
+        config->over8 = 1U;
+        config->brr = (uint16_t) ((div & 0xFFF0U) | ((div & 0x000FU) >> 1U));
+        actual = (2U * fck) / div;
+    }
+
+    error = (actual > baud) ? (actual - baud) : (baud - actual);
+    if ( ((uint64_t) error * 1000U) > ((uint64_t) baud * LINK_MAX_BAUD_ERROR_PERMILLE) )
+    {
+        return LINK_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    return LINK_OK;
+}
+
+/*******************************************************************************
+ * @brief   Switch the UART to a new baud rate
+ * @param   baud, uint32_t: Baud rate, already checked by LINK_CalcBaudConfig()
+ * @retval  None
+ *
+ * Called with an empty transmit queue, the transmission complete flag is
+ * already set then; the wait is only a guard. Errors caused by bytes that
+ * arrived during the switch are cleared.
+ ******************************************************************************/
+static void LINK_SetBaud(uint32_t baud)
+{
+    LINK_BAUD_CONFIG_t config;
+    USART_TypeDef *uart = LINK_uart->Instance;
+    uint32_t start = HAL_GetTick();
+
+    if ( LINK_CalcBaudConfig( baud, &config ) != LINK_OK )
+    {
+        return;
+    }
+
+    while ( ((uart->ISR & USART_ISR_TC) == 0U) && ((HAL_GetTick() - start) < LINK_TC_TIMEOUT_MS) )
+    {
+    }
+
+    uart->CR1 &= ~USART_CR1_UE;
+    uart->BRR = config.brr;
+    if ( config.over8 == 1U )
+    {
+        uart->CR1 |= USART_CR1_OVER8;
+    }
+    else
+    {
+        uart->CR1 &= ~USART_CR1_OVER8;
+    }
+    uart->ICR = USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_ORECF;
+    uart->CR1 |= USART_CR1_UE;
+
+    LINK_uart->Init.BaudRate = baud;
+    LINK_uart->Init.OverSampling = (config.over8 == 1U) ? UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+    LINK_pcb.baud = baud;
+}
+
+/*******************************************************************************
+ * @brief   Send an acknowledge with a baud rate
+ * @param   cmd, char: Command to acknowledge
+ * @param   baud, uint32_t: Baud rate
+ * @retval  None
+ *
+ ******************************************************************************/
+static void LINK_Reply(const char *cmd, uint32_t baud)
+{
+    char ack[ 32 ];
+
+    sprintf( ack, "%s = %u\r\n", cmd, (unsigned int) baud );
+    (void) TX_Send( TX_PRIO_ACK, ack, strlen( ack ) );
+}
+/****************************** END OF FILE ***********************************/
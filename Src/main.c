@@ -38,11 +38,23 @@
 #include "cli.h"
 #include "stm32f7xx_hal.h"
 #include "tcd1304.h"
+#include "crc32.h"
+#include "link.h"
+#include "stream.h"
+#include "tx.h"
+#include "event.h"
 #include "string.h"
 
+/* Private defines -----------------------------------------------------------*/
+/**
+ * Non-cacheable RAM for the DMA buffers. Must match the RAM_DMA region of the
+ * linker script and the RW_DMA region of the scatter file.
+ */
+#define DMA_RAM_BASE                    (0x20040000U)
+#define DMA_RAM_MPU_SIZE                MPU_REGION_SIZE_64KB
+
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
-volatile uint8_t requestToSendFlag = 0;
 const char HEADER[] =
 "--------------------------------------\r\n"
 "          STM32F746 Discovery         \r\n"
@@ -81,20 +93,51 @@ TCD_CONFIG_t sensor_config =
     .f_master = 4000000,    /* Master clock:     4 MHz  */
     .t_icg_us = 3800,       /* Readout period:   3.8 ms */
     .t_int_us = 10,         /* Integration time: 10 us  */
+    .avg_mode = TCD_AVG_BLOCK, /* Averaging mode: block */
+    .ema_alpha = 6554,      /* EMA smoothing:    ~0.1   */
+    .bin = 1,               /* Binning:          none   */
 };
 
 /* Private function prototypes -----------------------------------------------*/
 static void SystemClock_Config(void);
 static void MX_USART1_UART_Init(void);
 static void MCU_Init(void);
+static void MPU_Config(void);
 
 int main(void)
 {
     /* Initialize the MCU and all configured peripherals */
     MCU_Init();
 
-    /* Display some welcome text to the user */
-    HAL_UART_Transmit( &huart1, (uint8_t *) HEADER, strlen(HEADER), 1000U );
+    /* The main loop sleeps until an interrupt raises an event */
+    EVENT_Init();
+
+    /* Initialize the transmit queue, all output to the host goes through it */
+    if ( TX_Init( &huart1 ) != TX_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
+    /* Display some welcome text to the user, the DMA reads it from flash */
+    (void) TX_SendBuffer( TX_PRIO_TELEMETRY, HEADER, strlen(HEADER) );
+
+    /* Initialize the CRC unit for the frame checksums */
+    if ( CRC32_Init() != CRC32_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
+    /* Initialize the serial link to the host */
+    if ( LINK_Init( &huart1 ) != LINK_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
+
+    /* Initialize the spectrum output, polled until STREAM= is received */
+    if ( STREAM_Init() != STREAM_OK )
+    {
+        _Error_Handler( __FILE__, __LINE__ );
+    }
 
     /* Initialize the command line interface (CLI) */
     if ( CLI_Init( &huart1 ) != CLI_OK )
@@ -114,17 +157,30 @@ int main(void)
 
     while ( 1 )
     {
-        if ( (TCD_IsDataReady() == 1U) && (requestToSendFlag == 1U) )
+        uint32_t events = EVENT_Wait();
+
+        /* Binary requests held back by a full transmit queue continue on TX */
+        if ( (events & (EVENT_RX | EVENT_TX)) != 0U )
         {
-            /* Clear the flags */
-            TCD_ClearDataReadyFlag();
-            requestToSendFlag = 0U;
+            CLI_CheckInputBuffer();
+        }
 
-            TCD_DATA_t *data = TCD_GetSensorData();
-            HAL_UART_Transmit_DMA( &huart1, (uint8_t *) data->SensorDataAvg, 2U * CFG_CCD_NUM_PIXELS );
+        /* A DATA or STREAM= command can also make a frame due */
+        if ( (events & (EVENT_DATA | EVENT_TX | EVENT_RX | EVENT_TICK)) != 0U )
+        {
+            STREAM_Process();
+            CLI_Process();
+        }
+
+        if ( (events & (EVENT_TX | EVENT_RX | EVENT_TICK)) != 0U )
+        {
+            LINK_Process();
         }
 
-        CLI_CheckInputBuffer();
+        if ( (events & EVENT_TICK) != 0U )
+        {
+            TX_Process();
+        }
     }
 }
 
@@ -134,9 +190,15 @@ int main(void)
  */
 static void MCU_Init(void)
 {
+    /* Make the DMA RAM non-cacheable before the D-cache is enabled */
+    MPU_Config();
+
     /* Enable I-Cache-------------------------------------------------------------*/
     SCB_EnableICache();
 
+    /* Enable D-Cache-------------------------------------------------------------*/
+    SCB_EnableDCache();
+
     /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
     HAL_Init();
 
@@ -147,6 +209,36 @@ static void MCU_Init(void)
     MX_USART1_UART_Init();
 }
 
+/**
+ * @brief   Configure the MPU to make the DMA RAM non-cacheable
+ * @retval  None
+ *
+ * All buffers written by a DMA are in the DMA RAM, so the CPU never reads
+ * stale data from the D-cache.
+ */
+static void MPU_Config(void)
+{
+    MPU_Region_InitTypeDef MPU_InitStruct;
+
+    HAL_MPU_Disable();
+
+    /* Normal memory, non-cacheable, shareable (TEX = 1, C = 0, B = 0, S = 1) */
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+    MPU_InitStruct.BaseAddress = DMA_RAM_BASE;
+    MPU_InitStruct.Size = DMA_RAM_MPU_SIZE;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion( &MPU_InitStruct );
+
+    HAL_MPU_Enable( MPU_PRIVILEGED_DEFAULT );
+}
+
 /**
  * @brief System Clock Configuration
  * @retval None
@@ -197,7 +289,8 @@ void SystemClock_Config(void)
     }
 
     PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_USART1;
-    PeriphClkInitStruct.Usart1ClockSelection = RCC_USART1CLKSOURCE_PCLK2;
+    /* SYSCLK allows up to 27 Mbit/s, see link.h */
+    PeriphClkInitStruct.Usart1ClockSelection = RCC_USART1CLKSOURCE_SYSCLK;
     if ( HAL_RCCEx_PeriphCLKConfig( &PeriphClkInitStruct ) != HAL_OK )
     {
         _Error_Handler( __FILE__, __LINE__ );
@@ -218,7 +311,7 @@ static void MX_USART1_UART_Init(void)
 {
 
     huart1.Instance = USART1;
-    huart1.Init.BaudRate = 115200;
+    huart1.Init.BaudRate = LINK_DEFAULT_BAUD;
     huart1.Init.WordLength = UART_WORDLENGTH_8B;
     huart1.Init.StopBits = UART_STOPBITS_1;
     huart1.Init.Parity = UART_PARITY_NONE;
@@ -234,6 +327,15 @@ static void MX_USART1_UART_Init(void)
 
 }
 
+/**
+ * @brief   A new average is ready, called from the deferred processing
+ * @retval  None
+ */
+void TCD_DataReadyCallback(void)
+{
+    EVENT_Set( EVENT_DATA );
+}
+
 /**
  * @brief  This function is executed in case of error occurrence.
  * @param  file: The file name as string.
@@ -0,0 +1,1067 @@
+/**
+ *******************************************************************************
+ * @file    : rpc.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Binary request/response protocol for the configuration
+ *
+ * The requests are assembled byte by byte from the CLI ring buffer and
+ * executed through a table of opcodes. GET and SET go through a table of
+ * parameters with a read and an optional write function.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "rpc.h"
+#include "tcd1304.h"
+#include "crc32.h"
+#include "link.h"
+#include "stream.h"
+#include "tx.h"
+#include "event.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define RPC_FRAME_MAX_SIZE              (RPC_HEADER_SIZE + RPC_MAX_LENGTH + RPC_CRC_SIZE)
+
+/* Values of one GET_BLOCK response */
+#define RPC_MAX_VALUES                  ((RPC_MAX_LENGTH - RPC_RESPONSE_MIN_LENGTH) / 4U)
+
+/* Transmit queue entries left for the frames and the ASCII acks */
+#define RPC_TX_RESERVE                  (1U)
+
+#if ( RPC_MAX_LENGTH > 255U )
+    #error "RPC_MAX_LENGTH must fit into the length byte"
+#endif
+
+#if ( RPC_FRAME_MAX_SIZE > TX_MSG_SIZE )
+    #error "The largest response must fit into one TX_Send() message"
+#endif
+
+#if ( (2U * CFG_MAX_WINDOWS) > 0x10U )
+    #error "The windows must fit into the ids 0x40 .. 0x4F"
+#endif
+
+#if ( CFG_MAX_BIN_EDGES > 0xB0U )
+    #error "The bin edges must fit into the ids 0x50 .. 0xFF"
+#endif
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef RPC_STATUS_t (*RPC_HANDLER_t)(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+
+typedef struct
+{
+    uint8_t opcode;
+    uint8_t argSize;
+    RPC_HANDLER_t handler;
+} RPC_COMMAND_t;
+
+typedef struct
+{
+    uint8_t id;
+    uint32_t (*get)(void);
+    RPC_STATUS_t (*set)(uint32_t value);    /* NULL if read-only             */
+} RPC_PARAM_ENTRY_t;
+
+typedef struct
+{
+    uint8_t id;                     /* Id of element 0                       */
+    uint8_t count;                  /* Elements, at ids id .. id + count - 1 */
+    uint32_t (*get)(uint32_t index);
+    RPC_STATUS_t (*set)(uint32_t index, uint32_t value);
+} RPC_ARRAY_ENTRY_t;
+
+typedef struct
+{
+    uint8_t request[ RPC_FRAME_MAX_SIZE ];
+    uint32_t pos;                   /* Bytes of the request received         */
+    uint32_t lastTick;              /* Time of the last byte                 */
+    uint8_t response[ TX_MSG_SIZE ];
+    uint32_t responseSize;          /* Responses waiting for RPC_Flush()     */
+    uint32_t requests;
+    uint32_t errors;
+} RPC_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+extern TCD_CONFIG_t sensor_config;
+
+/* Private variables ---------------------------------------------------------*/
+static RPC_PCB_t RPC_pcb;
+
+/* Private function prototypes -----------------------------------------------*/
+static void RPC_Execute(void);
+static void RPC_Respond(uint16_t id, uint8_t opcode, RPC_STATUS_t status,
+                        const uint8_t *result, uint32_t resultSize);
+static const RPC_PARAM_ENTRY_t* RPC_FindParam(uint32_t id);
+static const RPC_ARRAY_ENTRY_t* RPC_FindArray(uint32_t id, uint32_t *index);
+static RPC_STATUS_t RPC_ReadParam(uint32_t id, uint32_t *value);
+static RPC_STATUS_t RPC_WriteParam(uint32_t id, uint32_t value);
+static uint32_t RPC_Read32(const uint8_t *src);
+static void RPC_Write32(uint8_t *dst, uint32_t value);
+
+static RPC_STATUS_t RPC_Ping(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Get(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Set(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_GetBlock(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Run(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Stop(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Data(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+static RPC_STATUS_t RPC_Keyframe(const uint8_t *args, uint8_t *result, uint32_t *resultSize);
+
+static uint32_t RPC_GetAvg(void);
+static uint32_t RPC_GetFMaster(void);
+static uint32_t RPC_GetIcg(void);
+static uint32_t RPC_GetIntTime(void);
+static uint32_t RPC_GetAvgMode(void);
+static uint32_t RPC_GetAlpha(void);
+static uint32_t RPC_GetBin(void);
+static uint32_t RPC_GetWindows(void);
+static uint32_t RPC_GetBinEdges(void);
+static uint32_t RPC_GetStreamMode(void);
+static uint32_t RPC_GetLoop(void);
+static uint32_t RPC_GetEncoding(void);
+static uint32_t RPC_GetSpectrums(void);
+static uint32_t RPC_GetQueueDepth(void);
+static uint32_t RPC_GetQueueHighWater(void);
+static uint32_t RPC_GetFramesDropped(void);
+static uint32_t RPC_GetReadErrors(void);
+static uint32_t RPC_GetStreamSent(void);
+static uint32_t RPC_GetStreamDropped(void);
+static uint32_t RPC_GetStreamSkipped(void);
+static uint32_t RPC_GetTxOverflows(void);
+static uint32_t RPC_GetBaud(void);
+static uint32_t RPC_GetRequests(void);
+static uint32_t RPC_GetErrors(void);
+static uint32_t RPC_GetConfigPending(void);
+static uint32_t RPC_GetFMasterError(void);
+static uint32_t RPC_GetIntTimeError(void);
+static uint32_t RPC_GetIcgError(void);
+static uint32_t RPC_GetStreamKeyframes(void);
+static uint32_t RPC_GetWindow(uint32_t index);
+static uint32_t RPC_GetBinEdge(uint32_t index);
+
+static RPC_STATUS_t RPC_Reconfigure(TCD_CONFIG_t *config, uint8_t round);
+
+static RPC_STATUS_t RPC_SetAvg(uint32_t value);
+static RPC_STATUS_t RPC_SetIcg(uint32_t value);
+static RPC_STATUS_t RPC_SetIntTime(uint32_t value);
+static RPC_STATUS_t RPC_SetAvgMode(uint32_t value);
+static RPC_STATUS_t RPC_SetAlpha(uint32_t value);
+static RPC_STATUS_t RPC_SetBin(uint32_t value);
+static RPC_STATUS_t RPC_SetWindows(uint32_t value);
+static RPC_STATUS_t RPC_SetBinEdges(uint32_t value);
+static RPC_STATUS_t RPC_SetStreamMode(uint32_t value);
+static RPC_STATUS_t RPC_SetLoop(uint32_t value);
+static RPC_STATUS_t RPC_SetEncoding(uint32_t value);
+static RPC_STATUS_t RPC_SetWindow(uint32_t index, uint32_t value);
+static RPC_STATUS_t RPC_SetBinEdge(uint32_t index, uint32_t value);
+
+/* Dispatch tables, they follow the prototypes of their functions */
+static const RPC_COMMAND_t RPC_commands[] =
+{
+    { RPC_OP_PING,      0U, RPC_Ping     },
+    { RPC_OP_GET,       1U, RPC_Get      },
+    { RPC_OP_SET,       5U, RPC_Set      },
+    { RPC_OP_GET_BLOCK, 2U, RPC_GetBlock },
+    { RPC_OP_RUN,       0U, RPC_Run      },
+    { RPC_OP_STOP,      0U, RPC_Stop     },
+    { RPC_OP_DATA,      0U, RPC_Data     },
+    { RPC_OP_KEYFRAME,  0U, RPC_Keyframe }
+};
+
+static const RPC_PARAM_ENTRY_t RPC_params[] =
+{
+    { RPC_PARAM_AVG,              RPC_GetAvg,            RPC_SetAvg        },
+    { RPC_PARAM_F_MASTER,         RPC_GetFMaster,        NULL              },
+    { RPC_PARAM_T_ICG_US,         RPC_GetIcg,            RPC_SetIcg        },
+    { RPC_PARAM_T_INT_US,         RPC_GetIntTime,        RPC_SetIntTime    },
+    { RPC_PARAM_AVG_MODE,         RPC_GetAvgMode,        RPC_SetAvgMode    },
+    { RPC_PARAM_EMA_ALPHA,        RPC_GetAlpha,          RPC_SetAlpha      },
+    { RPC_PARAM_BIN,              RPC_GetBin,            RPC_SetBin        },
+    { RPC_PARAM_WINDOWS,          RPC_GetWindows,        RPC_SetWindows    },
+    { RPC_PARAM_BIN_EDGES,        RPC_GetBinEdges,       RPC_SetBinEdges   },
+    { RPC_PARAM_STREAM_MODE,      RPC_GetStreamMode,     RPC_SetStreamMode },
+    { RPC_PARAM_LOOP,             RPC_GetLoop,           RPC_SetLoop       },
+    { RPC_PARAM_ENCODING,         RPC_GetEncoding,       RPC_SetEncoding   },
+    { RPC_PARAM_SPECTRUMS,        RPC_GetSpectrums,      NULL              },
+    { RPC_PARAM_QUEUE_DEPTH,      RPC_GetQueueDepth,     NULL              },
+    { RPC_PARAM_QUEUE_HIGH_WATER, RPC_GetQueueHighWater, NULL              },
+    { RPC_PARAM_FRAMES_DROPPED,   RPC_GetFramesDropped,  NULL              },
+    { RPC_PARAM_STREAM_SENT,      RPC_GetStreamSent,     NULL              },
+    { RPC_PARAM_STREAM_DROPPED,   RPC_GetStreamDropped,  NULL              },
+    { RPC_PARAM_STREAM_SKIPPED,   RPC_GetStreamSkipped,  NULL              },
+    { RPC_PARAM_TX_OVERFLOWS,     RPC_GetTxOverflows,    NULL              },
+    { RPC_PARAM_BAUD,             RPC_GetBaud,           NULL              },
+    { RPC_PARAM_RPC_REQUESTS,     RPC_GetRequests,       NULL              },
+    { RPC_PARAM_RPC_ERRORS,       RPC_GetErrors,         NULL              },
+    { RPC_PARAM_CONFIG_PENDING,   RPC_GetConfigPending,  NULL              },
+    { RPC_PARAM_F_MASTER_ERR_HZ,  RPC_GetFMasterError,   NULL              },
+    { RPC_PARAM_T_INT_ERR_NS,     RPC_GetIntTimeError,   NULL              },
+    { RPC_PARAM_T_ICG_ERR_NS,     RPC_GetIcgError,       NULL              },
+    { RPC_PARAM_STREAM_KEYFRAMES, RPC_GetStreamKeyframes, NULL             },
+    { RPC_PARAM_READ_ERRORS,      RPC_GetReadErrors,     NULL              }
+};
+
+static const RPC_ARRAY_ENTRY_t RPC_arrays[] =
+{
+    { RPC_PARAM_WINDOW,   2U * CFG_MAX_WINDOWS, RPC_GetWindow,  RPC_SetWindow  },
+    { RPC_PARAM_BIN_EDGE, CFG_MAX_BIN_EDGES,    RPC_GetBinEdge, RPC_SetBinEdge }
+};
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the request parser
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void RPC_Init(void)
+{
+    memset( &RPC_pcb, 0, sizeof(RPC_pcb) );
+}
+
+/*******************************************************************************
+ * @brief   Add one received byte to the request
+ * @param   byte, uint8_t: Byte from the UART
+ * @retval  RPC_OK when a request was executed, RPC_BUSY when the byte was
+ *          taken, RPC_ERR_FRAME when the request was dropped, RPC_ERROR when
+ *          the byte does not belong to a request.
+ *
+ * Called by the CLI for RPC_SYNC and while RPC_IsReceiving().
+ ******************************************************************************/
+RPC_ERR_t RPC_ProcessByte(uint8_t byte)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t length;
+
+    /* The rest of the request got lost, start over */
+    if ( (RPC_pcb.pos > 0U) && ((now - RPC_pcb.lastTick) > RPC_BYTE_TIMEOUT_MS) )
+    {
+        RPC_pcb.pos = 0U;
+        RPC_pcb.errors++;
+    }
+    RPC_pcb.lastTick = now;
+
+    if ( (RPC_pcb.pos == 0U) && (byte != RPC_SYNC) )
+    {
+        return RPC_ERROR;
+    }
+
+    RPC_pcb.request[ RPC_pcb.pos++ ] = byte;
+
+    if ( RPC_pcb.pos < RPC_HEADER_SIZE )
+    {
+        return RPC_BUSY;
+    }
+
+    length = RPC_pcb.request[ 1 ];
+    if ( (length < RPC_REQUEST_MIN_LENGTH) || (length > RPC_MAX_LENGTH) )
+    {
+        RPC_pcb.pos = 0U;
+        RPC_pcb.errors++;
+        return RPC_ERR_FRAME;
+    }
+
+    if ( RPC_pcb.pos < (RPC_HEADER_SIZE + length + RPC_CRC_SIZE) )
+    {
+        return RPC_BUSY;
+    }
+
+    RPC_pcb.pos = 0U;
+    if ( CRC32_Software( 0U, &RPC_pcb.request[ 1 ], length + 1U ) !=
+         RPC_Read32( &RPC_pcb.request[ RPC_HEADER_SIZE + length ] ) )
+    {
+        RPC_pcb.errors++;
+        return RPC_ERR_FRAME;
+    }
+
+    RPC_pcb.requests++;
+    RPC_Execute();
+
+    return RPC_OK;
+}
+
+/*******************************************************************************
+ * @brief   Check if a request is partly received
+ * @param   None
+ * @retval  1 if the next byte belongs to a request, 0 if not
+ *
+ ******************************************************************************/
+uint8_t RPC_IsReceiving(void)
+{
+    return (RPC_pcb.pos > 0U) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @brief   Check if the next request could not be answered
+ * @param   None
+ * @retval  1 if the response buffer is full and cannot be flushed, 0 if not
+ *
+ * Called by the CLI before each byte. It stops reading the ring buffer until
+ * the transmit queue has room again.
+ ******************************************************************************/
+uint8_t RPC_IsStalled(void)
+{
+    if ( (RPC_pcb.responseSize + RPC_FRAME_MAX_SIZE) <= sizeof(RPC_pcb.response) )
+    {
+        return 0U;
+    }
+
+    RPC_Flush();
+
+    return (RPC_pcb.responseSize > 0U) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @brief   Queue the collected responses for transmission
+ * @param   None
+ * @retval  None
+ *
+ * Called by the CLI after the received bytes were processed. The responses
+ * are sent as one message, so a burst of requests needs few queue entries.
+ * If the queue is too full they are kept for the next call.
+ ******************************************************************************/
+void RPC_Flush(void)
+{
+    if ( (RPC_pcb.responseSize > 0U) && (TX_GetFree() > RPC_TX_RESERVE) )
+    {
+        if ( TX_Send( TX_PRIO_ACK, RPC_pcb.response, RPC_pcb.responseSize ) == TX_OK )
+        {
+            RPC_pcb.responseSize = 0U;
+        }
+    }
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Look up the opcode of the received request and run it
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+static void RPC_Execute(void)
+{
+    const uint8_t *body = &RPC_pcb.request[ RPC_HEADER_SIZE ];
+    uint32_t argSize = RPC_pcb.request[ 1 ] - RPC_REQUEST_MIN_LENGTH;
+    uint16_t id = (uint16_t) (body[ 0 ] | ((uint16_t) body[ 1 ] << 8));
+    uint8_t opcode = body[ 2 ];
+    uint8_t result[ RPC_MAX_LENGTH - RPC_RESPONSE_MIN_LENGTH ];
+    uint32_t resultSize = 0U;
+    RPC_STATUS_t status = RPC_STATUS_UNKNOWN_OPCODE;
+    uint32_t i;
+
+    for ( i = 0U; i < (sizeof(RPC_commands) / sizeof(RPC_commands[ 0 ])); i++ )
+    {
+        if ( RPC_commands[ i ].opcode == opcode )
+        {
+            if ( RPC_commands[ i ].argSize == argSize )
+            {
+                status = RPC_commands[ i ].handler( &body[ 3 ], result, &resultSize );
+            }
+            else
+            {
+                status = RPC_STATUS_BAD_LENGTH;
+            }
+            break;
+        }
+    }
+
+    if ( status != RPC_STATUS_OK )
+    {
+        resultSize = 0U;
+    }
+    RPC_Respond( id, opcode, status, result, resultSize );
+}
+
+/*******************************************************************************
+ * @brief   Append a response to the ones waiting for RPC_Flush()
+ * @param   id, uint16_t: Id of the request
+ * @param   opcode, uint8_t: Opcode of the request
+ * @param   status, RPC_STATUS_t: Result of the request
+ * @param   result, const uint8_t*: Result data
+ * @param   resultSize, uint32_t: Bytes of result data
+ * @retval  None
+ *
+ ******************************************************************************/
+static void RPC_Respond(uint16_t id, uint8_t opcode, RPC_STATUS_t status,
+                        const uint8_t *result, uint32_t resultSize)
+{
+    uint32_t length = RPC_RESPONSE_MIN_LENGTH + resultSize;
+    uint8_t *dst;
+
+    /* RPC_IsStalled() has made room for the largest response */
+    dst = &RPC_pcb.response[ RPC_pcb.responseSize ];
+    dst[ 0 ] = RPC_SYNC;
+    dst[ 1 ] = (uint8_t) length;
+    dst[ 2 ] = (uint8_t) id;
+    dst[ 3 ] = (uint8_t) (id >> 8);
+    dst[ 4 ] = opcode;
+    dst[ 5 ] = (uint8_t) status;
+    memcpy( &dst[ 6 ], result, resultSize );
+    RPC_Write32( &dst[ RPC_HEADER_SIZE + length ], CRC32_Software( 0U, &dst[ 1 ], length + 1U ) );
+
+    RPC_pcb.responseSize += RPC_HEADER_SIZE + length + RPC_CRC_SIZE;
+}
+
+/*******************************************************************************
+ * @brief   Find a parameter in the table
+ * @param   id, uint32_t: RPC_PARAM_t
+ * @retval  The table entry or NULL
+ *
+ ******************************************************************************/
+static const RPC_PARAM_ENTRY_t* RPC_FindParam(uint32_t id)
+{
+    uint32_t i;
+
+    for ( i = 0U; i < (sizeof(RPC_params) / sizeof(RPC_params[ 0 ])); i++ )
+    {
+        if ( RPC_params[ i ].id == id )
+        {
+            return &RPC_params[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * @brief   Find the array holding a parameter
+ * @param   id, uint32_t: RPC_PARAM_t
+ * @param   index, uint32_t*: Receives the element of the array
+ * @retval  The table entry or NULL
+ *
+ ******************************************************************************/
+static const RPC_ARRAY_ENTRY_t* RPC_FindArray(uint32_t id, uint32_t *index)
+{
+    uint32_t i;
+
+    for ( i = 0U; i < (sizeof(RPC_arrays) / sizeof(RPC_arrays[ 0 ])); i++ )
+    {
+        if ( (id >= RPC_arrays[ i ].id) && ((id - RPC_arrays[ i ].id) < RPC_arrays[ i ].count) )
+        {
+            *index = id - RPC_arrays[ i ].id;
+            return &RPC_arrays[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * @brief   Read a parameter or an array element
+ * @param   id, uint32_t: RPC_PARAM_t
+ * @param   value, uint32_t*: Receives the value
+ * @retval  RPC_STATUS_OK or RPC_STATUS_UNKNOWN_PARAM
+ *
+ ******************************************************************************/
+static RPC_STATUS_t RPC_ReadParam(uint32_t id, uint32_t *value)
+{
+    const RPC_PARAM_ENTRY_t *param = RPC_FindParam( id );
+    const RPC_ARRAY_ENTRY_t *array;
+    uint32_t index;
+
+    if ( param != NULL )
+    {
+        *value = param->get();
+        return RPC_STATUS_OK;
+    }
+
+    array = RPC_FindArray( id, &index );
+    if ( array != NULL )
+    {
+        *value = array->get( index );
+        return RPC_STATUS_OK;
+    }
+
+    return RPC_STATUS_UNKNOWN_PARAM;
+}
+
+/*******************************************************************************
+ * @brief   Write a parameter or an array element
+ * @param   id, uint32_t: RPC_PARAM_t
+ * @param   value, uint32_t: New value
+ * @retval  RPC_STATUS_t
+ *
+ ******************************************************************************/
+static RPC_STATUS_t RPC_WriteParam(uint32_t id, uint32_t value)
+{
+    const RPC_PARAM_ENTRY_t *param = RPC_FindParam( id );
+    const RPC_ARRAY_ENTRY_t *array;
+    uint32_t index;
+
+    if ( param != NULL )
+    {
+        return (param->set != NULL) ? param->set( value ) : RPC_STATUS_READ_ONLY;
+    }
+
+    array = RPC_FindArray( id, &index );
+    if ( array != NULL )
+    {
+        return array->set( index, value );
+    }
+
+    return RPC_STATUS_UNKNOWN_PARAM;
+}
+
+/*******************************************************************************
+ * @brief   Little-endian access to unaligned request and response fields
+ ******************************************************************************/
+static uint32_t RPC_Read32(const uint8_t *src)
+{
+    return (uint32_t) src[ 0 ] | ((uint32_t) src[ 1 ] << 8) |
+           ((uint32_t) src[ 2 ] << 16) | ((uint32_t) src[ 3 ] << 24);
+}
+
+static void RPC_Write32(uint8_t *dst, uint32_t value)
+{
+    dst[ 0 ] = (uint8_t) value;
+    dst[ 1 ] = (uint8_t) (value >> 8);
+    dst[ 2 ] = (uint8_t) (value >> 16);
+    dst[ 3 ] = (uint8_t) (value >> 24);
+}
+
+/*******************************************************************************
+ * @brief   Opcode handlers, see RPC_OP_t
+ * @param   args, const uint8_t*: Arguments, the size is checked by the table
+ * @param   result, uint8_t*: Result data
+ * @param   resultSize, uint32_t*: Bytes of result data
+ * @retval  RPC_STATUS_t
+ *
+ ******************************************************************************/
+static RPC_STATUS_t RPC_Ping(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    (void) args;
+    RPC_Write32( result, RPC_VERSION );
+    *resultSize = 4U;
+
+    return RPC_STATUS_OK;
+}
+
+static RPC_STATUS_t RPC_Get(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    uint32_t value;
+    RPC_STATUS_t status = RPC_ReadParam( args[ 0 ], &value );
+
+    if ( status == RPC_STATUS_OK )
+    {
+        RPC_Write32( result, value );
+        *resultSize = 4U;
+    }
+
+    return status;
+}
+
+static RPC_STATUS_t RPC_Set(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    uint32_t value;
+    RPC_STATUS_t status = RPC_WriteParam( args[ 0 ], RPC_Read32( &args[ 1 ] ) );
+
+    if ( status == RPC_STATUS_OK )
+    {
+        /* Read back, the driver may have rounded the value */
+        (void) RPC_ReadParam( args[ 0 ], &value );
+        RPC_Write32( result, value );
+        *resultSize = 4U;
+    }
+
+    return status;
+}
+
+static RPC_STATUS_t RPC_GetBlock(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    uint32_t count = args[ 1 ];
+    uint32_t value;
+    uint32_t i;
+
+    if ( (count == 0U) || (count > RPC_MAX_VALUES) )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    for ( i = 0U; i < count; i++ )
+    {
+        if ( RPC_ReadParam( (uint32_t) args[ 0 ] + i, &value ) != RPC_STATUS_OK )
+        {
+            value = 0U;
+        }
+        RPC_Write32( &result[ 4U * i ], value );
+    }
+    *resultSize = 4U * count;
+
+    return RPC_STATUS_OK;
+}
+
+static RPC_STATUS_t RPC_Run(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    (void) args;
+    (void) result;
+    (void) resultSize;
+
+    return (TCD_Start() == TCD_OK) ? RPC_STATUS_OK : RPC_STATUS_FAILED;
+}
+
+static RPC_STATUS_t RPC_Stop(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    (void) args;
+    (void) result;
+    (void) resultSize;
+
+    return (TCD_Stop() == TCD_OK) ? RPC_STATUS_OK : RPC_STATUS_FAILED;
+}
+
+static RPC_STATUS_t RPC_Data(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    (void) args;
+    (void) result;
+    (void) resultSize;
+
+    STREAM_Request();
+
+    return RPC_STATUS_OK;
+}
+
+static RPC_STATUS_t RPC_Keyframe(const uint8_t *args, uint8_t *result, uint32_t *resultSize)
+{
+    (void) args;
+    (void) result;
+    (void) resultSize;
+
+    STREAM_RequestKeyframe();
+
+    return RPC_STATUS_OK;
+}
+
+/*******************************************************************************
+ * @brief   Read functions of the parameters, see RPC_PARAM_t
+ * @param   None
+ * @retval  Value of the parameter
+ *
+ ******************************************************************************/
+static uint32_t RPC_GetAvg(void)
+{
+    return sensor_config.avg;
+}
+
+static uint32_t RPC_GetFMaster(void)
+{
+    return sensor_config.f_master;
+}
+
+static uint32_t RPC_GetIcg(void)
+{
+    return sensor_config.t_icg_us;
+}
+
+static uint32_t RPC_GetIntTime(void)
+{
+    return sensor_config.t_int_us;
+}
+
+static uint32_t RPC_GetAvgMode(void)
+{
+    return (uint32_t) sensor_config.avg_mode;
+}
+
+static uint32_t RPC_GetAlpha(void)
+{
+    return sensor_config.ema_alpha;
+}
+
+static uint32_t RPC_GetBin(void)
+{
+    return sensor_config.bin;
+}
+
+static uint32_t RPC_GetWindows(void)
+{
+    return sensor_config.windows;
+}
+
+static uint32_t RPC_GetBinEdges(void)
+{
+    return sensor_config.binEdges;
+}
+
+static uint32_t RPC_GetStreamMode(void)
+{
+    return (uint32_t) STREAM_GetMode();
+}
+
+static uint32_t RPC_GetLoop(void)
+{
+    return (uint32_t) EVENT_GetLoop();
+}
+
+static uint32_t RPC_GetEncoding(void)
+{
+    return (uint32_t) STREAM_GetEncoding();
+}
+
+static uint32_t RPC_GetSpectrums(void)
+{
+    return (uint32_t) TCD_GetNumOfSpectrumsAcquired();
+}
+
+static uint32_t RPC_GetQueueDepth(void)
+{
+    TCD_QUEUE_STATS_t stats;
+    TCD_GetQueueStats( &stats );
+
+    return stats.queueDepth;
+}
+
+static uint32_t RPC_GetQueueHighWater(void)
+{
+    TCD_QUEUE_STATS_t stats;
+    TCD_GetQueueStats( &stats );
+
+    return stats.queueHighWater;
+}
+
+static uint32_t RPC_GetFramesDropped(void)
+{
+    TCD_QUEUE_STATS_t stats;
+    TCD_GetQueueStats( &stats );
+
+    return stats.framesDropped;
+}
+
+static uint32_t RPC_GetReadErrors(void)
+{
+    TCD_QUEUE_STATS_t stats;
+    TCD_GetQueueStats( &stats );
+
+    return stats.readErrors;
+}
+
+static uint32_t RPC_GetStreamSent(void)
+{
+    STREAM_STATS_t stats;
+    STREAM_GetStats( &stats );
+
+    return stats.sent;
+}
+
+static uint32_t RPC_GetStreamDropped(void)
+{
+    STREAM_STATS_t stats;
+    STREAM_GetStats( &stats );
+
+    return stats.dropped;
+}
+
+static uint32_t RPC_GetStreamSkipped(void)
+{
+    STREAM_STATS_t stats;
+    STREAM_GetStats( &stats );
+
+    return stats.skipped;
+}
+
+static uint32_t RPC_GetTxOverflows(void)
+{
+    return TX_GetOverflows();
+}
+
+static uint32_t RPC_GetBaud(void)
+{
+    return LINK_GetBaud();
+}
+
+static uint32_t RPC_GetRequests(void)
+{
+    return RPC_pcb.requests;
+}
+
+static uint32_t RPC_GetErrors(void)
+{
+    return RPC_pcb.errors;
+}
+
+static uint32_t RPC_GetConfigPending(void)
+{
+    return TCD_IsReconfigurePending();
+}
+
+static uint32_t RPC_GetFMasterError(void)
+{
+    TCD_TIMING_t timing = { 0 };
+    (void) TCD_GetTiming( &sensor_config, &timing );
+
+    return (uint32_t) timing.f_master_err_hz;
+}
+
+static uint32_t RPC_GetIntTimeError(void)
+{
+    TCD_TIMING_t timing = { 0 };
+    (void) TCD_GetTiming( &sensor_config, &timing );
+
+    return (uint32_t) timing.t_int_err_ns;
+}
+
+static uint32_t RPC_GetIcgError(void)
+{
+    TCD_TIMING_t timing = { 0 };
+    (void) TCD_GetTiming( &sensor_config, &timing );
+
+    return (uint32_t) timing.t_icg_err_ns;
+}
+
+static uint32_t RPC_GetStreamKeyframes(void)
+{
+    STREAM_STATS_t stats;
+    STREAM_GetStats( &stats );
+
+    return stats.keyframes;
+}
+
+/*******************************************************************************
+ * @brief   Read functions of the parameter arrays, see RPC_PARAM_t
+ * @param   index, uint32_t: Element, below the count of the array entry
+ * @retval  Value of the element
+ *
+ ******************************************************************************/
+static uint32_t RPC_GetWindow(uint32_t index)
+{
+    const TCD_WINDOW_t *window = &sensor_config.window[ index / 2U ];
+
+    return ((index & 1U) == 0U) ? window->first : window->count;
+}
+
+static uint32_t RPC_GetBinEdge(uint32_t index)
+{
+    return sensor_config.binEdge[ index ];
+}
+
+/*******************************************************************************
+ * @brief   Apply a changed copy of the sensor configuration
+ * @param   config, TCD_CONFIG_t: The new configuration
+ * @param   round, uint8_t: 1 to round the SH period to a divisor of the ICG
+ *          period, see TCD_SetIntTime()
+ * @retval  RPC_STATUS_OK or RPC_STATUS_OUT_OF_RANGE if it was rejected
+ *
+ * The configuration changes at the next ICG pulse, see TCD_Reconfigure().
+ ******************************************************************************/
+static RPC_STATUS_t RPC_Reconfigure(TCD_CONFIG_t *config, uint8_t round)
+{
+    TCD_ERR_t err = (round == 1U) ? TCD_SetIntTime( config ) : TCD_Reconfigure( config );
+
+    if ( err != TCD_OK )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    sensor_config = *config;
+
+    return RPC_STATUS_OK;
+}
+
+/*******************************************************************************
+ * @brief   Write functions of the parameters, see RPC_PARAM_t
+ * @param   value, uint32_t: New value
+ * @retval  RPC_STATUS_t
+ *
+ * The same checks and actions as the ASCII commands of the CLI.
+ ******************************************************************************/
+static RPC_STATUS_t RPC_SetAvg(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+    config.avg = value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetIcg(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+    config.t_icg_us = value;
+
+    return RPC_Reconfigure( &config, 1U );
+}
+
+static RPC_STATUS_t RPC_SetIntTime(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+    config.t_int_us = value;
+
+    return RPC_Reconfigure( &config, 1U );
+}
+
+static RPC_STATUS_t RPC_SetAvgMode(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+
+    if ( value > (uint32_t) TCD_AVG_EMA )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+    config.avg_mode = (TCD_AVG_MODE_t) value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetAlpha(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+    config.ema_alpha = value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetBin(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+
+    /* 0 uses the bin edge table of the configuration, see RPC_PARAM_BIN_EDGE */
+    config.bin = value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetWindows(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+    config.windows = value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetBinEdges(uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+
+    /* Only checked by the driver while the table is in use */
+    if ( value > CFG_MAX_BIN_EDGES )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+    config.binEdges = value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetStreamMode(uint32_t value)
+{
+    if ( value > (uint32_t) STREAM_MODE_SKIP )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    (void) STREAM_SetMode( (STREAM_MODE_t) value );
+
+    if ( value != (uint32_t) STREAM_MODE_POLLED )
+    {
+        STREAM_ResetStats();
+    }
+
+    return RPC_STATUS_OK;
+}
+
+static RPC_STATUS_t RPC_SetLoop(uint32_t value)
+{
+    if ( value > (uint32_t) EVENT_LOOP_SLEEP )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    EVENT_SetLoop( (EVENT_LOOP_t) value );
+
+    return RPC_STATUS_OK;
+}
+
+static RPC_STATUS_t RPC_SetEncoding(uint32_t value)
+{
+    if ( STREAM_SetEncoding( (FRAME_ENCODING_t) value ) != STREAM_OK )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    return RPC_STATUS_OK;
+}
+
+/*******************************************************************************
+ * @brief   Write functions of the parameter arrays, see RPC_PARAM_t
+ * @param   index, uint32_t: Element, below the count of the array entry
+ * @param   value, uint32_t: New value
+ * @retval  RPC_STATUS_t
+ *
+ * The changed configuration is checked as a whole, see RPC_Reconfigure().
+ ******************************************************************************/
+static RPC_STATUS_t RPC_SetWindow(uint32_t index, uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+
+    if ( value > CFG_CCD_NUM_PIXELS )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    if ( (index & 1U) == 0U )
+    {
+        config.window[ index / 2U ].first = (uint16_t) value;
+    }
+    else
+    {
+        config.window[ index / 2U ].count = (uint16_t) value;
+    }
+
+    return RPC_Reconfigure( &config, 0U );
+}
+
+static RPC_STATUS_t RPC_SetBinEdge(uint32_t index, uint32_t value)
+{
+    TCD_CONFIG_t config = sensor_config;
+
+    if ( value > CFG_CCD_NUM_PIXELS )
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+    config.binEdge[ index ] = (uint16_t) value;
+
+    return RPC_Reconfigure( &config, 0U );
+}
+/****************************** END OF FILE ***********************************/
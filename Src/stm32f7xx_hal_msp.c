@@ -71,6 +71,17 @@ void HAL_MspInit(void)
   HAL_NVIC_SetPriority(SysTick_IRQn, 15, 0);
 }
 
+void HAL_CRC_MspInit(CRC_HandleTypeDef* hcrc)
+{
+
+  if(hcrc->Instance==CRC)
+  {
+    /* Peripheral clock enable */
+    __HAL_RCC_CRC_CLK_ENABLE();
+  }
+
+}
+
 void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 {
 
@@ -146,6 +157,10 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     /* DMA2_Stream7_IRQn interrupt configuration */
     HAL_NVIC_SetPriority( DMA2_Stream7_IRQn, 0, 0 );
     HAL_NVIC_EnableIRQ( DMA2_Stream7_IRQn );
+
+    /* USART1_IRQn interrupt configuration, signals the end of a transmission */
+    HAL_NVIC_SetPriority( USART1_IRQn, 0, 0 );
+    HAL_NVIC_EnableIRQ( USART1_IRQn );
   }
 
 }
@@ -169,6 +184,9 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     /* USART1 DMA DeInit */
     HAL_DMA_DeInit(huart->hdmatx);
     HAL_DMA_DeInit(huart->hdmarx);
+
+    /* USART1 interrupt DeInit */
+    HAL_NVIC_DisableIRQ(USART1_IRQn);
   }
 
 }
@@ -37,6 +37,7 @@
 #include "stm32f7xx_hal.h"
 #include "stm32f7xx.h"
 #include "stm32f7xx_it.h"
+#include "cli.h"
 
 /* External variables --------------------------------------------------------*/
 extern DMA_HandleTypeDef hdma_usart1_tx;
@@ -77,7 +78,26 @@ void DMA2_Stream2_IRQHandler(void)
 void DMA2_Stream7_IRQHandler(void)
 {
     HAL_DMA_IRQHandler( &hdma_usart1_tx );
-    huart1.gState = HAL_UART_STATE_READY;
+}
+
+/**
+ * @brief This function handles USART1 global interrupt.
+ *
+ * The end of a DMA transmission is signalled by the transmission complete
+ * interrupt. The HAL then sets the state ready and calls
+ * HAL_UART_TxCpltCallback(), which starts the next queued transfer.
+ * The idle line after received data is not handled by the HAL.
+ */
+void USART1_IRQHandler(void)
+{
+    if ( (__HAL_UART_GET_FLAG( &huart1, UART_FLAG_IDLE ) != RESET) &&
+         (__HAL_UART_GET_IT_SOURCE( &huart1, UART_IT_IDLE ) != RESET) )
+    {
+        __HAL_UART_CLEAR_IDLEFLAG( &huart1 );
+        CLI_RxIdleCallback();
+    }
+
+    HAL_UART_IRQHandler( &huart1 );
 }
 
 /****************************** END OF FILE ***********************************/
@@ -0,0 +1,593 @@
+/**
+ *******************************************************************************
+ * @file    : stream.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Output of the averaged spectra to the host
+ *
+ * Each frame buffer goes FREE -> CRC -> READY -> SENDING -> FREE. The spectrum
+ * is copied into a free buffer, the CRC unit checksums it, and it is queued
+ * for the UART. Only one buffer can be in CRC at a time, because there is one
+ * CRC unit, and only one is queued at a time, so the waiting one can still be
+ * replaced by a newer frame.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "main.h"
+#include "stream.h"
+#include "tcd1304.h"
+#include "frame.h"
+#include "crc32.h"
+#include "codec.h"
+#include "link.h"
+#include "tx.h"
+#include "event.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define STREAM_NUM_BUFFERS              (2U)
+#define STREAM_NO_BUFFER                (0xFFU)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef enum
+{
+    STREAM_BUF_FREE = 0,
+    STREAM_BUF_CRC,                 /* CRC unit is working on it             */
+    STREAM_BUF_READY,               /* Complete, waiting for the UART        */
+    STREAM_BUF_SENDING              /* In the transmit queue                 */
+} STREAM_BUF_STATE_t;
+
+typedef struct
+{
+    STREAM_BUF_STATE_t state;
+    uint32_t size;                  /* CRC bytes in CRC, frame bytes after   */
+    uint32_t sequence;              /* Order of the frames                   */
+    uint8_t keyframe;               /* Not coded against a reference         */
+} STREAM_BUF_t;
+
+typedef struct
+{
+    STREAM_MODE_t mode;
+    FRAME_ENCODING_t encoding;
+    volatile uint8_t request;
+    volatile uint8_t keyframe;      /* Next frame must not need a reference  */
+    uint32_t sinceKeyframe;         /* Delta frames since the last keyframe  */
+    uint32_t reference;             /* STREAM_reference of the last frame    */
+    uint32_t sequence;
+    STREAM_BUF_t buf[ STREAM_NUM_BUFFERS ];
+    STREAM_STATS_t stats;
+} STREAM_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static STREAM_PCB_t STREAM_pcb;
+
+/**
+ * Frames being built and sent. The averaged data is copied into them, so the
+ * driver can update SensorDataAvg during a transfer. Placed in the
+ * non-cacheable DMA RAM, no cache maintenance is needed.
+ */
+static uint32_t STREAM_frame[ STREAM_NUM_BUFFERS ][ (FRAME_MAX_SIZE + 3U) / 4U ] DMA_BUFFER;
+
+/**
+ * Values and layout of the last two frames built. The averaged data is read
+ * into one of them and coded against the other, the values the receiver
+ * decoded last, so it reconstructs every delta frame exactly. A frame that
+ * replaces a waiting one is read over it and coded against the same
+ * reference.
+ */
+static uint16_t STREAM_reference[ 2 ][ CFG_CCD_NUM_PIXELS ];
+static TCD_DATA_INFO_t STREAM_referenceInfo[ 2 ];
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t STREAM_FindBuffer(STREAM_BUF_STATE_t state);
+static void STREAM_StartTransmit(void);
+static void STREAM_BuildFrame(uint8_t idx);
+static uint32_t STREAM_IsKeyframeDue(const TCD_DATA_INFO_t *info, const TCD_DATA_INFO_t *ref);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the spectrum output in polled mode
+ * @param   None
+ * @retval  STREAM_OK
+ *
+ ******************************************************************************/
+STREAM_ERR_t STREAM_Init(void)
+{
+    memset( &STREAM_pcb, 0, sizeof(STREAM_pcb) );
+    STREAM_pcb.mode = STREAM_MODE_POLLED;
+    STREAM_pcb.encoding = FRAME_ENCODING_RAW;
+    STREAM_pcb.keyframe = 1U;
+
+    return STREAM_OK;
+}
+
+/*******************************************************************************
+ * @brief   Move the frames along and pick up new averages
+ * @param   None
+ * @retval  None
+ *
+ * Called from the main loop.
+ ******************************************************************************/
+void STREAM_Process(void)
+{
+    uint8_t idx;
+
+    /* Release the buffer that has been sent */
+    idx = STREAM_FindBuffer( STREAM_BUF_SENDING );
+    if ( (idx != STREAM_NO_BUFFER) && (TX_IsPending( STREAM_frame[ idx ] ) == 0U) )
+    {
+        STREAM_pcb.buf[ idx ].state = STREAM_BUF_FREE;
+        LINK_TxCompleted();
+    }
+
+    /* Complete the buffer that has been checksummed */
+    idx = STREAM_FindBuffer( STREAM_BUF_CRC );
+    if ( idx != STREAM_NO_BUFFER )
+    {
+        if ( CRC32_IsBusy() == 0U )
+        {
+            STREAM_pcb.buf[ idx ].size = FRAME_Finish( (uint8_t *) STREAM_frame[ idx ],
+                                                       STREAM_pcb.buf[ idx ].size, CRC32_GetResult() );
+            STREAM_pcb.buf[ idx ].state = STREAM_BUF_READY;
+        }
+        else
+        {
+            /* The CRC DMA has no interrupt, poll again on the next pass */
+            EVENT_Set( EVENT_DATA );
+        }
+    }
+
+    /* Send before taking new data, a waiting frame should not be dropped */
+    STREAM_StartTransmit();
+
+    if ( (TCD_IsDataReady() == 0U) ||
+         ((STREAM_pcb.mode == STREAM_MODE_POLLED) && (STREAM_pcb.request == 0U)) )
+    {
+        return;
+    }
+
+    /* The CRC unit is busy, the new average waits for the next pass */
+    if ( STREAM_FindBuffer( STREAM_BUF_CRC ) != STREAM_NO_BUFFER )
+    {
+        return;
+    }
+
+    idx = STREAM_FindBuffer( STREAM_BUF_FREE );
+    if ( idx == STREAM_NO_BUFFER )
+    {
+        switch ( STREAM_pcb.mode )
+        {
+            case STREAM_MODE_DROP_OLDEST:
+                /* Replace the waiting frame with the newer one */
+                idx = STREAM_FindBuffer( STREAM_BUF_READY );
+                if ( idx != STREAM_NO_BUFFER )
+                {
+                    STREAM_pcb.stats.dropped++;
+                }
+                break;
+
+            case STREAM_MODE_SKIP:
+                TCD_ClearDataReadyFlag();
+                STREAM_pcb.stats.skipped++;
+                break;
+
+            case STREAM_MODE_POLLED:
+            default:
+                /* Keep the request until a buffer is free */
+                break;
+        }
+
+        if ( idx == STREAM_NO_BUFFER )
+        {
+            return;
+        }
+    }
+
+    TCD_ClearDataReadyFlag();
+    STREAM_pcb.request = 0U;
+    STREAM_BuildFrame( idx );
+}
+
+/*******************************************************************************
+ * @brief   Request one frame in polled mode
+ * @param   None
+ * @retval  None
+ *
+ * The next average is sent, or the current one if it has not been sent yet.
+ ******************************************************************************/
+void STREAM_Request(void)
+{
+    STREAM_pcb.request = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Select polled or stream mode
+ * @param   mode, STREAM_MODE_t: New mode
+ * @retval  STREAM_OK on success or STREAM_ERR_t code
+ *
+ * Frames already built are still sent.
+ ******************************************************************************/
+STREAM_ERR_t STREAM_SetMode(STREAM_MODE_t mode)
+{
+    if ( mode > STREAM_MODE_SKIP )
+    {
+        return STREAM_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    STREAM_pcb.mode = mode;
+    STREAM_pcb.request = 0U;
+
+    return STREAM_OK;
+}
+
+/*******************************************************************************
+ * @brief   Get the output mode
+ * @param   None
+ * @retval  STREAM_MODE_t
+ *
+ ******************************************************************************/
+STREAM_MODE_t STREAM_GetMode(void)
+{
+    return STREAM_pcb.mode;
+}
+
+/*******************************************************************************
+ * @brief   Select the coding of the pixel values in the frames
+ * @param   encoding, FRAME_ENCODING_t: New encoding
+ * @retval  STREAM_OK on success or STREAM_ERR_t code
+ *
+ * Takes effect with the next frame built.
+ ******************************************************************************/
+STREAM_ERR_t STREAM_SetEncoding(FRAME_ENCODING_t encoding)
+{
+    if ( encoding > FRAME_ENCODING_LOG8 )
+    {
+        return STREAM_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    STREAM_pcb.encoding = encoding;
+    STREAM_pcb.keyframe = 1U;
+
+    return STREAM_OK;
+}
+
+/*******************************************************************************
+ * @brief   Get the coding of the pixel values in the frames
+ * @param   None
+ * @retval  FRAME_ENCODING_t
+ *
+ ******************************************************************************/
+FRAME_ENCODING_t STREAM_GetEncoding(void)
+{
+    return STREAM_pcb.encoding;
+}
+
+/*******************************************************************************
+ * @brief   Make the next frame a keyframe
+ * @param   None
+ * @retval  None
+ *
+ * For a receiver that lost the reference of the delta frames.
+ ******************************************************************************/
+void STREAM_RequestKeyframe(void)
+{
+    STREAM_pcb.keyframe = 1U;
+}
+
+/*******************************************************************************
+ * @brief   Get the sent, dropped and skipped frame counters
+ * @param   stats, STREAM_STATS_t: Struct to fill with the counters
+ * @retval  None
+ *
+ ******************************************************************************/
+void STREAM_GetStats(STREAM_STATS_t *stats)
+{
+    if ( stats == NULL )
+    {
+        return;
+    }
+
+    *stats = STREAM_pcb.stats;
+}
+
+/*******************************************************************************
+ * @brief   Reset the frame counters
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+void STREAM_ResetStats(void)
+{
+    memset( &STREAM_pcb.stats, 0, sizeof(STREAM_pcb.stats) );
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Find a frame buffer in a given state
+ * @param   state, STREAM_BUF_STATE_t: State to look for
+ * @retval  Index of the oldest buffer in that state, or STREAM_NO_BUFFER
+ *
+ ******************************************************************************/
+static uint8_t STREAM_FindBuffer(STREAM_BUF_STATE_t state)
+{
+    uint8_t found = STREAM_NO_BUFFER;
+    uint8_t i;
+
+    for ( i = 0U; i < STREAM_NUM_BUFFERS; i++ )
+    {
+        if ( (STREAM_pcb.buf[ i ].state == state) &&
+             ((found == STREAM_NO_BUFFER) ||
+              ((int32_t) (STREAM_pcb.buf[ i ].sequence - STREAM_pcb.buf[ found ].sequence) < 0)) )
+        {
+            found = i;
+        }
+    }
+
+    return found;
+}
+
+/*******************************************************************************
+ * @brief   Queue the oldest waiting frame when the previous one has been sent
+ * @param   None
+ * @retval  None
+ *
+ ******************************************************************************/
+static void STREAM_StartTransmit(void)
+{
+    uint8_t idx = STREAM_FindBuffer( STREAM_BUF_READY );
+
+    if ( (idx == STREAM_NO_BUFFER) || (STREAM_FindBuffer( STREAM_BUF_SENDING ) != STREAM_NO_BUFFER) ||
+         (LINK_IsTxAllowed() == 0U) )
+    {
+        return;
+    }
+
+    if ( TX_SendBuffer( TX_PRIO_DATA, STREAM_frame[ idx ], STREAM_pcb.buf[ idx ].size ) == TX_OK )
+    {
+        STREAM_pcb.buf[ idx ].state = STREAM_BUF_SENDING;
+        STREAM_pcb.stats.sent++;
+        STREAM_pcb.stats.keyframes += STREAM_pcb.buf[ idx ].keyframe;
+        LINK_TxStarted( STREAM_pcb.buf[ idx ].size );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Copy the averaged spectrum into a frame buffer and start the CRC
+ * @param   idx, uint8_t: Frame buffer, free or with a frame to replace
+ * @retval  None
+ *
+ * A frame that replaces a waiting one takes over its sequence number, so the
+ * receiver sees no gap and the reference of the new frame is still the frame
+ * sent before.
+ ******************************************************************************/
+static void STREAM_BuildFrame(uint8_t idx)
+{
+    uint8_t *frame = (uint8_t *) STREAM_frame[ idx ];
+    uint8_t *table;
+    uint32_t size = 0U;
+    uint32_t slot;
+    FRAME_HEADER_t header;
+    TCD_DATA_INFO_t *info;
+
+    if ( STREAM_pcb.buf[ idx ].state == STREAM_BUF_READY )
+    {
+        slot = STREAM_pcb.reference;
+        header.sequence = STREAM_pcb.buf[ idx ].sequence;
+
+        /* Undo the count of the dropped frame */
+        if ( STREAM_pcb.buf[ idx ].keyframe != 0U )
+        {
+            STREAM_pcb.keyframe = 1U;
+        }
+        else
+        {
+            STREAM_pcb.sinceKeyframe--;
+        }
+    }
+    else
+    {
+        slot = STREAM_pcb.reference ^ 1U;
+        header.sequence = STREAM_pcb.sequence++;
+    }
+    info = &STREAM_referenceInfo[ slot ];
+
+    header.encoding = (uint8_t) FRAME_ENCODING_RAW;
+
+    if ( STREAM_pcb.encoding != FRAME_ENCODING_RAW )
+    {
+        const uint16_t *values = STREAM_reference[ slot ];
+
+        TCD_ReadSensorDataAvg( STREAM_reference[ slot ], info );
+
+        /* The codes are only used when smaller than the raw values */
+        switch ( STREAM_pcb.encoding )
+        {
+            case FRAME_ENCODING_DELTA:
+                if ( STREAM_IsKeyframeDue( info, &STREAM_referenceInfo[ slot ^ 1U ] ) == 0U )
+                {
+                    size = CODEC_RiceEncodeDelta( FRAME_PAYLOAD( frame ), 2U * info->pixelCount - 1U,
+                                                  values, STREAM_reference[ slot ^ 1U ], info->pixelCount );
+                    header.encoding = (uint8_t) FRAME_ENCODING_DELTA;
+                }
+                if ( size != 0U )
+                {
+                    break;
+                }
+                /* A keyframe, Rice coded */
+                /* fall through */
+
+            case FRAME_ENCODING_RICE:
+                size = CODEC_RiceEncode( FRAME_PAYLOAD( frame ), 2U * info->pixelCount - 1U,
+                                         values, info->pixelCount );
+                header.encoding = (uint8_t) FRAME_ENCODING_RICE;
+                break;
+
+            case FRAME_ENCODING_PACK12:
+                /* Fails for binned values above 12 bit */
+                size = CODEC_Pack12( FRAME_PAYLOAD( frame ), 2U * info->pixelCount - 1U,
+                                     values, info->pixelCount );
+                header.encoding = (uint8_t) FRAME_ENCODING_PACK12;
+                break;
+
+            case FRAME_ENCODING_LOG8:
+                size = CODEC_Log8Encode( FRAME_PAYLOAD( frame ), 2U * info->pixelCount - 1U,
+                                         values, info->pixelCount );
+                header.encoding = (uint8_t) FRAME_ENCODING_LOG8;
+                break;
+
+            default:
+                break;
+        }
+
+        if ( size == 0U )
+        {
+            header.encoding = (uint8_t) FRAME_ENCODING_RAW;
+            size = 2U * info->pixelCount;
+            memcpy( FRAME_PAYLOAD( frame ), values, size );
+        }
+    }
+    else
+    {
+        /* Switching to delta coding starts with a keyframe, see STREAM_SetEncoding() */
+        TCD_ReadSensorDataAvg( (uint16_t *) FRAME_PAYLOAD( frame ), info );
+        size = 2U * info->pixelCount;
+    }
+    STREAM_pcb.reference = slot;
+
+    if ( header.encoding == (uint8_t) FRAME_ENCODING_DELTA )
+    {
+        STREAM_pcb.buf[ idx ].keyframe = 0U;
+        STREAM_pcb.sinceKeyframe++;
+    }
+    else
+    {
+        STREAM_pcb.buf[ idx ].keyframe = 1U;
+        STREAM_pcb.sinceKeyframe = 0U;
+        STREAM_pcb.keyframe = 0U;
+    }
+
+    /* The window table follows the pixels, see frame.h */
+    table = FRAME_PAYLOAD( frame ) + size;
+    for ( uint32_t w = 0U; w < info->windows; w++ )
+    {
+        table[ 0 ] = (uint8_t) info->window[ w ].first;
+        table[ 1 ] = (uint8_t) (info->window[ w ].first >> 8);
+        table[ 2 ] = (uint8_t) info->window[ w ].count;
+        table[ 3 ] = (uint8_t) (info->window[ w ].count >> 8);
+        table += FRAME_WINDOW_SIZE;
+    }
+
+    /* Then the bin edge table */
+    for ( uint32_t k = 0U; k < info->binEdges; k++ )
+    {
+        table[ 0 ] = (uint8_t) info->binEdge[ k ];
+        table[ 1 ] = (uint8_t) (info->binEdge[ k ] >> 8);
+        table += FRAME_EDGE_SIZE;
+    }
+
+    header.avgMode = (uint8_t) info->avg_mode;
+    header.acquisitions = (uint32_t) info->spectrums;
+    header.timestamp = HAL_GetTick();
+    header.t_int_us = info->t_int_us;
+    header.t_icg_us = info->t_icg_us;
+    header.avg = info->avg;
+    header.pixelCount = (uint16_t) info->pixelCount;
+    header.windows = (uint16_t) info->windows;
+    header.payloadSize = size + FRAME_WINDOW_SIZE * info->windows +
+                         FRAME_EDGE_SIZE * info->binEdges;
+    header.bin = (uint16_t) info->bin;
+    header.binEdges = (uint16_t) info->binEdges;
+
+    STREAM_pcb.buf[ idx ].size = FRAME_Prepare( frame, &header );
+    STREAM_pcb.buf[ idx ].sequence = header.sequence;
+    STREAM_pcb.buf[ idx ].state = STREAM_BUF_CRC;
+
+    /* The CRC unit works on the frame while the main loop goes on */
+    if ( CRC32_Start( frame, STREAM_pcb.buf[ idx ].size ) != CRC32_OK )
+    {
+        STREAM_pcb.buf[ idx ].state = STREAM_BUF_FREE;
+        STREAM_pcb.keyframe = 1U;
+    }
+    else
+    {
+        EVENT_Set( EVENT_DATA );
+    }
+}
+
+/*******************************************************************************
+ * @brief   Check if the next frame has to be coded without a reference
+ * @param   info, TCD_DATA_INFO_t: Layout of the next frame
+ * @param   ref, TCD_DATA_INFO_t: Layout of its reference
+ * @retval  1 for a keyframe, 0 if it can be coded against the reference
+ *
+ * The reference is only usable when it holds the same pixels, so any change
+ * of the windows or the binning starts with a keyframe.
+ ******************************************************************************/
+static uint32_t STREAM_IsKeyframeDue(const TCD_DATA_INFO_t *info, const TCD_DATA_INFO_t *ref)
+{
+    if ( (STREAM_pcb.keyframe != 0U) || (STREAM_pcb.sinceKeyframe + 1U >= STREAM_KEYFRAME_INTERVAL) )
+    {
+        return 1U;
+    }
+
+    if ( (info->pixelCount != ref->pixelCount) || (info->windows != ref->windows) ||
+         (info->bin != ref->bin) || (info->binEdges != ref->binEdges) )
+    {
+        return 1U;
+    }
+
+    if ( (memcmp( info->window, ref->window, info->windows * sizeof(info->window[ 0 ]) ) != 0) ||
+         (memcmp( info->binEdge, ref->binEdge, info->binEdges * sizeof(info->binEdge[ 0 ]) ) != 0) )
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+/****************************** END OF FILE ***********************************/
@@ -0,0 +1,391 @@
+/**
+ *******************************************************************************
+ * @file    : tx.c
+ * @author  : Dung Do Dang
+ * @version : V1.0.0
+ * @date    : 2026-10-17
+ * @brief   : Prioritized non-blocking transmit queue of the host UART
+ *
+ * The queue is shared between the main loop, which adds entries, and the
+ * transmit complete interrupt, which removes the sent entry and starts the
+ * next one. Both sides run with interrupts disabled while they change it.
+ * The interrupts are disabled only briefly, while an entry is picked and its
+ * DMA transfer is started.
+ *
+ *******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 Dung Do Dang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************
+ */
+
+/**
+ ***************************** Revision History ********************************
+ * 2026-10-17 revision 0: Initial version
+ *
+ *******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "main.h"
+#include "tx.h"
+#include "event.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TX_NO_ENTRY                     (0xFFU)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef enum
+{
+    TX_ENTRY_FREE = 0,
+    TX_ENTRY_QUEUED,
+    TX_ENTRY_SENDING
+} TX_ENTRY_STATE_t;
+
+typedef struct
+{
+    volatile TX_ENTRY_STATE_t state;
+    TX_PRIO_t prio;
+    const uint8_t *data;            /* Own message buffer or the caller's    */
+    uint16_t size;
+    uint32_t order;                 /* Sends equal priorities in order       */
+} TX_ENTRY_t;
+
+typedef struct
+{
+    TX_ENTRY_t entry[ TX_QUEUE_SIZE ];
+    volatile uint8_t active;        /* Entry being sent, or TX_NO_ENTRY      */
+    uint32_t order;
+    uint32_t overflows;             /* Transfers rejected with a full queue  */
+} TX_PCB_t;
+
+/* Private macros ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static UART_HandleTypeDef *TX_uart;
+static TX_PCB_t TX_pcb;
+
+/* Copies of the messages, read by the DMA from the non-cacheable RAM */
+static uint8_t TX_msg[ TX_QUEUE_SIZE ][ TX_MSG_SIZE ] DMA_BUFFER;
+
+/* Private function prototypes -----------------------------------------------*/
+static TX_ERR_t TX_Enqueue(TX_PRIO_t prio, const void *data, uint32_t size, uint8_t copy);
+static void TX_StartNext(void);
+
+/**
+ *******************************************************************************
+ *                        PUBLIC IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Initialize the transmit queue
+ * @param   huart, UART_HandleTypeDef: UART handle, TX DMA linked
+ * @retval  TX_OK on success or TX_ERR_t code
+ *
+ ******************************************************************************/
+TX_ERR_t TX_Init(UART_HandleTypeDef *huart)
+{
+    if ( huart == NULL )
+    {
+        return TX_ERR_NULL_POINTER;
+    }
+
+    memset( &TX_pcb, 0, sizeof(TX_pcb) );
+    TX_pcb.active = TX_NO_ENTRY;
+    TX_uart = huart;
+
+    return TX_OK;
+}
+
+/*******************************************************************************
+ * @brief   Start the next transfer if the UART is idle
+ * @param   None
+ * @retval  None
+ *
+ * Called from the main loop. Normally the transmit complete interrupt starts
+ * the next transfer, this only restarts the queue when the UART was busy
+ * with something else at that moment.
+ ******************************************************************************/
+void TX_Process(void)
+{
+    if ( (TX_uart == NULL) || (TX_pcb.active != TX_NO_ENTRY) )
+    {
+        return;
+    }
+
+    __disable_irq();
+    TX_StartNext();
+    __enable_irq();
+}
+
+/*******************************************************************************
+ * @brief   Queue a copy of a message
+ * @param   prio, TX_PRIO_t: Priority of the message
+ * @param   data, void: Message, may be reused when the function returns
+ * @param   size, uint32_t: Bytes in the message, 1 .. TX_MSG_SIZE
+ * @retval  TX_OK on success or TX_ERR_t code
+ *
+ ******************************************************************************/
+TX_ERR_t TX_Send(TX_PRIO_t prio, const void *data, uint32_t size)
+{
+    if ( size > TX_MSG_SIZE )
+    {
+        return TX_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    return TX_Enqueue( prio, data, size, 1U );
+}
+
+/*******************************************************************************
+ * @brief   Queue a buffer without copying it
+ * @param   prio, TX_PRIO_t: Priority of the buffer
+ * @param   data, void: Buffer, read by the DMA until TX_IsPending() returns 0
+ * @param   size, uint32_t: Bytes in the buffer, 1 .. 65535
+ * @retval  TX_OK on success or TX_ERR_t code
+ *
+ * The buffer must not be in cacheable RAM, see MPU_Config() in main.c.
+ ******************************************************************************/
+TX_ERR_t TX_SendBuffer(TX_PRIO_t prio, const void *data, uint32_t size)
+{
+    if ( size > UINT16_MAX )
+    {
+        return TX_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    return TX_Enqueue( prio, data, size, 0U );
+}
+
+/*******************************************************************************
+ * @brief   Check whether a buffer is still queued or being sent
+ * @param   data, void: Buffer passed to TX_SendBuffer()
+ * @retval  1 if the DMA may still read the buffer, 0 otherwise
+ *
+ ******************************************************************************/
+uint8_t TX_IsPending(const void *data)
+{
+    uint8_t i;
+
+    for ( i = 0U; i < TX_QUEUE_SIZE; i++ )
+    {
+        if ( (TX_pcb.entry[ i ].state != TX_ENTRY_FREE) &&
+             (TX_pcb.entry[ i ].data == (const uint8_t *) data) )
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/*******************************************************************************
+ * @brief   Check whether everything has been sent
+ * @param   None
+ * @retval  1 if the queue is empty and the last byte has left the UART
+ *
+ ******************************************************************************/
+uint8_t TX_IsIdle(void)
+{
+    uint8_t i;
+
+    for ( i = 0U; i < TX_QUEUE_SIZE; i++ )
+    {
+        if ( TX_pcb.entry[ i ].state != TX_ENTRY_FREE )
+        {
+            return 0U;
+        }
+    }
+
+    return (TX_uart->gState == HAL_UART_STATE_READY) ? 1U : 0U;
+}
+
+/*******************************************************************************
+ * @brief   Get the number of free queue entries
+ * @param   None
+ * @retval  Transfers that can be queued without an overflow
+ *
+ ******************************************************************************/
+uint32_t TX_GetFree(void)
+{
+    uint32_t free = 0U;
+    uint8_t i;
+
+    for ( i = 0U; i < TX_QUEUE_SIZE; i++ )
+    {
+        if ( TX_pcb.entry[ i ].state == TX_ENTRY_FREE )
+        {
+            free++;
+        }
+    }
+
+    return free;
+}
+
+/*******************************************************************************
+ * @brief   Get the number of transfers rejected because the queue was full
+ * @param   None
+ * @retval  Number of rejected transfers
+ *
+ ******************************************************************************/
+uint32_t TX_GetOverflows(void)
+{
+    return TX_pcb.overflows;
+}
+
+/*******************************************************************************
+ * @brief   Transmit complete callback of the HAL, starts the next transfer
+ * @param   huart, UART_HandleTypeDef: UART handle
+ * @retval  None
+ *
+ * Called in the USART interrupt after the last byte has been sent.
+ ******************************************************************************/
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if ( (huart != TX_uart) || (TX_pcb.active == TX_NO_ENTRY) )
+    {
+        return;
+    }
+
+    __disable_irq();
+    TX_pcb.entry[ TX_pcb.active ].state = TX_ENTRY_FREE;
+    TX_pcb.active = TX_NO_ENTRY;
+    TX_StartNext();
+    __enable_irq();
+
+    /* Frame buffers may be free now, and the link may wait for an empty queue */
+    EVENT_Set( EVENT_TX );
+}
+
+/**
+ *******************************************************************************
+ *                        PRIVATE IMPLEMENTATION SECTION
+ *******************************************************************************
+ */
+
+/*******************************************************************************
+ * @brief   Add a transfer to the queue and start it if the UART is idle
+ * @param   prio, TX_PRIO_t: Priority of the transfer
+ * @param   data, void: Data to send
+ * @param   size, uint32_t: Bytes to send
+ * @param   copy, uint8_t: 1 to copy the data into the queue
+ * @retval  TX_OK on success or TX_ERR_t code
+ *
+ ******************************************************************************/
+static TX_ERR_t TX_Enqueue(TX_PRIO_t prio, const void *data, uint32_t size, uint8_t copy)
+{
+    uint8_t i;
+
+    if ( TX_uart == NULL )
+    {
+        return TX_ERR_NOT_INITIALIZED;
+    }
+    if ( data == NULL )
+    {
+        return TX_ERR_NULL_POINTER;
+    }
+    if ( (prio >= TX_NUM_PRIO) || (size == 0U) )
+    {
+        return TX_ERR_PARAM_OUT_OF_RANGE;
+    }
+
+    /* Only the main loop takes free entries, the interrupt only releases them */
+    for ( i = 0U; i < TX_QUEUE_SIZE; i++ )
+    {
+        if ( TX_pcb.entry[ i ].state == TX_ENTRY_FREE )
+        {
+            break;
+        }
+    }
+    if ( i == TX_QUEUE_SIZE )
+    {
+        TX_pcb.overflows++;
+        return TX_ERR_QUEUE_FULL;
+    }
+
+    if ( copy != 0U )
+    {
+        memcpy( TX_msg[ i ], data, size );
+        data = TX_msg[ i ];
+    }
+
+    TX_pcb.entry[ i ].prio = prio;
+    TX_pcb.entry[ i ].data = (const uint8_t *) data;
+    TX_pcb.entry[ i ].size = (uint16_t) size;
+
+    __disable_irq();
+    TX_pcb.entry[ i ].order = TX_pcb.order++;
+    TX_pcb.entry[ i ].state = TX_ENTRY_QUEUED;
+    if ( TX_pcb.active == TX_NO_ENTRY )
+    {
+        TX_StartNext();
+    }
+    __enable_irq();
+
+    return TX_OK;
+}
+
+/*******************************************************************************
+ * @brief   Start the DMA transfer of the first queued entry
+ * @param   None
+ * @retval  None
+ *
+ * Called with the interrupts disabled and no transfer running.
+ ******************************************************************************/
+static void TX_StartNext(void)
+{
+    uint8_t next = TX_NO_ENTRY;
+    uint8_t i;
+
+    for ( i = 0U; i < TX_QUEUE_SIZE; i++ )
+    {
+        TX_ENTRY_t *e = &TX_pcb.entry[ i ];
+
+        if ( (e->state == TX_ENTRY_QUEUED) &&
+             ((next == TX_NO_ENTRY) ||
+              (e->prio < TX_pcb.entry[ next ].prio) ||
+              ((e->prio == TX_pcb.entry[ next ].prio) &&
+               ((int32_t) (e->order - TX_pcb.entry[ next ].order) < 0))) )
+        {
+            next = i;
+        }
+    }
+
+    if ( next == TX_NO_ENTRY )
+    {
+        return;
+    }
+
+    /* Marked first, the transfer can complete before the call returns */
+    TX_pcb.entry[ next ].state = TX_ENTRY_SENDING;
+    TX_pcb.active = next;
+
+    if ( HAL_UART_Transmit_DMA( TX_uart, (uint8_t *) TX_pcb.entry[ next ].data,
+                                TX_pcb.entry[ next ].size ) != HAL_OK )
+    {
+        /* Retried by TX_Process() */
+        TX_pcb.entry[ next ].state = TX_ENTRY_QUEUED;
+        TX_pcb.active = TX_NO_ENTRY;
+    }
+}
+/****************************** END OF FILE ***********************************/